@@ -0,0 +1,1569 @@
+/**
+ * @brief 主机检查程序
+ * @details 用法：
+ *            hostcheck bench [--check] [--baseline 文件] [--tolerance 容差] [--counts-only] [--write 文件]
+ *              --check 与默认基线BENCH_BASELINE_PATH比对，--counts-only只比对count不比对耗时
+ *            hostcheck pty    按115200/921600波特率折算的速率经pty收帧，丢帧时失败
+ *            hostcheck udp [--gateways N] [--seconds S] [--rate R] [--min-complete 百分比]
+ *              启动N个网关进程经UDP mesh负载测试，送达率低于百分比（默认90）时失败
+ *            hostcheck replay [文件] [--realtime]
+ *              回放流量记录并逐帧比对发出的帧；不给文件时先在虚拟时钟下录制一段合成会话，
+ *              再分别尽快回放和按记录时间回放，结果都须与记录一致
+ *            hostcheck startup
+ *              测量复位到串口就绪、首个从机帧、开始组网、入网、首条mesh消息的时间（UDP mesh，实时运行），
+ *              首个从机帧晚于开始组网或超时未收到mesh消息时失败
+ *            hostcheck alloc
+ *              预热后进入稳态（MemTrack::setSteadyState），热路径（串口接收/解析、命令下发）发生分配时失败
+ *            hostcheck block
+ *              mesh块读/块写请求经串口往返后原样回给请求节点；按线路时间比较块读与单命令的寄存器吞吐
+ *            hostcheck telemetry
+ *              从机状态历史：近期全分辨率、较早降采样为min/max/last桶，TLMQ范围查询的应答内容和长度
+ *            hostcheck shard
+ *              从机地址分片：网关加入/离开只移动相关地址，主网关离开后副本接管，超时未公告的网关被移除；
+ *              再经UDP mesh测量1、2、4个网关的命令吞吐，须随网关数增长
+ *            hostcheck flow
+ *              安全反转流程在虚拟从机总线上：停止→确认停止→反转→确认反转、未应答超时、收到新命令让出、
+ *              应答状态不符时结束；流程在等待的应答到达的同一轮主循环中恢复；流程表装满FLOW_MAX个流程并报告占用内存
+ *            hostcheck rs485
+ *              RS-485方向控制：按推算时间加一个位的余量释放DE；UART发送晚于推算（FIFO未空）时推后释放，
+ *              DE不早于最后一个停止位离开线路
+ *            hostcheck channel
+ *              入网信道缓存：首次启动全信道扫描并把信道和上级BSSID保存到模拟flash，重启后先在缓存信道上入网；
+ *              mesh换了信道时缓存信道超时回退到全信道扫描并更新缓存
+ *            hostcheck liveness
+ *              节点存活：失联超时随心跳到达抖动自适应（准时的节点检测更快，抖动/丢心跳的节点不误判），
+ *              只在本机一个间隔内没有广播时才发显式心跳，拓扑变化时心跳间隔缩短、稳定后放宽
+ *            hostcheck uplink
+ *              从机状态上行：未变化的状态不发送，同一窗口的变化合并为一条增量，新订阅者立即收到快照，
+ *              单播失败的订阅者被移除；上行字节数须远小于逐帧转发
+ *            hostcheck trace
+ *              非管理节点不能经mesh开始记录；APP::addAdmin配置的管理节点开始/停止记录后收到TRC数据
+ *            hostcheck group
+ *              非管理节点的GRP组配置被丢弃；APP::addAdmin配置的管理节点配置组后，组命令下发到每个成员
+ *            hostcheck admission
+ *              一个控制节点突发命令：超出的被拒绝并只回一次忙消息，其他节点仍被准入，已准入命令的排队时延有界
+ *          返回0表示通过
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../src/app/benchmark.hpp"
+#include "../src/app/loadtest.hpp"
+#include "../src/app/tracereplay.hpp"
+#include "../src/bsp/memtrack.hpp"
+#include "../src/bsp/slavebus.hpp"
+#include <unistd.h>
+
+#define HOSTCHECK_REPLAY_FRAMES 8 ///< 合成会话的命令帧数
+#define HOSTCHECK_ALLOC_PASSES 200 ///< 分配检查预热和稳态阶段各自的命令数
+#define HOSTCHECK_ALLOC_GAP_US 50000 ///< 分配检查中相邻命令的间隔（微秒），不触发准入拒绝
+#define HOSTCHECK_STARTUP_TIMEOUT 5000 ///< 启动测量等待首条mesh消息的最长时间（毫秒）
+#define HOSTCHECK_STARTUP_PING 20 ///< 启动测量中对端节点的广播间隔（毫秒）
+#define HOSTCHECK_FLOOD 12 ///< 准入检查中一个控制节点突发的命令数
+#define HOSTCHECK_BLOCK_ROUNDS 50 ///< 块读吞吐测量的请求数
+#define HOSTCHECK_BLOCK_MIN_GAIN 3 ///< 块读吞吐至少为单命令的倍数
+#define HOSTCHECK_TLM_SECONDS 200 ///< 状态历史检查中从机每秒一帧状态的时长
+#define HOSTCHECK_DWELL_MS 300 ///< 信道缓存检查中每个信道的模拟扫描停留时间（毫秒）
+#define HOSTCHECK_CHANNELS 13 ///< 全信道扫描的信道数
+#define HOSTCHECK_PARENT 9 ///< 信道缓存检查中上级节点的节点ID
+#define HOSTCHECK_SHARD_RATE 400 ///< 分片吞吐测量的命令速率（条/秒），高于单个网关的准入速率
+#define HOSTCHECK_SHARD_SECONDS 2 ///< 分片吞吐测量每种网关数的发送时长（秒）
+#define HOSTCHECK_LIVE_ROUNDS 40 ///< 存活检查中每个节点的心跳轮数
+#define HOSTCHECK_LIVE_JITTER 2000 ///< 存活检查中抖动节点心跳的最大迟到时间（毫秒）
+#define HOSTCHECK_UPLINK_FRAMES 1800 ///< 状态上行检查中4个从机轮流上报的帧数（每10毫秒一帧，跨过一次周期快照）
+#define HOSTCHECK_UPLINK_HOLD 400 ///< 状态上行检查中从机状态保持不变的帧数，变化时刻避开周期快照
+#define HOSTCHECK_UPLINK_MIN_GAIN 50 ///< 逐帧转发字节数至少为上行字节数的倍数
+#define HOSTCHECK_RS485_STALL 2500 ///< 方向控制检查中UART迟发的时间（微秒），模拟中断延迟
+#define HOSTCHECK_RS485_STEP 10 ///< 方向控制检查的轮询步长（微秒）
+
+/**
+ * @brief 检查条件，失败时打印并计数
+ */
+#define EXPECT(cond) do { if (!(cond)) { printf("  failed: %s (line %d)\n", #cond, __LINE__); failures++; } } while (0)
+
+/**
+ * @brief 基准测试：打印结果，可写出JSON、与基线比对
+ */
+static int runBench(int argc, char **argv)
+{
+    const char *baseline = nullptr;
+    const char *output = nullptr;
+    double tolerance = BENCH_TOLERANCE;
+    bool counts_only = false;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            baseline = BENCH_BASELINE_PATH;
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--counts-only") == 0) {
+            counts_only = true;
+        } else {
+            fprintf(stderr, "bench: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    Benchmark bench;
+    bench.runAll();
+    bench.report(stdout);
+    if (output != nullptr) {
+        FILE *f = fopen(output, "w");
+        if (f == nullptr) {
+            fprintf(stderr, "bench: cannot write %s\n", output);
+            return 1;
+        }
+        bench.writeJson(f);
+        fclose(f);
+    }
+    if (baseline == nullptr) {
+        return 0;
+    }
+    if (counts_only) {
+        tolerance = 1e9;//只比对count
+    }
+    bool ok = bench.checkBaseline(baseline, tolerance, stdout);
+    printf("baseline %s: %s\n", baseline, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief pty串口吞吐测试
+ */
+static int runPty()
+{
+    Benchmark bench;
+    bool ok = bench.serialThroughput();
+    bench.report(stdout);
+    printf("pty: %s\n", ok ? "ok" : "FAILED (frames lost)");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief 多进程UDP mesh负载测试
+ */
+static int runUdp(int argc, char **argv)
+{
+    LOAD_CONFIG config = {LOAD_GATEWAYS, LOAD_SECONDS, LOAD_RATE};
+    double min_complete = 90;
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--gateways") == 0) {
+            config.gateways = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            config.seconds = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            config.rate = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--min-complete") == 0) {
+            min_complete = atof(argv[i + 1]);
+        } else {
+            fprintf(stderr, "udp: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (argc % 2 != 0 || config.gateways == 0 || config.rate == 0) {
+        fprintf(stderr, "udp: bad options\n");
+        return 2;
+    }
+
+    UdpLoadTest test(config);
+    bool ok = test.run();
+    test.report(stdout);
+    ok = ok && test.getSent() > 0 && test.getCompleted() * 100.0 >= test.getSent() * min_complete;
+    printf("udp: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief 流量记录回放检查
+ */
+static int runReplay(int argc, char **argv)
+{
+    const char *path = nullptr;
+    bool realtime = false;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (argv[i][0] != '-' && path == nullptr) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "replay: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    char sample[64];
+    if (path == nullptr) {
+        snprintf(sample, sizeof(sample), "/tmp/hostcheck_%d.trc", (int)getpid());
+        if (!TraceReplay::recordSample(sample, HOSTCHECK_REPLAY_FRAMES)) {
+            fprintf(stderr, "replay: cannot write %s\n", sample);
+            return 1;
+        }
+    }
+
+    TraceReplay replay;
+    bool ok = replay.load(path != nullptr ? path : sample);
+    if (!ok) {
+        fprintf(stderr, "replay: cannot load %s\n", path != nullptr ? path : sample);
+    } else if (path != nullptr) {
+        replay.run(realtime);
+        replay.report(stdout);
+        ok = replay.isEquivalent();
+    } else {
+        replay.run(false);
+        replay.report(stdout);
+        ok = replay.isEquivalent();
+        replay.run(true);
+        replay.report(stdout);
+        ok = ok && replay.isEquivalent();
+        unlink(sample);
+    }
+    printf("replay: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief 不分配内存的测试串口：收发都用固定缓冲区，发出的字节只计数
+ * @details ReplayPort用std::string保存发出的帧，写入本身就会分配，不能用于分配检查
+ */
+class FixedPort : public SerialPort {
+public:
+    bool begin(uint32_t /*baud*/) override { return true; }
+    int available() override { return (int)(rx_len - rx_pos); }
+    int read() override { return rx_pos < rx_len ? rx[rx_pos++] : -1; }
+    size_t read(uint8_t *buf, size_t len) override
+    {
+        size_t n = rx_len - rx_pos < len ? rx_len - rx_pos : len;
+        memcpy(buf, rx + rx_pos, n);
+        rx_pos += n;
+        return n;
+    }
+    size_t write(const uint8_t * /*buf*/, size_t len) override
+    {
+        tx_bytes += len;
+        return len;
+    }
+    void feed(const uint8_t *data, size_t len)
+    {
+        memmove(rx, rx + rx_pos, rx_len - rx_pos);
+        rx_len -= rx_pos;
+        rx_pos = 0;
+        if (len > sizeof(rx) - rx_len) len = sizeof(rx) - rx_len;
+        memcpy(rx + rx_len, data, len);
+        rx_len += len;
+    }
+    size_t tx_bytes = 0;
+
+private:
+    uint8_t rx[256];
+    size_t rx_len = 0;
+    size_t rx_pos = 0;
+};
+
+/**
+ * @brief 按虚拟时钟发送的测试UART
+ * @details 写入的字节先进入发送FIFO，stall_us之后才开始按字符时间逐个发出，
+ *          txPending()报告FIFO中尚未开始移位的字节数
+ */
+class LateUart : public FixedPort {
+public:
+    explicit LateUart(uint32_t stall_us) : stall_us(stall_us) {}
+    size_t write(const uint8_t * /*buf*/, size_t len) override
+    {
+        tx_start = Clock::micros64() + stall_us;
+        queued = len;
+        return len;
+    }
+    uint16_t txPending() override
+    {
+        uint64_t now = Clock::micros64();
+        if (now < tx_start) {
+            return (uint16_t)queued;
+        }
+        uint64_t sent = (now - tx_start) / char_us;
+        return sent >= queued ? 0 : (uint16_t)(queued - sent - 1);
+    }
+    uint64_t wireEnd() const { return tx_start + queued * char_us; }  ///< 最后一个停止位离开线路的时间
+    uint32_t char_us = 1;  ///< 每字符线路时间（微秒）
+
+private:
+    uint32_t stall_us;
+    uint64_t tx_start = 0;
+    size_t queued = 0;
+};
+
+/**
+ * @brief 记录发出消息的mesh传输层，可让发往指定节点的单播失败
+ */
+class CaptureTransport : public MeshTransport {
+public:
+    bool init() override { return true; }
+    void update() override {}
+    bool sendBroadcast(String &msg) override { return record(0, msg); }
+    bool sendSingle(uint32_t dest, String &msg) override { return dest != fail_dest && record(dest, msg); }
+    uint32_t getNodeId() override { return node_id; }
+    std::list<uint32_t> getNodeList() override { return nodes; }
+    uint32_t getNodeTime() override { return (uint32_t)Clock::micros64(); }
+
+    void deliver(uint32_t from, String &msg) { if (receivedCb) receivedCb(from, msg); }
+    void drop(uint32_t node) { if (droppedCb) droppedCb(node); }
+    void changed() { if (changedCb) changedCb(); }
+
+    /**
+     * @brief 统计发往dest（0为广播）、以prefix开头的消息数
+     */
+    uint32_t count(uint32_t dest, const char *prefix) const
+    {
+        uint32_t n = 0;
+        for (const auto &m : sent) {
+            if (m.first == dest && m.second.compare(0, strlen(prefix), prefix) == 0) n++;
+        }
+        return n;
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> sent; ///< 发往的节点（0为广播）和消息
+    size_t bytes = 0;       ///< 发出的总字节数
+    uint32_t fail_dest = 0; ///< 发往该节点的单播失败
+    uint32_t node_id = 1;
+    std::list<uint32_t> nodes;
+
+private:
+    bool record(uint32_t dest, String &msg)
+    {
+        sent.push_back(std::make_pair(dest, std::string(msg.c_str(), msg.length())));
+        bytes += msg.length();
+        return true;
+    }
+};
+
+/**
+ * @brief 编码一条发往从机的命令帧（控制节点格式）
+ */
+static String commandFrame(uint8_t addr, uint8_t cmd)
+{
+    uint8_t payload[MotorFrame::PAYLOAD_LEN] = {0};
+    uint8_t frame[MotorFrame::FRAME_SIZE];
+    payload[MOTOR_FIELD_ADDR] = addr;
+    payload[MOTOR_FIELD_FUNC] = 0x03;
+    payload[MOTOR_FIELD_COUNT] = 0x01;
+    payload[MOTOR_FIELD_REG] = addr;
+    payload[MOTOR_FIELD_CMD] = cmd;
+    MotorFrame::encode(frame, payload);
+    String msg;
+    msg.concat((const char *)frame, MotorFrame::FRAME_SIZE);
+    return msg;
+}
+
+/**
+ * @brief 按1毫秒步进虚拟时钟运行主循环
+ */
+static void runFor(APP &app, VirtualClock &clock, uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++) {
+        app.modbus_exec();
+        app.exec();
+        clock.advance(1000);
+    }
+}
+
+/**
+ * @brief 准入控制检查
+ * @details 虚拟从机总线上，节点5一次发出HOSTCHECK_FLOOD条命令，节点6随后发2条：
+ *          节点5只准入突发额度，其余拒绝且同一窗口只回一次BUSY；节点6不受节点5影响；
+ *          所有准入的命令在 全局突发/全局速率 内下发到串口
+ */
+static int runAdmission()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        SLAVEBUS_CONFIG config = {SERIAL_BAUD, 8, 1000, 2000, 0, 0, 7, 0};
+        VirtualSlaveBus bus(config);
+        CaptureTransport transport;
+        APP app(&bus, &transport);
+        app.begin();
+        app.exec();
+        Admission &adm = app.getMesh().getAdmission();
+        for (int i = 0; i < HOSTCHECK_FLOOD; i++) {
+            String msg = commandFrame(1 + i % 4, SLAVE_CMD_READ);
+            transport.deliver(5, msg);
+        }
+        uint32_t flood_admitted = adm.getAdmitted();
+        for (int i = 0; i < 2; i++) {
+            String msg = commandFrame(5 + i, SLAVE_CMD_READ);
+            transport.deliver(6, msg);
+        }
+        uint32_t admitted = adm.getAdmitted();
+        uint32_t bound_ms = ADMISSION_GLOBAL_BURST * 1000 / adm.getGlobalRate();
+        uint32_t start = Clock::millis();
+        while (app.getCmdCounters(SLAVE_CMD_READ).sent < admitted && Clock::millis() - start < 10 * bound_ms) {
+            runFor(app, clock, 1);
+        }
+        uint32_t drain_ms = Clock::millis() - start;
+        printf("global rate     : %u cmd/s\n", (unsigned)adm.getGlobalRate());
+        printf("node 5 admitted : %u of %d\n", (unsigned)flood_admitted, HOSTCHECK_FLOOD);
+        printf("node 6 admitted : %u of 2\n", (unsigned)(admitted - flood_admitted));
+        printf("busy to node 5  : %u\n", (unsigned)transport.count(5, "BUSY_"));
+        printf("drain           : %u ms (bound %u ms)\n", (unsigned)drain_ms, (unsigned)bound_ms);
+        EXPECT(flood_admitted == ADMISSION_NODE_BURST);
+        EXPECT(adm.getRejected() == HOSTCHECK_FLOOD - ADMISSION_NODE_BURST);
+        EXPECT(transport.count(5, "BUSY_") == 1);
+        EXPECT(admitted - flood_admitted == 2);
+        EXPECT(transport.count(6, "BUSY_") == 0);
+        EXPECT(app.getCmdCounters(SLAVE_CMD_READ).sent == admitted);
+        EXPECT(drain_ms <= bound_ms);
+        EXPECT(bus.getCommands() == admitted);
+
+        // 令牌恢复后节点5重新被准入
+        runFor(app, clock, 1000);
+        String msg = commandFrame(2, SLAVE_CMD_READ);
+        transport.deliver(5, msg);
+        EXPECT(adm.getAdmitted() == admitted + 1);
+    }
+    Clock::setSource(nullptr);
+    printf("admission: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 编码一帧从机状态应答
+ */
+static void statusFrame(uint8_t addr, uint8_t sta, uint8_t *frame)
+{
+    uint8_t payload[MotorFrame::PAYLOAD_LEN] = {addr, 0x03, 0x01, addr, sta, SLAVE_CMD_READ, 0x00};
+    MotorFrame::encode(frame, payload);
+}
+
+/**
+ * @brief 串口字节的线路时间（微秒，每字节10位）
+ */
+static uint32_t lineUs(size_t bytes)
+{
+    return (uint32_t)(bytes * 10 * 1000000ULL / SERIAL_BAUD);
+}
+
+/**
+ * @brief 从机侧：应答一条块读写请求（读返回start+i作为寄存器值）
+ * @return 应答帧长度，请求无效返回0
+ */
+static uint8_t blockAnswer(const std::string &request, uint8_t *reply)
+{
+    const uint8_t *req = (const uint8_t *)request.data();
+    if (request.size() < SlaveFrame::frameSize(SlaveFrame::LEN_POS + MODBUS_BLOCK_HDR) || !SlaveFrame::decode(req)) {
+        return 0;
+    }
+    const uint8_t *p = req + SlaveFrame::PAYLOAD_POS;
+    uint8_t payload[SlaveFrame::MAX_PAYLOAD];
+    memcpy(payload, p, MODBUS_BLOCK_HDR);
+    uint8_t len = MODBUS_BLOCK_HDR;
+    if (p[MOTOR_FIELD_FUNC] == MODBUS_FN_READ_REGS) {
+        for (uint8_t i = 0; i < p[MOTOR_FIELD_COUNT]; i++) {
+            uint16_t v = p[MOTOR_FIELD_REG] + i;
+            payload[len++] = v >> 8;
+            payload[len++] = v & 0xFF;
+        }
+    }
+    return SlaveFrame::encode(reply, payload, len);
+}
+
+/**
+ * @brief 块读写检查
+ * @details mesh发来的块读、块写请求各一条：检查发到串口的请求帧、从机应答经mesh回给请求节点的内容。
+ *          再用MODBUS直接测量：按线路时间推进虚拟时钟，块读每次MODBUS_BLOCK_MAX_REGS个寄存器，
+ *          与逐个寄存器的单命令一问一答比较每秒寄存器数
+ */
+static int runBlock()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        ReplayPort port;
+        CaptureTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();
+
+        uint8_t read_req[] = {'B', 'L', 'K', 3, MODBUS_FN_READ_REGS, 10, 8};
+        String msg;
+        msg.concat((const char *)read_req, sizeof(read_req));
+        transport.deliver(4, msg);
+        app.received_handle();
+        EXPECT(port.tx.size() == 1);
+        uint8_t reply[MAX_MODBUS_FRAME];
+        uint8_t n = port.tx.empty() ? 0 : blockAnswer(port.tx.back(), reply);
+        EXPECT(n == SlaveFrame::frameSize(SlaveFrame::LEN_POS + MODBUS_BLOCK_HDR + 16));
+        port.feed(reply, n);
+        runFor(app, clock, 20);
+        EXPECT(transport.count(4, "BLK") == 1);
+        if (transport.count(4, "BLK") == 1) {
+            const std::string &r = transport.sent.back().second;
+            EXPECT(r.size() == MESH_BLOCK_HDR + 16);
+            EXPECT((uint8_t)r[3] == 3 && (uint8_t)r[5] == 10 && (uint8_t)r[6] == 8);
+            EXPECT((uint8_t)r[7] == 0 && (uint8_t)r[8] == 10 && (uint8_t)r[22] == 17);//寄存器10..17
+        }
+
+        uint8_t write_req[] = {'B', 'L', 'K', 3, MODBUS_FN_WRITE_REGS, 20, 2, 0x12, 0x34, 0x56, 0x78};
+        String wmsg;
+        wmsg.concat((const char *)write_req, sizeof(write_req));
+        transport.deliver(4, wmsg);
+        app.received_handle();
+        EXPECT(port.tx.size() == 2);
+        if (port.tx.size() == 2) {
+            const uint8_t *p = (const uint8_t *)port.tx[1].data() + SlaveFrame::PAYLOAD_POS;
+            EXPECT(p[MOTOR_FIELD_FUNC] == MODBUS_FN_WRITE_REGS && p[MOTOR_FIELD_COUNT] == 2 && p[MOTOR_FIELD_REG] == 20);
+            EXPECT(p[4] == 0x12 && p[5] == 0x34 && p[6] == 0x56 && p[7] == 0x78);
+            n = blockAnswer(port.tx[1], reply);
+            port.feed(reply, n);
+        }
+        runFor(app, clock, 20);
+        EXPECT(transport.count(4, "BLK") == 2);
+        EXPECT(transport.sent.back().second.size() == MESH_BLOCK_HDR);
+    }
+
+    uint64_t block_us = 0;
+    uint64_t single_us = 0;
+    uint32_t block_regs = 0;
+    uint32_t single_regs = 0;
+    {
+        ReplayPort port;
+        MODBUS bus(&port);
+        bus.begin();
+        for (int i = 0; i < HOSTCHECK_BLOCK_ROUNDS; i++) {
+            uint64_t t0 = Clock::micros64();
+            bus.read_block(3, 0, MODBUS_BLOCK_MAX_REGS);
+            clock.advance(lineUs(port.tx.back().size()));
+            uint8_t reply[MAX_MODBUS_FRAME];
+            uint8_t n = blockAnswer(port.tx.back(), reply);
+            port.feed(reply, n);
+            clock.advance(lineUs(n));
+            bus.serialEvent_callback();
+            bus.parseModbusFrame();
+            MODBUS_BLOCK got;
+            if (bus.getBlockReply(&got)) block_regs += got.count;
+            block_us += Clock::micros64() - t0;
+        }
+        for (int i = 0; i < HOSTCHECK_BLOCK_ROUNDS * MODBUS_BLOCK_MAX_REGS; i++) {
+            uint64_t t0 = Clock::micros64();
+            bus.set_slave(3, SLAVE_CMD_READ);
+            clock.advance(lineUs(port.tx.back().size()));
+            uint8_t frame[MotorFrame::FRAME_SIZE];
+            statusFrame(3, G_SERIAL_STOP, frame);
+            port.feed(frame, sizeof(frame));
+            clock.advance(lineUs(sizeof(frame)));
+            bus.serialEvent_callback();
+            if (bus.parseModbusFrame() != 0) single_regs++;
+            single_us += Clock::micros64() - t0;
+        }
+    }
+    Clock::setSource(nullptr);
+    uint32_t block_rate = block_us ? (uint32_t)(block_regs * 1000000ULL / block_us) : 0;
+    uint32_t single_rate = single_us ? (uint32_t)(single_regs * 1000000ULL / single_us) : 0;
+    printf("block read      : %u regs/s (%u regs per request)\n", (unsigned)block_rate, (unsigned)MODBUS_BLOCK_MAX_REGS);
+    printf("single command  : %u regs/s\n", (unsigned)single_rate);
+    EXPECT(block_regs == HOSTCHECK_BLOCK_ROUNDS * MODBUS_BLOCK_MAX_REGS);
+    EXPECT(single_regs == block_regs);
+    EXPECT(block_rate >= HOSTCHECK_BLOCK_MIN_GAIN * single_rate);
+    printf("block: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 发送一条TLMQ查询
+ * @param since 起始时长（毫秒，距现在）
+ * @param until 结束时长（毫秒，距现在）
+ */
+static void queryTelemetry(CaptureTransport &transport, uint32_t from, uint8_t addr, uint32_t since, uint32_t until)
+{
+    uint8_t q[13] = {'T', 'L', 'M', 'Q', addr};
+    for (uint8_t i = 0; i < 4; i++) {
+        q[5 + i] = since >> (8 * i);
+        q[9 + i] = until >> (8 * i);
+    }
+    String msg;
+    msg.concat((const char *)q, sizeof(q));
+    transport.deliver(from, msg);
+}
+
+/**
+ * @brief 从机状态历史检查
+ * @details 从机2每秒上报一次状态（0,1,2循环），HOSTCHECK_TLM_SECONDS秒后查询全部历史：
+ *          最近TELEMETRY_FINE个样本逐个返回且值正确，更早的时间段以桶返回且min/max覆盖0..2，
+ *          整个应答不超过TELEMETRY_MAX_REPLY；再查询最近5秒只返回原始样本，查询未知从机不应答
+ */
+static int runTelemetry()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        ReplayPort port;
+        CaptureTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();
+        uint8_t frame[MotorFrame::FRAME_SIZE];
+        for (int i = 0; i < HOSTCHECK_TLM_SECONDS; i++) {
+            statusFrame(2, i % 3, frame);
+            port.feed(frame, sizeof(frame));
+            runFor(app, clock, 2);
+            clock.advance(998 * 1000);
+        }
+        EXPECT(app.getTelemetry().getSamples() == HOSTCHECK_TLM_SECONDS);
+
+        queryTelemetry(transport, 6, 2, HOSTCHECK_TLM_SECONDS * 1000, 0);
+        EXPECT(transport.count(6, TELEMETRY_REPLY_TAG) == 1);
+        if (transport.count(6, TELEMETRY_REPLY_TAG) == 1) {
+            const uint8_t *r = (const uint8_t *)transport.sent.back().second.data() + 4;
+            size_t len = transport.sent.back().second.size() - 4;
+            uint8_t nbucket = r[1];
+            uint8_t nfine = r[2];
+            printf("full history    : %u buckets, %u samples, %zu bytes (raw %d samples)\n",
+                   (unsigned)nbucket, (unsigned)nfine, len, HOSTCHECK_TLM_SECONDS);
+            EXPECT(r[0] == 2);
+            EXPECT(len <= TELEMETRY_MAX_REPLY);
+            EXPECT(len == 3 + nbucket * 5U + nfine * 3U);
+            EXPECT(nfine == TELEMETRY_FINE);
+            EXPECT(nbucket > 0);
+            uint8_t lo = 0xFF, hi = 0;
+            for (uint8_t i = 0; i < nbucket; i++) {
+                const uint8_t *b = r + 3 + i * 5;
+                if (b[2] < lo) lo = b[2];
+                if (b[3] > hi) hi = b[3];
+            }
+            EXPECT(lo == 0 && hi == 2);
+            const uint8_t *newest = r + 3 + nbucket * 5 + (nfine - 1) * 3;
+            EXPECT(newest[2] == (HOSTCHECK_TLM_SECONDS - 1) % 3);
+        }
+
+        queryTelemetry(transport, 6, 2, 5000, 0);
+        EXPECT(transport.count(6, TELEMETRY_REPLY_TAG) == 2);
+        if (transport.count(6, TELEMETRY_REPLY_TAG) == 2) {
+            const uint8_t *r = (const uint8_t *)transport.sent.back().second.data() + 4;
+            printf("last 5 s        : %u buckets, %u samples\n", (unsigned)r[1], (unsigned)r[2]);
+            EXPECT(r[1] == 0 && r[2] == 5);
+        }
+
+        queryTelemetry(transport, 6, 9, 5000, 0);
+        EXPECT(transport.count(6, TELEMETRY_REPLY_TAG) == 2);
+    }
+    Clock::setSource(nullptr);
+    printf("telemetry: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 记录全部256个地址的归属网关
+ */
+static void shardOwners(const ShardMap &map, uint32_t *owners)
+{
+    for (uint16_t addr = 0; addr < 256; addr++) {
+        owners[addr] = map.owner((uint8_t)addr);
+    }
+}
+
+/**
+ * @brief 从机地址分片检查
+ * @details 本机100与网关101~103都能到达全部地址：网关104加入后，归属变化的地址都归104；
+ *          网关102离开后，归属变化的恰好是原来归102的地址。
+ *          副本：地址1~32只有101和102能到达（同一总线接了两个网关），主网关离开后由另一个接管，其他地址不变。
+ *          超时：101在0时刻、102在10秒时公告，expire只移除超过SHARD_TIMEOUT未公告的101。
+ *          最后按HOSTCHECK_SHARD_RATE经UDP mesh分别给1、2、4个网关发命令，每个网关接自己的虚拟从机总线，比较完成的命令数/秒
+ */
+static int runShard()
+{
+    int failures = 0;
+    uint8_t all[SHARD_REACH_BYTES];
+    memset(all, 0xFF, sizeof(all));
+    uint32_t before[256];
+    uint32_t after[256];
+    {
+        ShardMap map;
+        map.setSelf(100);
+        for (uint16_t addr = 0; addr < 256; addr++) {
+            map.setLocalReach((uint8_t)addr);
+        }
+        for (uint32_t gw = 101; gw <= 103; gw++) {
+            map.announce(gw, all, 0);
+        }
+        shardOwners(map, before);
+        map.announce(104, all, 0);
+        shardOwners(map, after);
+        uint16_t moved = 0;
+        uint16_t stray = 0;
+        for (uint16_t addr = 0; addr < 256; addr++) {
+            if (after[addr] != before[addr]) {
+                moved++;
+                if (after[addr] != 104) stray++;
+            }
+        }
+        printf("join            : %u of 256 addresses moved to the new gateway\n", (unsigned)moved);
+        EXPECT(moved > 0 && moved < 256 / 2);
+        EXPECT(stray == 0);
+
+        memcpy(before, after, sizeof(before));
+        map.remove(102);
+        shardOwners(map, after);
+        moved = 0;
+        stray = 0;
+        for (uint16_t addr = 0; addr < 256; addr++) {
+            if (after[addr] != before[addr]) moved++;
+            if ((after[addr] != before[addr]) != (before[addr] == 102)) stray++;
+            if (after[addr] == 102) stray++;
+        }
+        printf("leave           : %u of 256 addresses reassigned\n", (unsigned)moved);
+        EXPECT(moved > 0);
+        EXPECT(stray == 0);
+        EXPECT(map.getReassigned() == 1);
+    }
+    {
+        ShardMap map;
+        map.setSelf(100);
+        uint8_t shared[SHARD_REACH_BYTES] = {0};
+        uint8_t other[SHARD_REACH_BYTES] = {0};
+        for (uint16_t addr = 1; addr < 256; addr++) {
+            if (addr <= 32) {
+                shared[addr >> 3] |= 1 << (addr & 7);
+            } else {
+                other[addr >> 3] |= 1 << (addr & 7);
+            }
+        }
+        map.announce(101, shared, 0);
+        map.announce(102, shared, 0);
+        map.announce(103, other, 0);
+        shardOwners(map, before);
+        uint16_t primary101 = 0;
+        for (uint16_t addr = 1; addr <= 32; addr++) {
+            EXPECT(before[addr] == 101 || before[addr] == 102);
+            if (before[addr] == 101) primary101++;
+        }
+        map.remove(101);
+        shardOwners(map, after);
+        uint16_t stray = 0;
+        for (uint16_t addr = 1; addr < 256; addr++) {
+            if (addr <= 32 && after[addr] != 102) stray++;
+            if (addr > 32 && after[addr] != before[addr]) stray++;
+        }
+        printf("replica         : 102 took over %u addresses from 101\n", (unsigned)primary101);
+        EXPECT(primary101 > 0);
+        EXPECT(stray == 0);
+    }
+    {
+        ShardMap map;
+        map.setSelf(100);
+        map.announce(101, all, 0);
+        map.announce(102, all, 10000);
+        map.expire(SHARD_TIMEOUT);
+        EXPECT(map.getGatewayCount() == 3);
+        map.expire(SHARD_TIMEOUT + 1);
+        EXPECT(map.getGatewayCount() == 2);
+        EXPECT(map.reaches(102, 1, nullptr) && !map.reaches(101, 1, nullptr));
+        for (uint16_t addr = 0; addr < 256; addr++) {
+            EXPECT(map.owner((uint8_t)addr) == 102);
+        }
+    }
+
+    const uint16_t counts[] = {1, 2, 4};
+    double rate[3] = {0};
+    for (uint8_t i = 0; i < 3; i++) {
+        LOAD_CONFIG config = {counts[i], HOSTCHECK_SHARD_SECONDS, HOSTCHECK_SHARD_RATE};
+        UdpLoadTest test(config);
+        EXPECT(test.run());
+        rate[i] = (double)test.getCompleted() / HOSTCHECK_SHARD_SECONDS;
+        printf("%u gateway(s)    : %.0f cmd/s completed, %u busy\n", (unsigned)counts[i], rate[i], (unsigned)test.getBusy());
+    }
+    EXPECT(rate[0] > 0);
+    EXPECT(rate[1] >= rate[0] * 1.6);
+    EXPECT(rate[2] >= rate[0] * 3);
+    printf("shard: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 带流程附加段（MESH_FLOW_TAG）的反转命令
+ */
+static String flowReverse(uint8_t addr)
+{
+    String msg = commandFrame(addr, SLAVE_CMD_REVERSE);
+    msg.concat((char)MESH_FLOW_TAG);
+    return msg;
+}
+
+/**
+ * @brief 多步流程检查
+ * @details 虚拟从机总线4个从机，从机1先正转：
+ *          节点2发来的流程反转命令依次下发停止和反转，从机1最终为G_SERIAL_RW，停止应答到达的同一轮主循环中下发反转；
+ *          总线上没有的从机6停止命令超时，流程结束且不下发反转；从机2的流程和节点3发给从机2的普通命令同时到达，流程让出；
+ *          再用回放串口让从机在停止后仍报告正转，流程以状态不符结束。
+ *          最后一次启动FLOW_MAX个流程（总线上没有的地址），再多一个被拒绝，全部超时结束后流程表清空
+ */
+static int runFlow()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        SLAVEBUS_CONFIG config = {SERIAL_BAUD, 4, 1000, 2000, 0, 0, 49, 0};
+        VirtualSlaveBus bus(config);
+        CaptureTransport transport;
+        APP app(&bus, &transport);
+        app.begin();
+        app.exec();
+        const FLOW_STATS &stats = app.getFlows().getStats();
+        String forward = commandFrame(1, SLAVE_CMD_FORWARD);
+        transport.deliver(2, forward);
+        runFor(app, clock, 100);
+        EXPECT(bus.getState(1) == G_SERIAL_CW);
+
+        String reverse = flowReverse(1);
+        transport.deliver(2, reverse);
+        uint32_t same_pass = 0;
+        for (uint32_t ms = 0; ms < 300; ms++) {
+            uint32_t stop_replies = app.getCmdCounters(SLAVE_CMD_STOP).replies;
+            uint32_t reverse_sent = app.getCmdCounters(SLAVE_CMD_REVERSE).sent;
+            app.modbus_exec();
+            app.exec();
+            if (app.getCmdCounters(SLAVE_CMD_STOP).replies != stop_replies &&
+                app.getCmdCounters(SLAVE_CMD_REVERSE).sent != reverse_sent) {
+                same_pass++;
+            }
+            clock.advance(1000);
+        }
+        printf("stop -> reverse : slave state %u, finished %u, reverse sent in the stop reply pass %u\n",
+               (unsigned)bus.getState(1), (unsigned)stats.finished, (unsigned)same_pass);
+        EXPECT(stats.finished == 1 && stats.failed == 0);
+        EXPECT(bus.getState(1) == G_SERIAL_RW);
+        EXPECT(same_pass == 1);
+
+        uint32_t reverse_sent = app.getCmdCounters(SLAVE_CMD_REVERSE).sent;
+        reverse = flowReverse(6);
+        transport.deliver(2, reverse);
+        runFor(app, clock, 300);
+        EXPECT(stats.failed == 1 && stats.timeouts == 1);
+        EXPECT(app.getCmdCounters(SLAVE_CMD_REVERSE).sent == reverse_sent);
+
+        reverse = flowReverse(2);
+        String read = commandFrame(2, SLAVE_CMD_READ);
+        transport.deliver(2, reverse);
+        transport.deliver(3, read);
+        runFor(app, clock, 300);
+        EXPECT(stats.failed == 2 && stats.timeouts == 1);
+        EXPECT(app.getCmdCounters(SLAVE_CMD_REVERSE).sent == reverse_sent);
+        EXPECT(bus.getState(2) == G_SERIAL_STOP);
+        printf("timeout/preempt : failed %u, timeouts %u, reverse not sent\n", (unsigned)stats.failed, (unsigned)stats.timeouts);
+
+        for (uint16_t i = 0; i < FLOW_MAX; i++) {
+            EXPECT(app.startReverse(100 + i));
+        }
+        EXPECT(!app.startReverse(99));
+        EXPECT(stats.active == FLOW_MAX && stats.peak == FLOW_MAX && stats.rejected == 1);
+        runFor(app, clock, FLOW_MAX * 120);
+        printf("%u flows       : %zu bytes per FLOW, FlowScheduler %zu bytes, all ended %s\n",
+               (unsigned)FLOW_MAX, sizeof(FLOW), sizeof(FlowScheduler), stats.active == 0 ? "yes" : "no");
+        EXPECT(stats.active == 0 && stats.failed == 2 + FLOW_MAX);
+        EXPECT(sizeof(FlowScheduler) <= 4096);
+    }
+    {
+        ReplayPort port;
+        CaptureTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();
+        const FLOW_STATS &stats = app.getFlows().getStats();
+        uint8_t frame[MotorFrame::FRAME_SIZE];
+        EXPECT(app.startReverse(3));
+        statusFrame(3, G_SERIAL_CW, frame);//停止后仍报告正转
+        port.feed(frame, sizeof(frame));
+        runFor(app, clock, 5);
+        EXPECT(stats.failed == 1 && stats.finished == 0);
+
+        EXPECT(app.startReverse(3));
+        statusFrame(3, G_SERIAL_STOP, frame);
+        port.feed(frame, sizeof(frame));
+        runFor(app, clock, 5);
+        statusFrame(3, G_SERIAL_RW, frame);
+        port.feed(frame, sizeof(frame));
+        runFor(app, clock, 5);
+        EXPECT(stats.finished == 1);
+    }
+    Clock::setSource(nullptr);
+    printf("flow: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 模拟信道扫描的mesh传输层
+ * @details mesh实际工作在mesh_channel上：init()指定该信道时停留一个信道的时间后入网，
+ *          指定0（全信道扫描）时扫过HOSTCHECK_CHANNELS个信道后入网，指定其他信道永远不会入网
+ */
+class ScanTransport : public CaptureTransport {
+public:
+    bool init() override
+    {
+        inits++;
+        init_channel = channel;
+        init_ms = Clock::millis();
+        return true;
+    }
+    void update() override
+    {
+        if (!nodes.empty()) return;
+        uint32_t dwell = init_channel == 0 ? HOSTCHECK_CHANNELS * HOSTCHECK_DWELL_MS : HOSTCHECK_DWELL_MS;
+        if ((init_channel == 0 || init_channel == mesh_channel) && Clock::millis() - init_ms >= dwell) {
+            nodes.push_back(HOSTCHECK_PARENT);
+            changed();
+        }
+    }
+    void setChannel(uint8_t channel) override { this->channel = channel; }
+    uint8_t getChannel() override { return nodes.empty() ? 0 : mesh_channel; }
+    bool getParentBssid(uint8_t *bssid) override
+    {
+        if (nodes.empty()) return false;
+        const uint8_t parent[6] = {0x02, 0x00, 0x00, 0x00, 0x00, HOSTCHECK_PARENT};
+        memcpy(bssid, parent, sizeof(parent));
+        return true;
+    }
+    void stop() override { stops++; }
+
+    uint8_t mesh_channel = 6; ///< mesh实际工作的信道
+    uint8_t channel = 0;      ///< 下次init()使用的信道
+    uint8_t init_channel = 0; ///< 最近一次init()使用的信道
+    uint32_t init_ms = 0;
+    uint32_t inits = 0;
+    uint32_t stops = 0;
+};
+
+/**
+ * @brief 开始组网并运行到入网或超时
+ * @return 从开始组网到入网的毫秒数，超时返回0
+ */
+static uint32_t joinMesh(MeshNode &node, VirtualClock &clock)
+{
+    node.begin();
+    uint32_t start = Clock::millis();
+    while (Clock::millis() - start < MESH_CACHE_TIMEOUT + HOSTCHECK_CHANNELS * HOSTCHECK_DWELL_MS * 2) {
+        node.update();
+        if (node.getFirstJoinMs() != 0) {
+            return Clock::millis() - start;
+        }
+        clock.advance(1000);
+    }
+    return 0;
+}
+
+/**
+ * @brief 入网信道缓存检查
+ * @details 模拟flash用临时文件保存，每次“上电”都重新构造存储对象和MeshNode：
+ *          首次启动没有缓存，全信道扫描入网后保存信道6和上级节点BSSID；再次启动只在信道6上寻找并更快入网；
+ *          mesh移到信道11后，缓存信道在MESH_CACHE_TIMEOUT内找不到mesh，停止并回退到全信道扫描，入网后缓存更新为信道11
+ */
+static int runChannel()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    char path[] = "/tmp/hostcheck_flash_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    remove(path);//只取唯一文件名，文件不存在时按擦除过的flash处理
+    const uint8_t parent[6] = {0x02, 0x00, 0x00, 0x00, 0x00, HOSTCHECK_PARENT};
+    {
+        SimFlashStore store(path);
+        ScanTransport transport;
+        MeshNode node(&transport);
+        node.setStore(&store);
+        uint32_t ms = joinMesh(node, clock);
+        printf("cold boot       : full scan, joined in %u ms\n", (unsigned)ms);
+        EXPECT(ms != 0);
+        EXPECT(transport.inits == 1 && transport.init_channel == 0);
+        EXPECT(!node.usedCachedChannel());
+        EXPECT(node.getCache().channel == 6);
+        EXPECT(memcmp(node.getCache().bssid, parent, 6) == 0);
+    }
+    {
+        SimFlashStore store(path);
+        ScanTransport transport;
+        MeshNode node(&transport);
+        node.setStore(&store);
+        uint32_t ms = joinMesh(node, clock);
+        printf("cache hit       : channel %u, joined in %u ms\n", (unsigned)transport.init_channel, (unsigned)ms);
+        EXPECT(ms != 0 && ms < HOSTCHECK_CHANNELS * HOSTCHECK_DWELL_MS);
+        EXPECT(transport.inits == 1 && transport.init_channel == 6);
+        EXPECT(node.usedCachedChannel());
+        EXPECT(!node.cacheFellBack());
+        EXPECT(memcmp(node.getCache().bssid, parent, 6) == 0);
+    }
+    {
+        SimFlashStore store(path);
+        ScanTransport transport;
+        transport.mesh_channel = 11;
+        MeshNode node(&transport);
+        node.setStore(&store);
+        uint32_t ms = joinMesh(node, clock);
+        printf("cache miss      : fell back to full scan, joined in %u ms\n", (unsigned)ms);
+        EXPECT(ms > MESH_CACHE_TIMEOUT);
+        EXPECT(node.cacheFellBack());
+        EXPECT(transport.stops == 1 && transport.inits == 2 && transport.init_channel == 0);
+        EXPECT(node.getCache().channel == 11);
+    }
+    {
+        SimFlashStore store(path);
+        ScanTransport transport;
+        transport.mesh_channel = 11;
+        MeshNode node(&transport);
+        node.setStore(&store);
+        uint32_t ms = joinMesh(node, clock);
+        EXPECT(ms != 0 && transport.init_channel == 11);
+    }
+    remove(path);
+    Clock::setSource(nullptr);
+    printf("channel: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 节点存活检查
+ * @details 超时：节点5每LIVENESS_DEFAULT_INTERVAL准时发心跳；节点6每次迟到0~HOSTCHECK_LIVE_JITTER毫秒，且每4个心跳丢1个。
+ *          期间不能有误判；之后两者都沉默，节点5的检测时延应小于固定的LIVENESS_MISSES个间隔，节点6的超时更宽。
+ *          心跳：MeshNode有邻居后每10毫秒运行一次，每条显式心跳发出时距上一条广播都不少于本机心跳间隔；
+ *          每秒有其他广播时不发心跳。拓扑连续变化后心跳间隔降到LIVENESS_MIN_INTERVAL并随心跳公告，
+ *          稳定LIVENESS_STABLE_MS后加倍
+ */
+static int runLiveness()
+{
+    int failures = 0;
+    {
+        PeerLiveness live;
+        uint32_t next5 = 0;
+        uint32_t next6 = 0;
+        uint32_t sent6 = 0;
+        uint32_t rng = 46;
+        uint32_t now = 0;
+        uint32_t end = HOSTCHECK_LIVE_ROUNDS * LIVENESS_DEFAULT_INTERVAL;
+        for (; now < end; now += 100) {
+            if (now >= next5) {
+                live.heard(5, now, LIVENESS_DEFAULT_INTERVAL);
+                next5 += LIVENESS_DEFAULT_INTERVAL;
+            }
+            if (now >= next6) {
+                if (sent6++ % 4 != 3) live.heard(6, now, LIVENESS_DEFAULT_INTERVAL);
+                rng = rng * 1103515245UL + 12345;
+                next6 += LIVENESS_DEFAULT_INTERVAL + (rng >> 16) % HOSTCHECK_LIVE_JITTER;
+            }
+            live.check(now);
+        }
+        uint32_t t5 = 0;
+        uint32_t t6 = 0;
+        for (uint8_t i = 0; i < LIVENESS_PEERS; i++) {
+            if (live.getPeer(i)->id == 5) t5 = PeerLiveness::timeout(*live.getPeer(i));
+            if (live.getPeer(i)->id == 6) t6 = PeerLiveness::timeout(*live.getPeer(i));
+        }
+        printf("timeout         : on-time peer %u ms, jittery lossy peer %u ms (fixed %u ms)\n",
+               (unsigned)t5, (unsigned)t6, (unsigned)(LIVENESS_DEFAULT_INTERVAL * LIVENESS_MISSES));
+        EXPECT(live.getDetections() == 0 && live.getRecoveries() == 0);
+        EXPECT(t5 < (uint32_t)LIVENESS_DEFAULT_INTERVAL * LIVENESS_MISSES);
+        EXPECT(t6 > t5);
+
+        uint32_t quiet = now;
+        while (live.isAlive(5) && now - quiet < 60000) {
+            now += 100;
+            live.check(now);
+        }
+        uint32_t detect5 = live.getLastDetectMs();
+        while (live.isAlive(6) && now - quiet < 60000) {
+            now += 100;
+            live.check(now);
+        }
+        printf("detection       : on-time peer %u ms, jittery lossy peer %u ms after its last message\n",
+               (unsigned)detect5, (unsigned)live.getLastDetectMs());
+        EXPECT(live.getDetections() == 2);
+        EXPECT(detect5 <= t5 + 100);
+        EXPECT(detect5 < (uint32_t)LIVENESS_DEFAULT_INTERVAL * LIVENESS_MISSES);
+    }
+
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    {
+        CaptureTransport transport;
+        MeshNode node(&transport);
+        node.begin();
+        transport.nodes.push_back(2);
+        for (uint8_t i = 0; i < 3; i++) {
+            transport.changed();
+        }
+        PeerLiveness &live = node.getLiveness();
+        EXPECT(live.getInterval() == LIVENESS_MIN_INTERVAL);
+
+        uint32_t last_broadcast = Clock::millis();
+        size_t seen = transport.sent.size();
+        uint32_t heartbeats = 0;
+        uint32_t early = 0;
+        uint32_t announced = 0;
+        for (uint32_t ms = 0; ms < 20000; ms += 10) {
+            node.update();
+            for (; seen < transport.sent.size(); seen++) {
+                const auto &m = transport.sent[seen];
+                if (m.first != 0) continue;
+                if (m.second.compare(0, 2, LIVENESS_TAG) == 0) {
+                    heartbeats++;
+                    if (Clock::millis() - last_broadcast < live.getInterval()) early++;
+                    announced = (uint8_t)m.second[2] * 100U;
+                }
+                last_broadcast = Clock::millis();
+            }
+            clock.advance(10 * 1000);
+        }
+        printf("silent          : %u heartbeats in 20 s at %u ms interval\n", (unsigned)heartbeats, (unsigned)live.getInterval());
+        EXPECT(heartbeats > 0 && early == 0);
+        EXPECT(announced == LIVENESS_MIN_INTERVAL);
+
+        uint32_t before = transport.count(0, LIVENESS_TAG);
+        for (uint32_t ms = 0; ms < 20000; ms += 10) {
+            if (ms % 1000 == 0) node.sendBroadcast("STATUS");
+            node.update();
+            clock.advance(10 * 1000);
+        }
+        printf("busy            : %u heartbeats in 20 s with a broadcast every second\n",
+               (unsigned)(transport.count(0, LIVENESS_TAG) - before));
+        EXPECT(transport.count(0, LIVENESS_TAG) == before);
+
+        for (uint32_t ms = 0; ms <= LIVENESS_STABLE_MS; ms += 100) {
+            node.update();
+            clock.advance(100 * 1000);
+        }
+        printf("churn           : interval %u ms after %u ms without topology changes\n",
+               (unsigned)live.getInterval(), (unsigned)LIVENESS_STABLE_MS);
+        EXPECT(live.getInterval() == LIVENESS_MIN_INTERVAL * 2);
+        transport.changed();
+        EXPECT(live.getInterval() == LIVENESS_MIN_INTERVAL);
+    }
+    Clock::setSource(nullptr);
+    printf("liveness: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 从机状态上行检查
+ * @details 节点7订阅后，4个从机每10毫秒轮流上报一帧，共HOSTCHECK_UPLINK_FRAMES帧，状态每HOSTCHECK_UPLINK_HOLD帧整体变化一次：
+ *          订阅时和每UPLINK_KEYFRAME_MS各一条快照，每次变化只产生一条增量，其余帧被抑制，上行字节数与逐帧转发比较；
+ *          节点8随后订阅，下一次发布即为两个订阅者都收到的快照；再让发往节点8的单播失败，节点8被移除，节点7照常收到增量
+ */
+static int runUplink()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        ReplayPort port;
+        CaptureTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();
+        StatusUplink &uplink = app.getUplink();
+        String sub = UPLINK_SUB_TAG;
+        transport.deliver(7, sub);
+        uint32_t subs[UPLINK_SUBSCRIBERS];
+        EXPECT(uplink.getSubscribers(subs) == 1 && subs[0] == 7);
+
+        uint8_t frame[MotorFrame::FRAME_SIZE];
+        for (int i = 0; i < HOSTCHECK_UPLINK_FRAMES; i++) {
+            uint8_t addr = i % 4 + 1;
+            statusFrame(addr, (i / HOSTCHECK_UPLINK_HOLD + addr) % 3, frame);
+            port.feed(frame, sizeof(frame));
+            runFor(app, clock, 10);
+        }
+        runFor(app, clock, 200);
+        uint32_t changes = (HOSTCHECK_UPLINK_FRAMES - 1) / HOSTCHECK_UPLINK_HOLD;
+        uint32_t keys = transport.count(7, UPLINK_KEY_TAG);
+        uint32_t deltas = transport.count(7, UPLINK_DELTA_TAG);
+        printf("frames          : %u, suppressed %u, %u deltas, %u keyframes\n",
+               (unsigned)uplink.getUpdates(), (unsigned)uplink.getSuppressed(), (unsigned)deltas, (unsigned)keys);
+        printf("bytes           : %u published, %u per-frame forwarding\n",
+               (unsigned)uplink.getSentBytes(), (unsigned)uplink.getNaiveBytes());
+        EXPECT(uplink.getUpdates() == HOSTCHECK_UPLINK_FRAMES);
+        EXPECT(deltas == changes);
+        EXPECT(uplink.getSuppressed() >= HOSTCHECK_UPLINK_FRAMES * 9 / 10);
+        EXPECT(keys == 1 + HOSTCHECK_UPLINK_FRAMES * 10 / UPLINK_KEYFRAME_MS);
+        EXPECT(transport.bytes == uplink.getSentBytes());
+        EXPECT(uplink.getSentBytes() * HOSTCHECK_UPLINK_MIN_GAIN <= uplink.getNaiveBytes());
+        if (deltas > 0) {
+            const std::string &last = transport.sent.back().second;
+            EXPECT(last.compare(0, 3, UPLINK_DELTA_TAG) == 0);
+            EXPECT(last.size() == 3 + 3 + 4);//序号+位图+4个从机的新值
+        }
+
+        transport.deliver(8, sub);
+        runFor(app, clock, 100);
+        EXPECT(transport.count(8, UPLINK_KEY_TAG) == 1);
+        EXPECT(transport.count(7, UPLINK_KEY_TAG) == keys + 1);
+        EXPECT(uplink.getSubscribers(subs) == 2);
+
+        transport.fail_dest = 8;
+        statusFrame(1, 9, frame);
+        port.feed(frame, sizeof(frame));
+        runFor(app, clock, 200);
+        EXPECT(transport.count(7, UPLINK_DELTA_TAG) == deltas + 1);
+        EXPECT(transport.count(8, UPLINK_DELTA_TAG) == 0);
+        EXPECT(uplink.getSubscribers(subs) == 1 && subs[0] == 7);
+    }
+    Clock::setSource(nullptr);
+    printf("uplink: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 经mesh控制流量记录
+ * @details 默认没有管理节点，TRACE_START被丢弃；用APP::addAdmin（与windosw_mesh.ino的ADMIN_NODES相同的路径）
+ *          添加采集节点后开始记录，记录期间的命令和应答在停止后分块发给采集节点
+ */
+static int runTrace()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        SLAVEBUS_CONFIG config = {SERIAL_BAUD, 4, 1000, 2000, 0, 0, 11, 0};
+        VirtualSlaveBus bus(config);
+        CaptureTransport transport;
+        APP app(&bus, &transport);
+        app.begin();
+        app.exec();
+        String start = "TRACE_START";
+        String stop = "TRACE_STOP";
+        transport.deliver(8, start);
+        EXPECT(!app.getTrace().isRunning());
+        EXPECT(app.getMesh().getAdminRejected() == 1);
+
+        EXPECT(app.addAdmin(8));
+        transport.deliver(8, start);
+        EXPECT(app.getTrace().isRunning());
+        EXPECT(app.getMesh().getTraceCollector() == 8);
+        for (uint8_t addr = 1; addr <= 4; addr++) {
+            String msg = commandFrame(addr, SLAVE_CMD_READ);
+            transport.deliver(2, msg);
+            runFor(app, clock, 120);
+        }
+        transport.deliver(9, stop);//非管理节点不能停止
+        EXPECT(app.getTrace().isRunning());
+        transport.deliver(8, stop);
+        EXPECT(!app.getTrace().isRunning());
+        runFor(app, clock, 500);
+
+        size_t trc_bytes = 0;
+        for (const auto &m : transport.sent) {
+            if (m.first == 8 && m.second.compare(0, 3, "TRC") == 0) trc_bytes += m.second.size() - 3;
+        }
+        printf("admin rejected  : %u\n", (unsigned)app.getMesh().getAdminRejected());
+        printf("trace chunks    : %u (%zu bytes)\n", (unsigned)transport.count(8, "TRC"), trc_bytes);
+        EXPECT(app.getMesh().getAdminRejected() == 2);
+        EXPECT(transport.count(8, "TRC") > 0);
+        EXPECT(trc_bytes >= 8 * MotorFrame::FRAME_SIZE);//4条命令和4个应答
+        EXPECT(app.getTrace().count() == 0);
+    }
+    Clock::setSource(nullptr);
+    printf("trace: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 组配置消息："GRP" 组号 组帧地址 成员数 [成员地址]...
+ */
+static String groupConfig(uint8_t id, uint8_t bus_addr, const uint8_t *members, uint8_t count)
+{
+    String msg = GROUP_CFG_TAG;
+    uint8_t head[3] = {id, bus_addr, count};
+    msg.concat((const char *)head, sizeof(head));
+    msg.concat((const char *)members, count);
+    return msg;
+}
+
+/**
+ * @brief 经mesh配置从机组
+ * @details 网关先经普通命令学到从机1~4。节点9不是管理节点，它发来的组配置被丢弃并计入admin_rejected；
+ *          用APP::addAdmin添加节点9后再配置：逐个下发的组5（成员1~4）每个成员收到一条命令并应答，
+ *          带组帧地址的组6只发一帧
+ */
+static int runGroup()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    {
+        SLAVEBUS_CONFIG config = {SERIAL_BAUD, 4, 1000, 2000, 0, 0, 5, 0};
+        VirtualSlaveBus bus(config);
+        CaptureTransport transport;
+        APP app(&bus, &transport);
+        app.begin();
+        app.exec();
+        for (uint8_t addr = 1; addr <= 4; addr++) {
+            String msg = commandFrame(addr, SLAVE_CMD_READ);
+            transport.deliver(2, msg);
+            runFor(app, clock, 120);
+        }
+        EXPECT(app.getMesh().getShard().isOwner(1));
+
+        const uint8_t members[4] = {1, 2, 3, 4};
+        String paced = groupConfig(5, 0, members, 4);
+        String grouped = groupConfig(6, 0xF6, members, 4);
+        transport.deliver(9, paced);
+        EXPECT(app.getGroups().find(5) == nullptr);
+        EXPECT(app.getMesh().getAdminRejected() == 1);
+
+        EXPECT(app.addAdmin(9));
+        transport.deliver(9, paced);
+        transport.deliver(9, grouped);
+        EXPECT(app.getGroups().find(5) != nullptr && app.getGroups().find(5)->count == 4);
+        EXPECT(app.getGroups().find(6) != nullptr);
+        EXPECT(app.getMesh().getAdminRejected() == 1);
+
+        const GROUP_STATS &stats = app.getGroups().getStats();
+        uint32_t replies = app.getCmdCounters(SLAVE_CMD_FORWARD).replies;
+        String cmd = GROUP_CMD_TAG;
+        cmd.concat((char)5);
+        cmd.concat((char)SLAVE_CMD_FORWARD);
+        transport.deliver(9, cmd);
+        runFor(app, clock, 500);
+        printf("group 5         : %u frames, completion %u us\n", (unsigned)stats.frames, (unsigned)stats.last_completion);
+        EXPECT(stats.commands == 1 && stats.frames == 4);
+        EXPECT(app.getCmdCounters(SLAVE_CMD_FORWARD).replies == replies + 4);
+
+        cmd = GROUP_CMD_TAG;
+        cmd.concat((char)6);
+        cmd.concat((char)SLAVE_CMD_STOP);
+        transport.deliver(9, cmd);
+        runFor(app, clock, 100);
+        printf("group 6         : %u frame(s)\n", (unsigned)(stats.frames - 4));
+        EXPECT(stats.commands == 2 && stats.frames == 5);
+    }
+    Clock::setSource(nullptr);
+    printf("group: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 稳态分配检查
+ * @details 虚拟时钟下网关收mesh命令、下发、收从机应答；预热HOSTCHECK_ALLOC_PASSES条后进入稳态，
+ *          再跑同样多条，热路径不能分配。最后在热路径作用域内故意分配一次，确认分配确实被统计到
+ */
+static int runAlloc()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    uint32_t violations;
+    size_t steady_tx;
+    bool probe_ok;
+    {
+        FixedPort port;
+        ReplayTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();
+        size_t warm_tx = 0;
+        for (int pass = 0; pass < 2 * HOSTCHECK_ALLOC_PASSES; pass++) {
+            if (pass == HOSTCHECK_ALLOC_PASSES) {
+                warm_tx = port.tx_bytes;
+                MemTrack::setSteadyState(true);
+            }
+            uint8_t payload[MotorFrame::PAYLOAD_LEN] = {(uint8_t)(1 + pass % 8), 0x03, 0x01, 0x00, (uint8_t)(pass % 3), 0x01, 0x00};
+            uint8_t frame[MotorFrame::FRAME_SIZE];
+            MotorFrame::encode(frame, payload);
+            String msg;
+            msg.concat((const char *)frame, MotorFrame::FRAME_SIZE);
+            transport.deliver(1, msg);
+            app.received_handle();
+            clock.advance(1000);
+            port.feed(frame, MotorFrame::FRAME_SIZE);//从机应答：同样格式的状态帧
+            app.modbus_exec();
+            app.exec();
+            clock.advance(HOSTCHECK_ALLOC_GAP_US - 1000);
+            app.exec();
+        }
+        steady_tx = port.tx_bytes - warm_tx;
+        violations = MemTrack::getViolations();
+
+        void *(*volatile alloc)(size_t) = malloc;//经volatile指针调用，编译器不能省掉这次分配
+        {
+            MEMTRACK_HOT_SCOPE("hostcheck::probe");
+            free(alloc(16));
+        }
+        probe_ok = MemTrack::getViolations() == violations + 1;
+        MemTrack::setSteadyState(false);
+    }
+    Clock::setSource(nullptr);
+
+    for (uint8_t i = 0; i < MemTrack::getSiteCount(); i++) {
+        const MEM_SITE *s = MemTrack::getSite(i);
+        printf("%-32s %s calls=%u allocs=%u bytes=%d\n", s->tag, s->hot ? "hot " : "cold",
+               (unsigned)s->calls, (unsigned)s->allocs, (int)s->bytes);
+    }
+    printf("steady tx bytes : %zu\n", steady_tx);
+    printf("violations      : %u\n", (unsigned)violations);
+    bool ok = violations == 0 && steady_tx > 0 && probe_ok;
+    printf("alloc: %s\n", ok ? "ok" : (probe_ok ? "FAILED" : "FAILED (allocations not tracked)"));
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief 启动耗时测量
+ * @details 复位时从机已在总线上发出一帧状态，同一进程中另起一个UDP mesh节点定时广播；
+ *          以构造APP前的时间为复位时刻，主循环按1毫秒轮询
+ */
+static int runStartup()
+{
+    FixedPort port;
+    UdpMeshTransport peer;
+    if (!peer.init()) {
+        fprintf(stderr, "startup: cannot init peer transport\n");
+        return 1;
+    }
+    uint8_t payload[MotorFrame::PAYLOAD_LEN] = {1, 0x03, 0x01, 0x01, 0x00, 0x01, 0x00};
+    uint8_t frame[MotorFrame::FRAME_SIZE];
+    MotorFrame::encode(frame, payload);
+    port.feed(frame, MotorFrame::FRAME_SIZE);
+
+    uint32_t reset = Clock::millis();
+    UdpMeshTransport transport;
+    APP app(&port, &transport);
+    app.begin();
+    uint32_t last_ping = reset;
+    while (app.getFirstMeshMs() == 0 && Clock::millis() - reset < HOSTCHECK_STARTUP_TIMEOUT) {
+        app.modbus_exec();
+        app.exec();
+        peer.update();
+        if (Clock::millis() - last_ping >= HOSTCHECK_STARTUP_PING) {
+            String ping = "PING";
+            peer.sendBroadcast(ping);
+            last_ping = Clock::millis();
+        }
+        usleep(1000);
+    }
+
+    // 0表示尚未发生
+    uint32_t times[] = {app.getSerialReadyMs(), app.getFirstFrameMs(), app.getMesh().getStartMs(),
+                        app.getMeshJoinMs(), app.getFirstMeshMs()};
+    const char *names[] = {"serial ready", "first frame", "mesh start", "mesh join", "first mesh msg"};
+    for (uint8_t i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+        if (times[i] == 0) {
+            printf("%-16s: -\n", names[i]);
+        } else {
+            printf("%-16s: %u ms\n", names[i], (unsigned)(times[i] - reset));
+        }
+    }
+    bool ok = app.getFirstFrameMs() != 0 && app.getFirstMeshMs() != 0
+           && (int32_t)(app.getMesh().getStartMs() - app.getFirstFrameMs()) >= 0;
+    printf("startup: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief RS-485方向控制检查
+ * @details 一帧8字节：UART按时发送时DE在最后一个停止位之后一个位时间释放，不推后；
+ *          UART迟发HOSTCHECK_RS485_STALL微秒时，到预定时间FIFO未空，推后释放，
+ *          DE不早于最后一个停止位加余量，也不多于一个字符时间
+ */
+static int runRs485()
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    int failures = 0;
+    for (uint32_t stall : {0u, (uint32_t)HOSTCHECK_RS485_STALL}) {
+        LateUart port(stall);
+        Rs485Direction dir;
+        dir.begin(&port, 4, SERIAL_BAUD);
+        port.char_us = dir.getCharUs();
+        uint8_t frame[8] = {0};
+        dir.acquire();
+        port.write(frame, sizeof(frame));
+        dir.transmitted(sizeof(frame));
+        uint64_t released = 0;
+        for (int i = 0; i < 2000 && released == 0; i++) {
+            clock.advance(HOSTCHECK_RS485_STEP);
+            dir.poll();
+            if (!dir.isDriving()) {
+                released = clock.now();
+            }
+        }
+        uint64_t earliest = port.wireEnd() + dir.getMarginUs();
+        printf("  stall %u us: last stop bit at %llu us, DE released at %llu us, late drains %u\n", (unsigned)stall,
+               (unsigned long long)port.wireEnd(), (unsigned long long)released, (unsigned)dir.getStats().late_drains);
+        EXPECT(released >= earliest);
+        if (stall == 0) {
+            EXPECT(released < earliest + HOSTCHECK_RS485_STEP);
+            EXPECT(dir.getStats().late_drains == 0);
+        } else {
+            EXPECT(released < earliest + dir.getCharUs() + HOSTCHECK_RS485_STEP);
+            EXPECT(dir.getStats().late_drains > 0);
+        }
+    }
+    Clock::setSource(nullptr);
+    printf("rs485: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s bench [options] | pty | udp [options] | replay [file] [--realtime] | startup | alloc | trace | group | admission | block | telemetry | uplink | channel | shard | liveness | flow | rs485\n", argv[0]);
+        return 2;
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return runBench(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "pty") == 0) {
+        return runPty();
+    }
+    if (strcmp(argv[1], "udp") == 0) {
+        return runUdp(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "replay") == 0) {
+        return runReplay(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "startup") == 0) {
+        return runStartup();
+    }
+    if (strcmp(argv[1], "alloc") == 0) {
+        return runAlloc();
+    }
+    if (strcmp(argv[1], "trace") == 0) {
+        return runTrace();
+    }
+    if (strcmp(argv[1], "group") == 0) {
+        return runGroup();
+    }
+    if (strcmp(argv[1], "admission") == 0) {
+        return runAdmission();
+    }
+    if (strcmp(argv[1], "block") == 0) {
+        return runBlock();
+    }
+    if (strcmp(argv[1], "telemetry") == 0) {
+        return runTelemetry();
+    }
+    if (strcmp(argv[1], "uplink") == 0) {
+        return runUplink();
+    }
+    if (strcmp(argv[1], "channel") == 0) {
+        return runChannel();
+    }
+    if (strcmp(argv[1], "flow") == 0) {
+        return runFlow();
+    }
+    if (strcmp(argv[1], "liveness") == 0) {
+        return runLiveness();
+    }
+    if (strcmp(argv[1], "shard") == 0) {
+        return runShard();
+    }
+    if (strcmp(argv[1], "rs485") == 0) {
+        return runRs485();
+    }
+    fprintf(stderr, "unknown command %s\n", argv[1]);
+    return 2;
+}
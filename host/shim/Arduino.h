@@ -0,0 +1,122 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : Arduino.h
+ * @brief          : 主机构建用的Arduino核心替身
+ *                   只提供src中用到的接口：时间、引脚（空操作）、String、Serial
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <list>
+#include <functional>
+
+typedef uint8_t byte;
+typedef uint16_t uint16;
+
+#define LED_BUILTIN 2
+#define OUTPUT 1
+#define INPUT 0
+#define HIGH 1
+#define LOW 0
+#define SERIAL_8N1 0
+#define IRAM_ATTR  // 主机上没有IRAM
+
+// 时间：单调时钟，delay()真实休眠
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// 中断和引脚：主机上为空操作
+void noInterrupts();
+void interrupts();
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+
+long random(long max);
+long random(long min, long max);
+
+/**
+ * @brief Arduino String替身（基于std::string）
+ */
+class String {
+public:
+    std::string s;
+
+    String() {}
+    String(const char *c) : s(c) {}
+    String(const String &o) = default;
+    String &operator=(const String &o) = default;
+    explicit String(int v) : s(std::to_string(v)) {}
+    explicit String(unsigned int v) : s(std::to_string(v)) {}
+    explicit String(long v) : s(std::to_string(v)) {}
+    explicit String(unsigned long v) : s(std::to_string(v)) {}
+
+    unsigned int length() const { return s.size(); }
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return s[i]; }
+    const char *c_str() const { return s.c_str(); }
+    bool reserve(unsigned int n) { s.reserve(n); return true; }
+    bool concat(const char *c, unsigned int n) { s.append(c, n); return true; }
+    bool concat(const String &o) { s += o.s; return true; }
+    bool concat(char c) { s += c; return true; }
+    bool concat(unsigned long v) { s += std::to_string(v); return true; }
+    bool concat(unsigned int v) { s += std::to_string(v); return true; }
+    bool concat(int v) { s += std::to_string(v); return true; }
+    bool startsWith(const char *p) const { return s.rfind(p, 0) == 0; }
+    bool startsWith(const String &p) const { return s.rfind(p.s, 0) == 0; }
+    String substring(unsigned int a) const { String r; r.s = s.substr(a); return r; }
+    String substring(unsigned int a, unsigned int b) const { String r; r.s = s.substr(a, b - a); return r; }
+    long toInt() const { return atol(s.c_str()); }
+    String &operator+=(const String &o) { s += o.s; return *this; }
+    String &operator+=(const char *o) { s += o; return *this; }
+    String &operator+=(char o) { s += o; return *this; }
+    friend String operator+(const String &a, const String &b) { String r; r.s = a.s + b.s; return r; }
+    friend String operator+(const String &a, const char *b) { String r; r.s = a.s + b; return r; }
+    friend String operator+(const char *a, const String &b) { String r; r.s = a + b.s; return r; }
+};
+
+/**
+ * @brief 串口替身：输出写到标准输出，没有输入
+ */
+class Stream {
+public:
+    virtual ~Stream() {}
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    size_t read(uint8_t * /*buf*/, size_t /*len*/) { return 0; }
+    size_t readBytes(uint8_t * /*buf*/, size_t /*len*/) { return 0; }
+    virtual size_t write(const uint8_t *buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    int availableForWrite() { return 128; }
+    void flush() { fflush(stdout); }
+    void begin(unsigned long /*baud*/, int /*config*/ = SERIAL_8N1) {}
+    void printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void print(const char *s) { fputs(s, stdout); }
+    void print(int v) { fprintf(stdout, "%d", v); }
+    void println(const char *s = "") { puts(s); }
+    void println(const String &s) { puts(s.c_str()); }
+};
+
+class HardwareSerial : public Stream {};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
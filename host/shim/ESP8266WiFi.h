@@ -0,0 +1,29 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : ESP8266WiFi.h
+ * @brief          : 主机构建用的WiFi替身，返回固定的链路参数
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include <Arduino.h>
+
+class WiFiClass {
+public:
+    int8_t RSSI() { return -55; }
+    uint8_t *BSSID() { static uint8_t bssid[6]; return bssid; }
+    int32_t channel() { return 1; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_ESP8266WIFI_H
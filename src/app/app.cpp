@@ -5,13 +5,265 @@
  * @details 初始化APP类的实例，并设置LED引脚
  * @param ledPin LED所连接的引脚号
  */
-APP::APP():led(LED_BUILTIN)
-,time_count(0)//初始化时间计数器
+APP::APP():time_count(0)//初始化时间计数器
 ,blinkInterval(200)//初始化闪烁间隔
+,led(LED_BUILTIN)
 ,uart()
 ,modbus()
+,modbus2(MODBUS::secondaryPort())
+,flows(this)
 {
     this->last_led_time = 0;//初始化LED时间戳
+    this->last_mesh_time = 0;
+    this->serial_ready_ms = 0;
+    this->first_frame_ms = 0;
+    this->startup_reported = false;
+    memset(this->block_owner, 0, sizeof(this->block_owner));
+    this->block_rate = 0;
+    this->block_regs_last = 0;
+    this->last_rate_time = 0;
+    this->initBuses();
+    this->initCommands();
+}
+
+/**
+ * @brief APP类的构造函数（注入串口端口和mesh传输层）
+ * @param port 串口端口
+ * @param transport mesh传输层
+ */
+APP::APP(SerialPort *port, MeshTransport *transport):APP(port, nullptr, transport)
+{
+}
+
+/**
+ * @brief APP类的构造函数（注入两条从机总线和mesh传输层）
+ * @param port 第一条总线串口端口
+ * @param port2 第二条总线串口端口，nullptr表示只有一条总线
+ * @param transport mesh传输层
+ */
+APP::APP(SerialPort *port, SerialPort *port2, MeshTransport *transport):time_count(0)//初始化时间计数器
+,blinkInterval(200)//初始化闪烁间隔
+,led(LED_BUILTIN)
+,uart()
+,modbus(port)
+,modbus2(port2)
+,mymesh(transport)
+,flows(this)
+{
+    this->last_led_time = 0;//初始化LED时间戳
+    this->last_mesh_time = 0;
+    this->serial_ready_ms = 0;
+    this->first_frame_ms = 0;
+    this->startup_reported = false;
+    memset(this->block_owner, 0, sizeof(this->block_owner));
+    this->block_rate = 0;
+    this->block_regs_last = 0;
+    this->last_rate_time = 0;
+    this->initBuses();
+    this->initCommands();
+}
+
+/**
+ * @brief 登记已配置端口的总线
+ */
+void APP::initBuses()
+{
+    this->bus_count = 0;
+    this->bus_next = 0;
+    this->route_count = 0;
+    this->route_next = 0;
+    this->buses[this->bus_count++] = &this->modbus;
+    if(this->modbus2.hasPort()){
+        this->buses[this->bus_count++] = &this->modbus2;
+    }
+}
+
+/**
+ * @brief 命令计数和应答等待槽初始化
+ */
+void APP::initCommands()
+{
+    memset(this->cmd_counters, 0, sizeof(this->cmd_counters));
+    memset(&this->group_run, 0, sizeof(this->group_run));
+    for(uint8_t i = 0; i < CMD_PENDING_SLOTS; i++){
+        this->cmd_pending[i].app = this;
+    }
+}
+
+/**
+ * @brief 登记等待应答的命令，同一从机的新命令取代旧命令重新计时
+ * @param mask 命令发往的总线，应答或超时前占用
+ */
+void APP::armReply(uint8_t addr, const SLAVE_CMD_DEF *def, uint8_t mask)
+{
+    CMD_PENDING *slot = nullptr;
+    for(uint8_t i = 0; i < CMD_PENDING_SLOTS; i++){
+        CMD_PENDING *p = &this->cmd_pending[i];
+        if(p->timer.armed && p->addr == addr){
+            slot = p;
+            break;
+        }
+        if(slot == nullptr && !p->timer.armed){
+            slot = p;
+        }
+    }
+    if(slot == nullptr){
+        return;//等待槽已满
+    }
+    slot->addr = addr;
+    slot->code = def->code;
+    slot->mask = mask;
+    this->wheel.schedule(&slot->timer, (uint32_t)def->timeout * 1000, replyTimeout, slot);
+}
+
+/**
+ * @brief 按命令表下发命令，登记计数和应答等待
+ * @param code 命令码，需小于SLAVE_CMD_COUNT
+ * @return 最后一条发出该命令的总线
+ */
+MODBUS *APP::dispatch(uint8_t addr, uint8_t code)
+{
+    MEMTRACK_HOT_SCOPE("APP::dispatch");
+    const SLAVE_CMD_DEF *def = SlaveCommands::find(code);
+    uint8_t mask = this->busMask(addr);
+    MODBUS *bus = &this->modbus;
+    for(uint8_t i = 0; i < this->bus_count; i++){
+        if(mask & (1 << i)){
+            bus = this->buses[i];
+            def->handler(*bus, addr, code);//按命令表下发
+        }
+    }
+    this->cmd_counters[code].sent++;
+    if(def->reply){
+        this->armReply(addr, def, mask);
+    }
+    return bus;
+}
+
+/**
+ * @brief 启动安全反转流程
+ */
+bool APP::startReverse(uint8_t addr)
+{
+    return this->flows.spawn(reverseFlow, addr) != nullptr;
+}
+
+/**
+ * @brief 安全反转流程：先停止并确认从机已停止，再反转并确认从机已反转
+ * @details 由带MESH_FLOW_TAG的反转命令启动。每一步与commandHandle一样先等该从机的总线空闲再下发，
+ *          然后等待应答或命令表中的超时；等待应答期间该从机收到新的mesh命令时流程让出，不再继续下发。
+ *          应答中的从机状态是SERIAL_STA，不是命令码，每一步按表中的状态列确认
+ */
+uint8_t APP::reverseFlow(FLOW *f, void *ctx)
+{
+    static const uint8_t steps[][2] = {//命令码，应答中应确认的从机状态
+        {SLAVE_CMD_STOP,    G_SERIAL_STOP},
+        {SLAVE_CMD_REVERSE, G_SERIAL_RW},
+    };
+    APP *app = (APP *)ctx;
+    FLOW_BEGIN(f);
+    for(f->step = 0; f->step < sizeof(steps) / sizeof(steps[0]); f->step++){
+        while((app->busMask(f->arg) & app->busyMask()) != 0){
+            FLOW_SLEEP(f, 1);//总线上还有其他事务
+        }
+        app->dispatch(f->arg, steps[f->step][0]);
+        FLOW_AWAIT(f, FLOW_WAIT_REPLY | FLOW_WAIT_MESH, f->arg, SlaveCommands::find(steps[f->step][0])->timeout);
+        if(f->event == FLOW_WAIT_MESH){
+            FLOW_EXIT(f, FLOW_ERR_PREEMPTED);
+        }
+        if(f->event == FLOW_WAIT_TIME){
+            FLOW_EXIT(f, FLOW_ERR_TIMEOUT);
+        }
+        if((f->value >> 8 & 0xFF) != steps[f->step][1]){
+            FLOW_EXIT(f, FLOW_ERR_STATE);
+        }
+    }
+    FLOW_END(f);
+}
+
+/**
+ * @brief 收到从机状态帧，结束该从机的应答等待
+ */
+void APP::replyReceived(uint8_t addr)
+{
+    for(uint8_t i = 0; i < CMD_PENDING_SLOTS; i++){
+        CMD_PENDING *p = &this->cmd_pending[i];
+        if(p->timer.armed && p->addr == addr){
+            this->wheel.cancel(&p->timer);
+            this->cmd_counters[p->code].replies++;
+            this->mymesh.noteDelivery(true);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 应答超时回调（时间轮）
+ */
+void APP::replyTimeout(void *arg)
+{
+    CMD_PENDING *p = (CMD_PENDING *)arg;
+    p->app->cmd_counters[p->code].timeouts++;
+    p->app->mymesh.noteDelivery(false);//送达率计入链路开销
+}
+
+/**
+ * @brief 查找从机所在总线
+ * @details 发现期内未知从机的命令发往所有总线，由应答学习路由；发现期后只发往主总线，
+ *          不再让每条未知地址的命令占用所有总线。其他总线上后来接入的从机由它主动上报的状态帧学习路由
+ * @return 总线位掩码
+ */
+uint8_t APP::busMask(uint8_t addr)
+{
+    for(uint8_t i = 0; i < this->route_count; i++){
+        if(this->route_addr[i] == addr){
+            return 1 << this->route_bus[i];
+        }
+    }
+    return this->isDiscovering() ? (1 << this->bus_count) - 1 : 1;
+}
+
+/**
+ * @brief 正在进行事务的总线
+ * @return 有命令等待应答或块读写等待应答的总线位掩码
+ */
+uint8_t APP::busyMask()
+{
+    uint8_t mask = 0;
+    for(uint8_t i = 0; i < CMD_PENDING_SLOTS; i++){
+        if(this->cmd_pending[i].timer.armed){
+            mask |= this->cmd_pending[i].mask;
+        }
+    }
+    for(uint8_t i = 0; i < BLOCK_OWNER_SLOTS; i++){
+        if(this->block_owner[i] != 0){
+            mask |= this->block_owner_mask[i];
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief 由从机应答学习路由，表满时轮流替换
+ */
+void APP::learnRoute(uint8_t addr, uint8_t bus)
+{
+    this->mymesh.noteReach(addr);//公告给其他网关，参与分片
+    for(uint8_t i = 0; i < this->route_count; i++){
+        if(this->route_addr[i] == addr){
+            this->route_bus[i] = bus;
+            return;
+        }
+    }
+    uint8_t slot = this->route_count;
+    if(slot < BUS_ROUTE_SIZE){
+        this->route_count++;
+    } else {
+        slot = this->route_next;
+        this->route_next = (this->route_next + 1) % BUS_ROUTE_SIZE;
+    }
+    this->route_addr[slot] = addr;
+    this->route_bus[slot] = bus;
 }
 
 /**
@@ -27,6 +279,8 @@ APP::~APP()
  * @brief 初始化函数
  * @details 用于初始化系统资源，如串口、LED、传感器等
  * @details 应该在Arduino的setup()函数中调用一次
+ * @details 分阶段启动：串口收发先就绪，mesh在第一轮exec()处理完串口后才开始组网，
+ *          组网（扫描、入网）在后续的mymesh.update()中进行，不阻塞串口
  */
 void APP::begin() 
 {
@@ -35,23 +289,323 @@ void APP::begin()
     this->led.init();//初始化LED
     // this->uart.begin(115200);//初始化串口
 
-    this->mymesh.begin();//mymesh节点初始化
-    this->modbus.begin();//modbus初始化
+    for(uint8_t i = 0; i < this->bus_count; i++){
+        this->buses[i]->begin();//modbus初始化
+    }
+    this->mymesh.setSerialBaud(SERIAL_BAUD);//按串口波特率设置准入预算
+    uint32_t now = Clock::millis();
+    this->serial_ready_ms = now != 0 ? now : 1;//0保留表示尚未就绪
 }
 
+/**
+ * @brief mymesh接收处理函数
+ * @details 取出已准入的命令下发到串口，准入控制保证队列长度有界
+ */
 void APP::received_handle()
 {
-    if(this->mymesh.getSlaveSTA() == 1){//如果从机状态为1
-        this->mymesh.set_SlaveSTA(0);//设置从机状态为0
-        uint16_t slave_data = this->mymesh.getSlavedata();//获取从机命令
-        this->modbus.set_slave((uint8_t)(slave_data >> 8),(uint8_t)(slave_data & 0xFF));//设置从机地址
-    }else
-    {
-        // this->modbus.set_slave(this->slave_addr,0x04);//设置从机地址
+    this->commandHandle();
+    this->groupHandle();
+    this->blockRequestHandle();
+}
+
+/**
+ * @brief 命令下发
+ * @details 半双工总线上同一时间只进行一个事务：队首命令的总线上还有命令在等待应答时不取出，
+ *          保持命令顺序，等应答到达或命令表超时后再下发（主循环每轮都会调用）。
+ *          连发会和从机应答冲突，开启收发方向控制时应答还会被当作回显丢弃
+ */
+void APP::commandHandle()
+{
+    const MESH_CMD *head;
+    while((head = this->mymesh.peekCommand()) != nullptr){
+        this->flows.notify(FLOW_WAIT_MESH, head->addr, head->from);//该从机上运行的流程让出，不等总线空闲
+        if((this->busMask(head->addr) & this->busyMask()) != 0){
+            break;
+        }
+        MESH_CMD cmd;
+        this->mymesh.popCommand(&cmd);//取出已准入的命令
+        if(cmd.flow && cmd.cmd == SLAVE_CMD_REVERSE){
+            this->startReverse(cmd.addr);//流程表已满时计入FLOW_STATS.rejected
+            continue;
+        }
+        LAT_TRAIL trail;
+        trail.dequeue = this->mymesh.getNodeTime();
+        MODBUS *bus = this->dispatch(cmd.addr, cmd.cmd);//网关已拒绝未知命令码
+        trail.addr = cmd.addr;
+        trail.flags = cmd.flags;
+        trail.from = cmd.from;
+        trail.origin = cmd.origin_ts;
+        trail.rx = cmd.rx_ts;
+        trail.tx_done = trail.dequeue + (bus->getTxDoneUs() - (uint32_t)Clock::micros64());//换算为mesh时间
+        trail.reply = 0;
+        this->latency.onSent(trail);
+    }
+}
+
+/**
+ * @brief 选出本网关负责下发的组成员
+ * @details 每条总线上的成员只由其中最小地址的归属网关下发，能到达同一总线的网关得出相同的结果；
+ *          路由未学到的成员不参与，归属未知时不下发，避免发现期所有网关同时下发。结果写入group_run
+ * @return 本网关负责的总线位掩码
+ */
+uint8_t APP::groupMembers(const SLAVE_GROUP *group)
+{
+    const ShardMap &shard = this->mymesh.getShard();
+    uint8_t mask = 0;
+    for(uint8_t b = 0; b < this->bus_count; b++){
+        uint8_t n = 0;
+        uint8_t lowest = 0;
+        for(uint8_t i = 0; i < group->count; i++){
+            uint8_t addr = group->members[i];
+            if(!shard.canReachLocal(addr) || this->busMask(addr) != (1 << b)){
+                continue;
+            }
+            if(n == 0 || addr < lowest) lowest = addr;
+            this->group_run.addrs[b][n++] = addr;
+        }
+        this->group_run.count[b] = 0;
+        this->group_run.next[b] = 0;
+        if(n != 0 && shard.isOwner(lowest)){
+            this->group_run.count[b] = n;
+            mask |= 1 << b;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief 登记组命令在一条总线上发出的帧的完成时间
+ * @param first_done 该总线第一帧预计发送完成时间（micros）
+ */
+void APP::groupNoteTx(MODBUS *bus, uint32_t first_done)
+{
+    GROUP_RUN &run = this->group_run;
+    uint32_t f = first_done - run.start;
+    uint32_t l = bus->getTxDoneUs() - run.start;
+    if(run.frames == 0 || f < run.first) run.first = f;
+    if(l > run.last) run.last = l;
+}
+
+/**
+ * @brief 逐个下发组成员：每条空闲的总线发一个成员并等待其应答
+ * @return 还有成员未下发返回true
+ */
+bool APP::groupPace()
+{
+    GROUP_RUN &run = this->group_run;
+    if(!run.active){
+        return false;
     }
+    const SLAVE_CMD_DEF *def = SlaveCommands::find(run.code);
+    uint8_t busy = this->busyMask();
+    bool remaining = false;
+    for(uint8_t b = 0; b < this->bus_count; b++){
+        if(run.next[b] >= run.count[b]){
+            continue;
+        }
+        if((busy & (1 << b)) == 0){
+            MODBUS *bus = this->buses[b];
+            uint8_t addr = run.addrs[b][run.next[b]++];
+            def->handler(*bus, addr, run.code);
+            this->groupNoteTx(bus, bus->getTxDoneUs());
+            this->armReply(addr, def, 1 << b);
+            this->cmd_counters[run.code].sent++;
+            run.frames++;
+        }
+        if(run.next[b] < run.count[b]){
+            remaining = true;
+        }
+    }
+    if(!remaining){
+        run.active = false;
+        this->groups.record(run.last, run.last - run.first, run.frames);
+    }
+    return remaining;
 }
 
+/**
+ * @brief 组命令下发
+ * @details 只发给本网关负责的总线（见groupMembers），总线上有事务时保持顺序等下一轮。
+ *          组有组帧地址时每条总线只发一帧；不需要应答的命令用set_slaves一次写入连发；
+ *          需要应答的命令交给groupPace逐个下发。完成时间和成员间偏差按各帧预计发送完成时间计算
+ */
+void APP::groupHandle()
+{
+    if(this->groupPace()){
+        return;//上一条组命令还没发完
+    }
+    const MESH_GROUP_CMD *head;
+    while((head = this->mymesh.peekGroupCommand()) != nullptr){
+        const SLAVE_GROUP *group = this->groups.find(head->group);
+        uint8_t mask = group != nullptr ? this->groupMembers(group) : 0;
+        if((mask & this->busyMask()) != 0){
+            return;//总线上还有事务，保持顺序等下一轮
+        }
+        MESH_GROUP_CMD gc;
+        this->mymesh.popGroupCommand(&gc);
+        if(group == nullptr){
+            this->groups.noteUnknown();
+            continue;
+        }
+        if(mask == 0){
+            this->groups.noteNotOwned();//没有本网关负责的总线
+            continue;
+        }
+        const SLAVE_CMD_DEF *def = SlaveCommands::find(gc.cmd);
+        GROUP_RUN &run = this->group_run;
+        run.code = gc.cmd;
+        run.start = (uint32_t)Clock::micros64();
+        run.first = 0;
+        run.last = 0;
+        run.frames = 0;
+        if(group->bus_addr == 0 && def->reply){
+            run.active = true;
+            this->groupPace();
+            return;
+        }
+        for(uint8_t b = 0; b < this->bus_count; b++){
+            if((mask & (1 << b)) == 0){
+                continue;
+            }
+            MODBUS *bus = this->buses[b];
+            uint32_t first_done;
+            uint32_t frames;
+            if(group->bus_addr != 0){
+                def->handler(*bus, group->bus_addr, gc.cmd);//一帧驱动所有成员，组地址帧从机不应答
+                first_done = bus->getTxDoneUs();
+                frames = 1;
+            } else {
+                frames = bus->set_slaves(run.addrs[b], run.count[b], gc.cmd, &first_done);
+            }
+            this->groupNoteTx(bus, first_done);
+            run.frames += frames;
+        }
+        this->cmd_counters[gc.cmd].sent += run.frames;
+        this->groups.record(run.last, run.last - run.first, run.frames);
+    }
+}
 
+/**
+ * @brief 块读写请求下发
+ * @details 一次请求读写连续多个寄存器，替代多次单命令往返；
+ *          记录来源节点，应答到达后按从机地址回给请求者
+ */
+void APP::blockRequestHandle()
+{
+    uint32_t now = Clock::millis();
+    for(uint8_t i = 0; i < BLOCK_OWNER_SLOTS; i++){
+        if(this->block_owner[i] != 0 && (now - this->block_owner_time[i]) > BLOCK_REPLY_TIMEOUT){
+            this->block_owner[i] = 0;//从机无应答，释放
+        }
+        if(this->block_owner[i] != 0){
+            continue;
+        }
+        const MESH_BLOCK *head = this->mymesh.peekBlock();
+        if(head == nullptr || (this->busMask(head->block.addr) & this->busyMask()) != 0){
+            return;//总线上还有事务，保持顺序等下一轮
+        }
+        MESH_BLOCK req;
+        this->mymesh.popBlock(&req);
+        uint8_t mask = this->busMask(req.block.addr);
+        bool sent = false;
+        for(uint8_t b = 0; b < this->bus_count; b++){
+            if(mask & (1 << b)){
+                sent |= this->buses[b]->send_block(req.block);
+            }
+        }
+        if(sent){
+            this->block_owner[i] = req.from;
+            this->block_owner_addr[i] = req.block.addr;
+            this->block_owner_mask[i] = mask;
+            this->block_owner_time[i] = now;
+        }
+    }
+}
+
+/**
+ * @brief 块读写应答回传
+ * @details 按从机地址匹配请求节点；每秒更新一次寄存器吞吐
+ */
+void APP::blockReplyHandle()
+{
+    MODBUS_BLOCK reply;
+    for(uint8_t b = 0; b < this->bus_count; b++){
+        if(!this->buses[b]->getBlockReply(&reply)){
+            continue;
+        }
+        this->learnRoute(reply.addr, b);
+        for(uint8_t i = 0; i < BLOCK_OWNER_SLOTS; i++){
+            if(this->block_owner[i] != 0 && this->block_owner_addr[i] == reply.addr){
+                this->mymesh.sendBlockReply(this->block_owner[i], reply);
+                this->block_owner[i] = 0;
+                break;
+            }
+        }
+    }
+
+    uint32_t now = Clock::millis();
+    if(now - this->last_rate_time >= 1000){
+        uint32_t regs = 0;
+        for(uint8_t b = 0; b < this->bus_count; b++){
+            regs += this->buses[b]->getBlockRegs();
+        }
+        this->block_rate = (regs - this->block_regs_last) * 1000 / (now - this->last_rate_time);
+        this->block_regs_last = regs;
+        this->last_rate_time = now;
+    }
+}
+
+/**
+ * @brief 回传命令时间链
+ * @details 消息格式："LAT_<addr>_<发出>_<收到>_<出队>_<发送完成>_<回复>"，均为mesh时间（微秒）
+ */
+void APP::sendLatencyTrail(const LAT_TRAIL &trail)
+{
+    String msg = "LAT_" + String(trail.addr) + "_" + String(trail.origin) + "_" + String(trail.rx)
+               + "_" + String(trail.dequeue) + "_" + String(trail.tx_done) + "_" + String(trail.reply);
+    this->mymesh.sendSingle(trail.from, msg);
+}
+
+
+
+/**
+ * @brief 发布从机状态变化
+ * @details 同一条增量/快照消息单播给每个订阅节点，发送失败（无路由）的订阅节点被移除
+ */
+void APP::publishStatus(uint32_t now)
+{
+    String msg;
+    if(!this->uplink.poll(now, msg)){
+        return;
+    }
+    uint32_t subs[UPLINK_SUBSCRIBERS];
+    uint8_t n = this->uplink.getSubscribers(subs);
+    for(uint8_t i = 0; i < n; i++){
+        if(!this->mymesh.sendSingle(subs[i], msg)){
+            this->uplink.unsubscribe(subs[i]);
+        }
+    }
+}
+
+/**
+ * @brief 发送流量记录
+ * @details 每次最多发送TRACE_FLUSH_CHUNK字节，消息格式："TRC"+记录数据
+ */
+void APP::flushTrace()
+{
+    uint32_t collector = this->mymesh.getTraceCollector();
+    if(collector == 0 || this->trace.count() == 0){
+        return;
+    }
+    if(this->trace.isRunning() && this->trace.count() < TRACE_FLUSH_CHUNK){
+        return;//记录中，攒够一块再发
+    }
+    uint8_t chunk[TRACE_FLUSH_CHUNK];
+    size_t n = this->trace.read(chunk, sizeof(chunk));
+    String msg = "TRC";
+    msg.concat((const char *)chunk, n);
+    this->mymesh.sendSingle(collector, msg);
+}
 
 /**
  * @brief modbus执行函数
@@ -60,7 +614,10 @@ void APP::received_handle()
  */
 void APP::modbus_exec() 
 {
-    this->modbus.serialEvent_callback();//解析modbus帧
+    MEMTRACK_HOT_SCOPE("APP::serial_rx");
+    for(uint8_t i = 0; i < this->bus_count; i++){
+        this->buses[i]->serialEvent_callback();//解析modbus帧
+    }
 }
 
 /**
@@ -73,9 +630,18 @@ void APP::modbus_exec()
  */
 void APP::exec() 
 {
-    this->mymesh.update();//执行mymesh节点
+    this->health.begin();
+    this->wheel.advance();
+    this->flows.poll();
+    if(this->mymesh.isStarted()){
+        this->mymesh.update();//执行mymesh节点
+    }
+    this->health.mark(LOOP_STAGE_MESH);
+    for(uint8_t i = 0; i < this->bus_count; i++){
+        this->health.noteBacklog(this->buses[i]->getRxPending(), MODBUS_QUEUE_CAPACITY);
+    }
     // 检查mymesh连接状态
-    if(this->mymesh.getNodeList().size() > 0){
+    if(this->mymesh.getNodeCount() > 0){
         // 有连接：1秒一闪（慢闪）
         blinkInterval = 1000; // 1000ms = 1秒
     } else {
@@ -83,24 +649,92 @@ void APP::exec()
         blinkInterval = 100; // 100ms
     }
 
-    uint32_t sys_cnt = millis();
+    uint32_t sys_cnt = Clock::millis();
     // // 使用time_count进行时间计数，每1ms增加一次
-    if((sys_cnt - this->last_led_time) > blinkInterval){
+    if((sys_cnt - this->last_led_time) > blinkInterval && !this->health.shouldDefer()){//接近预算时跳过，下一轮再闪
         this->led.toggle();
         this->last_led_time = sys_cnt;//更新LED时间戳
     }
+    this->health.mark(LOOP_STAGE_LED);
 
     // 检查mymesh连接状态
     if((sys_cnt - this->last_mesh_time) > 50){//如果1秒没有收到mymesh数据
         this->received_handle();//处理mymesh接收数据
+        this->flushTrace();//发送流量记录
+        this->publishStatus(sys_cnt);//发布从机状态变化
+        MemTrack::sample(sys_cnt);//堆状态采样
         this->last_mesh_time = sys_cnt;//更新mymesh时间戳
     }
+    this->health.mark(LOOP_STAGE_HANDLE);
+
+
+    {
+        MEMTRACK_HOT_SCOPE("APP::serial_rx");
+        for(uint8_t i = 1; i < this->bus_count; i++){
+            this->buses[i]->serialEvent_callback();//软件串口不触发serialEvent()，在主循环中轮询
+        }
+    }
+    // 每条总线每轮最多解析一帧状态，起始总线轮转，任何一条总线都不会饿死其他总线
+    for(uint8_t n = 0; n < this->bus_count; n++){
+        uint8_t i = (this->bus_next + n) % this->bus_count;
+        uint32_t slave_data;
+        {
+            MEMTRACK_HOT_SCOPE("APP::parse");
+            slave_data = this->buses[i]->parseModbusFrame();//解析modbus帧
+        }
+        if(slave_data != 0){//如果从机数据不为0
+            this->statusHandle(slave_data, i, sys_cnt);
+        }
+    }
+    this->bus_next = (this->bus_next + 1) % this->bus_count;
+    this->blockReplyHandle();//块读写应答回传给请求节点
+    this->commandHandle();//应答已释放总线时立即下发下一条命令
+    this->groupPace();//以及正在逐个下发的组命令的下一个成员
+    this->health.mark(LOOP_STAGE_SERIAL);
+
+    if(this->first_frame_ms == 0){
+        for(uint8_t i = 0; i < this->bus_count; i++){
+            if(this->buses[i]->getStats().rx_frames > 0){
+                this->first_frame_ms = sys_cnt != 0 ? sys_cnt : 1;//首个有效从机帧，0保留表示尚未收到
+            }
+        }
+    }
+    if(!this->mymesh.isStarted()){
+        this->mymesh.begin();//串口已处理过一轮，开始后台组网；传输层初始化失败时下一轮按间隔重试
+    }
+    if(!this->startup_reported && this->mymesh.getFirstMessageMs() != 0 && !this->health.shouldDefer()){
+        this->startup_reported = true;//各时间均为复位后毫秒，0表示尚未发生
+        Serial.printf("[启动] 串口就绪 %lu ms，首个从机帧 %lu ms，开始组网 %lu ms，入网 %lu ms，首条mesh消息 %lu ms\n",
+                      (unsigned long)this->serial_ready_ms, (unsigned long)this->first_frame_ms,
+                      (unsigned long)this->mymesh.getStartMs(), (unsigned long)this->mymesh.getFirstJoinMs(),
+                      (unsigned long)this->mymesh.getFirstMessageMs());
+    }
 
+    if(this->mymesh.hasPendingPrint() && !this->health.shouldDefer()){
+        this->mymesh.printPending();//网络状态报告推迟到空闲轮打印
+    }
+    this->health.mark(LOOP_STAGE_PRINT);
+    this->health.end();
+}
 
-    uint32_t slave_data = this->modbus.parseModbusFrame();//解析modbus帧
-    if(slave_data != 0){//如果从机数据不为0
-            this->slave_addr = slave_data >> 16 & 0xFF;//获取从机地址
-            this->slave_sta = slave_data >> 8 & 0xFF;//获取从机状态
+/**
+ * @brief 从机状态帧处理
+ * @param slave_data parseModbusFrame的返回值
+ * @param bus 收到该帧的总线
+ * @param now 当前时间（毫秒）
+ */
+void APP::statusHandle(uint32_t slave_data, uint8_t bus, uint32_t now)
+{
+    this->slave_addr = slave_data >> 16 & 0xFF;//获取从机地址
+    this->slave_sta = slave_data >> 8 & 0xFF;//获取从机状态
+    this->learnRoute(this->slave_addr, bus);
+    this->replyReceived(this->slave_addr);
+    this->flows.notify(FLOW_WAIT_REPLY, this->slave_addr, slave_data);//等待该从机的流程在本轮恢复
+    this->telemetry.record(this->slave_addr, this->slave_sta, now);//保存历史
+    this->uplink.update(this->slave_addr, this->slave_sta, now);//只在变化时上行
+    LAT_TRAIL trail;
+    if(this->latency.onReply(this->slave_addr, this->mymesh.getNodeTime(), &trail)){
+        this->sendLatencyTrail(trail);//采样命令回传完整时间链
     }
 }
 
@@ -21,20 +21,91 @@
 #include "../bsp/uart.hpp"
 #include "../bsp/meshnode.hpp"
 #include "../bsp/modbus.hpp"
+#include "../bsp/trace.hpp"
+#include "../bsp/latency.hpp"
+#include "../bsp/telemetry.hpp"
+#include "../bsp/uplink.hpp"
+#include "../bsp/loophealth.hpp"
+#include "../bsp/time.hpp"
+#include "../bsp/command.hpp"
+#include "../bsp/flow.hpp"
 
+#define BLOCK_REPLY_TIMEOUT 500 //块读写应答超时（毫秒），超时后释放请求槽
+#define BLOCK_OWNER_SLOTS (MESH_BLOCK_QUEUE_CAPACITY + 1) //同时等待应答的块读写请求数
+#define BUS_ROUTE_SIZE 32 //从机地址到总线的路由表容量
+#define BUS_DISCOVERY_MS 30000 //启动后的从机发现期（毫秒）：期间未知地址的命令发往所有总线，之后只发往主总线
+#define CMD_PENDING_SLOTS 8 //同时等待应答的命令数，超出时不统计应答/超时
+#define FLOW_ERR_TIMEOUT 1 //流程结束码：从机未应答
+#define FLOW_ERR_STATE 2 //流程结束码：从机应答的状态与该步应确认的状态不符
+#define FLOW_ERR_PREEMPTED 3 //流程结束码：该从机收到新的mesh命令，流程让出
+
+
+class APP;
+
+/**
+ * @brief 等待从机应答的命令（应答超时由时间轮触发）
+ */
+typedef struct {
+    WheelTimer timer;
+    APP *app;
+    uint8_t addr;//从机地址
+    uint8_t code;//命令码
+    uint8_t mask;//命令占用的总线位掩码，应答或超时前这些总线不再下发新命令
+} CMD_PENDING;
+
+/**
+ * @brief 正在下发的组命令
+ * @details 需要应答的命令不能连发（成员应答会与后续帧和彼此冲突），按总线逐个作为事务下发
+ */
+typedef struct {
+    bool active;//有成员尚未下发
+    uint8_t code;//命令码
+    uint32_t start;//开始下发（micros）
+    uint32_t first;//最早的成员收到命令（相对start）
+    uint32_t last;//最晚的成员收到命令（相对start）
+    uint32_t frames;//已发出的帧数
+    uint8_t count[MODBUS_BUS_MAX];//各总线由本网关下发的成员数
+    uint8_t next[MODBUS_BUS_MAX];//各总线下一个待发成员
+    uint8_t addrs[MODBUS_BUS_MAX][GROUP_MAX_MEMBERS];//各总线的成员地址
+} GROUP_RUN;
 
 // 应用程序请求下位机命令
+// 同一进程中同时只能存在一个APP：mesh/串口回调经MeshNode、TraceRecorder、TelemetryStore、
+// StatusUplink、SlaveGroups的静态instance找到当前对象（析构时置空），MemTrack和Clock也是全局的。
+// 主机上要运行多个网关，每个网关用一个进程（见UdpLoadTest）
 class APP {
 
 public:
     // 构造函数
     APP();
+    APP(SerialPort *port, MeshTransport *transport);//注入串口端口和mesh传输层（Linux本机运行/回放）
+    APP(SerialPort *port, SerialPort *port2, MeshTransport *transport);//注入两条从机总线
     ~APP();
     // 初始化函数
     void begin();
     void modbus_exec();
     void received_handle();
     void exec();
+    TraceRecorder &getTrace() { return trace; }
+    uint32_t getBlockRegsPerSec() { return block_rate; }//块读写吞吐（寄存器/秒，每秒更新）
+    LatencyTracer &getLatency() { return latency; }
+    TelemetryStore &getTelemetry() { return telemetry; }
+    StatusUplink &getUplink() { return uplink; }
+    uint8_t getBusCount() { return bus_count; }
+    bool isDiscovering() { return (int32_t)(Clock::millis() - serial_ready_ms) < BUS_DISCOVERY_MS; }//从机发现期内
+    const MODBUS_STATS &getBusStats(uint8_t bus) { return buses[bus]->getStats(); }
+    MeshNode &getMesh() { return mymesh; }
+    LoopHealth &getHealth() { return health; }
+    TimingWheel &getWheel() { return wheel; }
+    SlaveGroups &getGroups() { return groups; }
+    const CMD_COUNTERS &getCmdCounters(uint8_t code) { return cmd_counters[code]; }//code需小于SLAVE_CMD_COUNT
+    FlowScheduler &getFlows() { return flows; }
+    bool addAdmin(uint32_t nodeId) { return mymesh.addAdmin(nodeId); }//添加管理节点（可经mesh控制流量记录、配置从机组），0或表满返回false
+    bool startReverse(uint8_t addr);//停止→确认停止→反转→确认运行，流程表已满返回false
+    uint32_t getSerialReadyMs() { return serial_ready_ms; }//串口就绪时间（复位后毫秒）
+    uint32_t getFirstFrameMs() { return first_frame_ms; }//收到首个有效从机帧的时间，0表示尚未收到
+    uint32_t getFirstMeshMs() { return mymesh.getFirstMessageMs(); }//收到首条mesh消息的时间，0表示尚未收到
+    uint32_t getMeshJoinMs() { return mymesh.getFirstJoinMs(); }//首次入网的时间，0表示尚未入网
 
 private:
     uint16_t time_count;
@@ -43,11 +114,63 @@ private:
     uint32_t last_mesh_time;
     uint8_t slave_addr;//从机地址
     uint8_t slave_sta;//从机状态
-    uint8_t slave_cmd;//从机命令0:空闲，1:正转，2:反转，3:停止，4:读取状态
+    uint8_t slave_cmd;//从机命令，见SLAVE_CMD与SlaveCommands::TABLE
     LEDDriver led;
     UART uart;
     MODBUS modbus;
+    MODBUS modbus2;//第二条从机总线
+    MODBUS *buses[MODBUS_BUS_MAX];//已配置端口的总线
+    uint8_t bus_count;
+    uint8_t bus_next;//下一轮最先解析的总线，轮转保证公平
+    uint8_t route_addr[BUS_ROUTE_SIZE];//从机地址
+    uint8_t route_bus[BUS_ROUTE_SIZE];//该从机所在总线
+    uint8_t route_count;
+    uint8_t route_next;//路由表满时下一个替换位置
+    uint32_t serial_ready_ms;
+    uint32_t first_frame_ms;
+    bool startup_reported;//启动耗时已打印
     MeshNode mymesh;
+    TraceRecorder trace;//串口/mesh流量记录
+    LatencyTracer latency;//命令各阶段时延
+    TelemetryStore telemetry;//从机状态历史
+    StatusUplink uplink;//从机状态变化上行
+    LoopHealth health;//主循环耗时监测
+    TimingWheel wheel;//事务超时、重发、TTL等定时器，每轮主循环推进一次
+    CMD_COUNTERS cmd_counters[SLAVE_CMD_COUNT];//按命令码统计
+    CMD_PENDING cmd_pending[CMD_PENDING_SLOTS];
+    SlaveGroups groups;//从机组，由控制节点通过mesh配置
+    GROUP_RUN group_run;//正在逐个下发的组命令
+    FlowScheduler flows;//多步操作流程，等待从机应答、mesh命令和超时
+    uint32_t block_owner[BLOCK_OWNER_SLOTS];//块读写请求来源节点，0表示空闲
+    uint8_t block_owner_addr[BLOCK_OWNER_SLOTS];//对应从机地址
+    uint8_t block_owner_mask[BLOCK_OWNER_SLOTS];//请求占用的总线位掩码
+    uint32_t block_owner_time[BLOCK_OWNER_SLOTS];//下发时间
+    uint32_t block_rate;//块读写吞吐（寄存器/秒）
+    uint32_t block_regs_last;//上次统计时的累计寄存器数
+    uint32_t last_rate_time;//上次统计时间
+
+    void blockReplyHandle();
+
+    void flushTrace();
+    void sendLatencyTrail(const LAT_TRAIL &trail);
+    void blockRequestHandle();
+    void commandHandle();
+    void groupHandle();
+    bool groupPace();
+    void groupNoteTx(MODBUS *bus, uint32_t first_done);
+    uint8_t groupMembers(const SLAVE_GROUP *group);
+    void publishStatus(uint32_t now);
+    void initBuses();
+    uint8_t busMask(uint8_t addr);
+    uint8_t busyMask();
+    void learnRoute(uint8_t addr, uint8_t bus);
+    void statusHandle(uint32_t slave_data, uint8_t bus, uint32_t now);
+    void initCommands();
+    void armReply(uint8_t addr, const SLAVE_CMD_DEF *def, uint8_t mask);
+    MODBUS *dispatch(uint8_t addr, uint8_t code);
+    static uint8_t reverseFlow(FLOW *f, void *ctx);
+    void replyReceived(uint8_t addr);
+    static void replyTimeout(void *arg);
 };
 
 #endif // APP_HPP
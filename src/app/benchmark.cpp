@@ -0,0 +1,608 @@
+#include "benchmark.hpp"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <deque>
+#include <thread>
+#include <time.h>
+#include "../bsp/command.hpp"
+
+static const uint32_t bench_sizes[] = {10, 100, 1000};
+static volatile uint32_t bench_sink;  // 防止被测结果被优化掉
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double elapsedNs(BenchClock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+/**
+ * @brief 伪随机数（线性同余），各项测试用固定种子保证结果可复现
+ */
+static uint32_t benchRand(uint32_t &seed)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 16;
+}
+
+/**
+ * @brief 伪随机超时（1~100毫秒），两种实现使用相同序列
+ */
+static uint32_t benchDuration(uint32_t &seed)
+{
+    return 1 + benchRand(seed) % 100;
+}
+
+/**
+ * @brief 测试用串口端口：每次只暴露一段数据（模拟一次串口事件收到的字节），发送直接丢弃
+ */
+class BenchPort : public SerialPort {
+public:
+    bool begin(uint32_t /*baud*/) override { return true; }
+    int available() override { return (int)(len - pos); }
+    int read() override { return pos < len ? data[pos++] : -1; }
+    size_t read(uint8_t *buf, size_t n) override
+    {
+        if (n > len - pos) n = len - pos;
+        memcpy(buf, data + pos, n);
+        pos += n;
+        return n;
+    }
+    size_t write(const uint8_t *buf, size_t n) override { bench_sink += buf[0]; return n; }
+
+    void feed(const uint8_t *p, size_t n) { data = p; len = n; pos = 0; }
+
+private:
+    const uint8_t *data = nullptr;
+    size_t len = 0;
+    size_t pos = 0;
+};
+
+/**
+ * @brief 生成从机应答流
+ * @details 8个从机轮流应答状态帧；noisy为true时帧间插入0~3个随机字节，
+ *          并以约1/200的概率翻转单个比特（模拟线路干扰）
+ */
+static std::string benchStream(bool noisy)
+{
+    std::string stream;
+    uint32_t seed = noisy ? 2 : 1;
+    for (uint32_t i = 0; i < BENCH_STREAM_FRAMES; i++) {
+        uint8_t addr = 1 + i % 8;
+        uint8_t payload[MotorFrame::PAYLOAD_LEN] = {addr, 0x03, 0x01, addr, (uint8_t)(benchRand(seed) % 3), 0x01, 0x00};
+        uint8_t frame[MotorFrame::FRAME_SIZE];
+        MotorFrame::encode(frame, payload);
+        if (noisy) {
+            uint32_t gap = benchRand(seed) % 4;
+            for (uint32_t g = 0; g < gap; g++) {
+                stream.push_back((char)benchRand(seed));
+            }
+            for (uint8_t &b : frame) {
+                if (benchRand(seed) % 200 == 0) {
+                    b ^= 1 << (benchRand(seed) % 8);
+                }
+            }
+        }
+        stream.append((const char *)frame, sizeof(frame));
+    }
+    return stream;
+}
+
+void Benchmark::add(const char *name, uint32_t n, double ns, uint32_t count)
+{
+    results.push_back({name, n, ns, count});
+}
+
+/**
+ * @brief 队列测试实现
+ * @details 逐字节：每次push一个字节后pop一个；批量：每次用writableSpan/commit写入一个串口事件的64字节再逐字节取出
+ */
+void Benchmark::queue()
+{
+    static uint8_t buf[MODBUS_QUEUE_CAPACITY];
+    SimpleQueue q(buf, 1, MODBUS_QUEUE_CAPACITY);
+    uint8_t v = 0;
+
+    auto start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        q.push(&v);
+        q.pop(&v);
+        v++;
+    }
+    add("queue_push_pop", 1, elapsedNs(start) / BENCH_ITERATIONS, v);
+
+    const uint32_t chunk = 64;
+    uint32_t bytes = 0;
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / chunk; i++) {
+        size_t want = chunk;
+        while (want > 0) {
+            void *dest;
+            size_t room = q.writableSpan(&dest);
+            if (room > want) room = want;
+            memset(dest, (int)i, room);
+            q.commit(room);
+            want -= room;
+        }
+        while (q.pop(&v)) {
+            bytes++;
+        }
+    }
+    add("queue_bulk", chunk, elapsedNs(start) / bytes, bytes);
+}
+
+/**
+ * @brief 校验测试实现：13字节状态帧和32字节最长帧
+ */
+void Benchmark::checksums()
+{
+    BenchPort port;
+    MODBUS modbus(&port);
+    UART uart;
+    uint8_t frame[MAX_MODBUS_FRAME];
+    uint32_t seed = 3;
+    for (uint8_t &b : frame) {
+        b = (uint8_t)benchRand(seed);
+    }
+    frame[2] = MotorFrame::CHK_POS - 1;  // 长度字节，calculateXOR按它确定范围
+
+    uint32_t acc = 0;
+    auto start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        frame[3] = (uint8_t)i;
+        acc += modbus.calculateXOR(frame);
+    }
+    add("calculate_xor", MotorFrame::FRAME_SIZE, elapsedNs(start) / BENCH_ITERATIONS, acc & 0xFF);
+
+    const uint8_t lens[] = {MotorFrame::FRAME_SIZE, MAX_MODBUS_FRAME};
+    for (uint8_t len : lens) {
+        acc = 0;
+        start = BenchClock::now();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            frame[0] = (uint8_t)i;
+            acc += uart.CRC16_MudBus(frame, len);
+        }
+        add("crc16_modbus", len, elapsedNs(start) / BENCH_ITERATIONS, acc & 0xFFFF);
+    }
+    bench_sink += acc;
+}
+
+/**
+ * @brief 帧解析测试实现
+ * @details 按64字节一次串口事件喂给MODBUS，每次事件后取出所有完整帧；耗时按字节计
+ */
+void Benchmark::parser()
+{
+    const bool modes[] = {false, true};
+    for (bool noisy : modes) {
+        std::string stream = benchStream(noisy);
+        BenchPort port;
+        MODBUS modbus(&port);
+        modbus.begin();
+        const uint8_t *p = (const uint8_t *)stream.data();
+        auto start = BenchClock::now();
+        for (size_t off = 0; off < stream.size(); off += 64) {
+            size_t n = stream.size() - off < 64 ? stream.size() - off : 64;
+            port.feed(p + off, n);
+            modbus.serialEvent_callback();
+            while (modbus.parseModbusFrame() != 0) {
+            }
+        }
+        add(noisy ? "parse_noisy" : "parse_clean", MotorFrame::FRAME_SIZE, elapsedNs(start) / stream.size(), modbus.getStats().rx_frames);
+    }
+}
+
+/**
+ * @brief 帧构建测试实现（发送端口直接丢弃）
+ */
+void Benchmark::setSlave()
+{
+    BenchPort port;
+    MODBUS modbus(&port);
+    auto start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        modbus.set_slave(1 + i % 8, i % 3);
+    }
+    add("set_slave", MotorFrame::FRAME_SIZE, elapsedNs(start) / BENCH_ITERATIONS, modbus.getStats().tx_frames);
+}
+
+struct BenchWheelEntry {
+    TimingWheel *wheel;
+    WheelTimer timer;
+    uint32_t duration_us;
+    uint32_t fired;
+};
+
+static void benchWheelFire(void *arg)
+{
+    BenchWheelEntry *e = (BenchWheelEntry *)arg;
+    e->fired++;
+    e->wheel->schedule(&e->timer, e->duration_us, benchWheelFire, e);
+}
+
+/**
+ * @brief 定时器对比实现
+ */
+void Benchmark::timers()
+{
+    VirtualClock clock(1000000);
+    Clock::setSource(&clock);
+
+    Timer single(1000);
+    single.start();
+    uint32_t hits = 0;
+    auto start = BenchClock::now();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        hits += single.isTimeout();
+    }
+    add("timer_is_timeout", 1, elapsedNs(start) / BENCH_ITERATIONS, hits);
+
+    for (uint32_t n : bench_sizes) {
+        uint32_t seed = n;
+        std::vector<Timer> list(n);
+        for (Timer &t : list) {
+            t.setDuration(benchDuration(seed));
+            t.start();
+        }
+        uint32_t fired = 0;
+        start = BenchClock::now();
+        for (uint32_t pass = 0; pass < BENCH_LOOP_PASSES; pass++) {
+            clock.advance(1000);
+            for (Timer &t : list) {
+                if (t.isTimeout()) {
+                    fired++;
+                    t.reset();
+                }
+            }
+        }
+        add("timer", n, elapsedNs(start) / BENCH_LOOP_PASSES, fired);
+
+        seed = n;
+        TimingWheel wheel;
+        std::vector<BenchWheelEntry> entries(n);
+        for (BenchWheelEntry &e : entries) {
+            e.wheel = &wheel;
+            e.duration_us = benchDuration(seed) * 1000;
+            e.fired = 0;
+            wheel.schedule(&e.timer, e.duration_us, benchWheelFire, &e);
+        }
+        start = BenchClock::now();
+        for (uint32_t pass = 0; pass < BENCH_LOOP_PASSES; pass++) {
+            clock.advance(1000);
+            wheel.advance();
+        }
+        add("wheel", n, elapsedNs(start) / BENCH_LOOP_PASSES, wheel.getFired());
+    }
+
+    Clock::setSource(nullptr);
+}
+
+/**
+ * @brief 网关选择仿真实现
+ * @details 环境（链路质量游走、公告噪声）和送达结果各用独立的随机序列，两种选择方式面对完全相同的条件
+ */
+void Benchmark::gatewaySelection()
+{
+    const uint8_t gws = 3;
+    const uint32_t ids[gws] = {101, 102, 103};
+    uint8_t reach[SHARD_REACH_BYTES];
+    memset(reach, 0, sizeof(reach));
+    for (uint8_t addr = 1; addr <= 16; addr++) {
+        reach[addr >> 3] |= 1 << (addr & 7);
+    }
+
+    for (uint8_t mode = 0; mode < 2; mode++) {
+        ShardMap shard;
+        shard.setSelf(999);//控制节点本身不是网关
+        GatewaySelector selector;
+        int quality[gws] = {40, 90, 150};
+        uint32_t env_seed = 7;
+        uint32_t rx_seed = 11;
+        uint64_t total_us = 0;
+        uint32_t retries = 0;
+        for (uint32_t i = 0; i < BENCH_GW_COMMANDS; i++) {
+            if (i % 100 == 0) {
+                for (uint8_t g = 0; g < gws; g++) {
+                    quality[g] += (int)(benchRand(env_seed) % 61) - 30;
+                    quality[g] = quality[g] < 10 ? 10 : (quality[g] > 220 ? 220 : quality[g]);
+                }
+            }
+            if (i % 20 == 0) {
+                for (uint8_t g = 0; g < gws; g++) {
+                    int cost = quality[g] + (int)(benchRand(env_seed) % 25) - 12;
+                    shard.announce(ids[g], reach, i, (uint8_t)(cost < 0 ? 0 : cost));
+                }
+            }
+            uint8_t addr = 1 + i % 16;
+            uint32_t gw = mode == 0 ? shard.owner(addr) : selector.select(addr, shard);
+            uint8_t g = 0;
+            while (g < gws && ids[g] != gw) g++;
+            uint32_t draws[3] = {benchRand(rx_seed), benchRand(rx_seed), benchRand(rx_seed)};
+            uint32_t jitter = benchRand(rx_seed) % 2000;
+            uint32_t latency = 0;
+            for (uint8_t attempt = 0; attempt < 3; attempt++) {
+                if ((int)(draws[attempt] % 600) >= quality[g]) break;//送达
+                latency += 100000;//丢失，等待应答超时后重发
+                retries++;
+            }
+            latency += 2000 + quality[g] * 150 + jitter;
+            total_us += latency;
+        }
+        add(mode == 0 ? "gw_latency_naive" : "gw_latency_cost", gws, (double)total_us * 1000.0 / BENCH_GW_COMMANDS, retries);
+        if (mode == 1) {
+            add("gw_switches", gws, 0, selector.getSwitches());
+        }
+    }
+}
+
+/**
+ * @brief 总线负载测试实现
+ * @details 到达间隔按指数分布近似（由均匀随机数取对数），地址和命令随机；
+ *          完成率低于到达率的90%或队列持续增长即视为饱和
+ */
+void Benchmark::gatewayLoad()
+{
+    static const uint32_t rates[] = {10, 20, 40, 60, 80};
+    SLAVEBUS_CONFIG config = {SERIAL_BAUD, BENCH_LOAD_SLAVES, 1000, 5000, 50, 1000, 17, 0};
+    for (uint32_t rate : rates) {
+        VirtualClock clock;
+        Clock::setSource(&clock);
+        VirtualSlaveBus bus(config);
+        MODBUS modbus(&bus);
+        modbus.begin();
+
+        struct Cmd { uint64_t at; uint8_t addr; uint8_t code; };
+        std::deque<Cmd> queue;
+        std::vector<uint32_t> latency;
+        uint32_t seed = 23;
+        uint32_t timeouts = 0;
+        uint64_t next_arrival = 0;
+        uint64_t deadline = 0;
+        bool waiting = false;
+        Cmd current = {0, 0, 0};
+        const uint64_t end = (uint64_t)BENCH_LOAD_SECONDS * 1000000;
+        while (clock.now() < end) {
+            uint64_t now = clock.now();
+            while (next_arrival <= now) {
+                Cmd c = {next_arrival, (uint8_t)(1 + benchRand(seed) % BENCH_LOAD_SLAVES), (uint8_t)(benchRand(seed) % SLAVE_CMD_COUNT)};
+                queue.push_back(c);
+                double u = (benchRand(seed) % 10000 + 1) / 10001.0;
+                next_arrival += (uint64_t)(-log(u) * 1000000.0 / rate);
+            }
+            modbus.serialEvent_callback();
+            uint32_t frame = modbus.parseModbusFrame();
+            if (waiting && frame != 0 && (uint8_t)(frame >> 16) == current.addr) {
+                latency.push_back((uint32_t)(now - current.at));
+                waiting = false;
+            } else if (waiting && now >= deadline) {
+                timeouts++;
+                waiting = false;
+            }
+            if (!waiting && !queue.empty()) {
+                current = queue.front();
+                queue.pop_front();
+                const SLAVE_CMD_DEF *def = SlaveCommands::find(current.code);
+                def->handler(modbus, current.addr, current.code);
+                deadline = now + (uint64_t)def->timeout * 1000;
+                waiting = true;
+            }
+            clock.advance(BENCH_LOAD_POLL_US);
+        }
+        Clock::setSource(nullptr);
+
+        std::sort(latency.begin(), latency.end());
+        uint32_t p50 = latency.empty() ? 0 : latency[latency.size() / 2];
+        uint32_t p99 = latency.empty() ? 0 : latency[latency.size() * 99 / 100];
+        add("load_p50", rate, p50 * 1000.0, (uint32_t)latency.size());
+        add("load_p99", rate, p99 * 1000.0, timeouts);
+        add("load_backlog", rate, 0, (uint32_t)queue.size());
+    }
+}
+
+/**
+ * @brief 换向时序测试实现
+ * @details 一问一答连续进行，收到应答后立即发下一条：
+ *          方向控制模式由Rs485Direction精确等待换向静默；对照模式在每个应答后固定等待BENCH_TURN_FIXED_US。
+ *          另输出线路极限（两帧线路时间+从机应答延时+换向静默）。count为总线检查出的冲突与截断次数
+ */
+void Benchmark::busTurnaround()
+{
+    Rs485Direction timing;
+    timing.begin(nullptr, RS485_DE_NONE, SERIAL_BAUD);//只取换向时序
+    SLAVEBUS_CONFIG config = {SERIAL_BAUD, 4, BENCH_TURN_LATENCY_US, BENCH_TURN_LATENCY_US, 0, 0, 29, timing.getTurnaroundUs()};
+    for (uint8_t mode = 0; mode < 2; mode++) {
+        VirtualClock clock;
+        Clock::setSource(&clock);
+        VirtualSlaveBus bus(config);
+        MODBUS modbus(&bus);
+        if (mode == 0) {
+            modbus.setDirectionControl(BENCH_TURN_DE_PIN);
+        }
+        modbus.begin();
+        uint32_t done = 0;
+        uint64_t resume = 0;
+        modbus.set_slave(1, SLAVE_CMD_READ);
+        while (done < BENCH_TURN_TRANSACTIONS) {
+            modbus.serialEvent_callback();
+            if (modbus.parseModbusFrame() != 0) {
+                done++;
+                resume = clock.now() + (mode == 0 ? 0 : BENCH_TURN_FIXED_US);
+            }
+            if (resume != 0 && clock.now() >= resume) {
+                resume = 0;
+                modbus.set_slave(1 + done % 4, SLAVE_CMD_READ);
+            }
+            clock.advance(BENCH_TURN_POLL_US);
+        }
+        double ns = (double)clock.now() * 1000.0 / done;
+        Clock::setSource(nullptr);
+        add(mode == 0 ? "rs485_txn_dir" : "rs485_txn_fixed", SERIAL_BAUD, ns, bus.getContention() + bus.getTruncated());
+        if (mode == 0) {
+            uint32_t limit_us = 2 * MotorFrame::FRAME_SIZE * timing.getCharUs() + BENCH_TURN_LATENCY_US + timing.getTurnaroundUs();
+            add("rs485_wire_limit", SERIAL_BAUD, limit_us * 1000.0, modbus.getDirection().getStats().waits);
+        }
+    }
+}
+
+/**
+ * @brief 当前线程已用的CPU时间（纳秒）
+ */
+static double threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief pty串口吞吐测试实现
+ * @details 发送线程按每字节10位折算的速率向pty主端写入，接收端是MODBUS使用的LinuxSerialPort（pty从端），
+ *          主线程等待可读事件后读入接收队列并解析出所有完整帧，直到收齐或超过两倍发送时长
+ */
+bool Benchmark::serialThroughput()
+{
+    static const uint32_t bauds[] = {115200, 921600};
+    std::string stream = benchStream(false);
+    bool ok = true;
+    for (uint32_t baud : bauds) {
+        uint32_t bytes_per_s = baud / 10;
+        uint32_t frames = (uint32_t)((uint64_t)bytes_per_s * BENCH_PTY_MS / 1000 / MotorFrame::FRAME_SIZE);
+        size_t total = (size_t)frames * MotorFrame::FRAME_SIZE;
+        int master;
+        char name[64];
+        if (frames > BENCH_STREAM_FRAMES || !LinuxSerialPort::openPty(&master, name, sizeof(name))) {
+            add("pty_frames", baud, 0, 0);
+            ok = false;
+            continue;
+        }
+        LinuxSerialPort writer(master);
+        LinuxSerialPort reader(name);
+        MODBUS modbus(&reader);
+        modbus.begin();//配置为原始模式
+        writer.begin(baud);
+
+        const uint8_t *p = (const uint8_t *)stream.data();
+        std::thread sender([&]() {
+            auto start = BenchClock::now();
+            size_t sent = 0;
+            while (sent < total) {
+                double s = std::chrono::duration<double>(BenchClock::now() - start).count();
+                size_t due = (size_t)(s * bytes_per_s);
+                if (due > total) due = total;
+                if (due > sent) {
+                    sent += writer.write(p + sent, due - sent);
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+            }
+        });
+
+        uint32_t parsed = 0;
+        double cpu = threadCpuNs();
+        auto deadline = BenchClock::now() + std::chrono::milliseconds(2 * BENCH_PTY_MS);
+        while (parsed < frames && BenchClock::now() < deadline) {
+            reader.waitReadable(10);
+            modbus.serialEvent_callback();
+            while (modbus.parseModbusFrame() != 0) {
+                parsed++;
+            }
+        }
+        cpu = threadCpuNs() - cpu;
+        sender.join();
+        uint32_t reads = reader.getReadCalls();
+        add("pty_frames", baud, parsed ? cpu / parsed : 0, parsed);
+        add("pty_lost", baud, 0, frames - parsed);
+        add("pty_read_bytes", baud, 0, reads ? reader.getReadBytes() / reads : 0);
+        ok = ok && parsed == frames;
+    }
+    return ok;
+}
+
+/**
+ * @brief 运行全部测试实现
+ */
+void Benchmark::runAll()
+{
+    results.clear();
+    queue();
+    checksums();
+    parser();
+    setSlave();
+    timers();
+    gatewaySelection();
+    gatewayLoad();
+    busTurnaround();
+}
+
+/**
+ * @brief 打印测试结果实现
+ */
+void Benchmark::report(FILE *out)
+{
+    for (const Result &r : results) {
+        fprintf(out, "%-18s n=%-5u %10.1f ns  count %u\n", r.name.c_str(), r.n, r.ns, r.count);
+    }
+}
+
+/**
+ * @brief JSON输出实现：每项一行，checkBaseline按行读取
+ */
+void Benchmark::writeJson(FILE *out)
+{
+    fprintf(out, "{\"results\":[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(out, "{\"name\":\"%s\",\"n\":%u,\"ns\":%.2f,\"count\":%u}%s\n",
+                r.name.c_str(), r.n, r.ns, r.count, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "]}\n");
+}
+
+/**
+ * @brief 基线比对实现
+ * @details 按名称和规模参数匹配，基线中没有的项不参与比对；
+ *          count不一致说明行为发生变化，同样判为失败
+ */
+bool Benchmark::checkBaseline(const char *path, double tolerance, FILE *out)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(out, "baseline %s not found\n", path);
+        return false;
+    }
+    bool ok = true;
+    size_t matched = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        char name[64];
+        unsigned n, count;
+        double ns;
+        if (sscanf(line, " {\"name\":\"%63[^\"]\",\"n\":%u,\"ns\":%lf,\"count\":%u", name, &n, &ns, &count) != 4) {
+            continue;
+        }
+        for (const Result &r : results) {
+            if (r.name != name || r.n != n) continue;
+            matched++;
+            if (r.ns > ns * (1.0 + tolerance)) {
+                fprintf(out, "REGRESSION %s n=%u: %.1f ns vs baseline %.1f ns (+%.0f%%)\n", name, n, r.ns, ns, (r.ns / ns - 1.0) * 100.0);
+                ok = false;
+            }
+            if (r.count != count) {
+                fprintf(out, "MISMATCH %s n=%u: count %u vs baseline %u\n", name, n, r.count, count);
+                ok = false;
+            }
+        }
+    }
+    fclose(f);
+    if (matched == 0) {
+        fprintf(out, "baseline %s has no matching results\n", path);
+        return false;
+    }
+    return ok;
+}
+
+#endif // __linux__
@@ -0,0 +1,138 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : benchmark.hpp
+ * @brief          : Header for benchmark.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "../bsp/time.hpp"
+#include "../bsp/queue.hpp"
+#include "../bsp/modbus.hpp"
+#include "../bsp/uart.hpp"
+#include "../bsp/linkcost.hpp"
+#include "../bsp/slavebus.hpp"
+#include "../bsp/linuxserial.hpp"
+
+#define BENCH_LOOP_PASSES 2000           ///< 每项定时器测试模拟的主循环轮数（虚拟时间每轮1毫秒）
+#define BENCH_ITERATIONS 200000          ///< 每项小操作测试的调用次数
+#define BENCH_STREAM_FRAMES 20000        ///< 解析测试生成的从机帧数
+#define BENCH_BASELINE_PATH "host/bench_baseline.json" ///< 默认基线文件（相对仓库根目录）
+#define BENCH_TOLERANCE 0.25             ///< 默认容差：比基线慢25%以上判为退化
+#define BENCH_GW_COMMANDS 20000          ///< 网关选择仿真的命令数
+#define BENCH_LOAD_SLAVES 8              ///< 总线负载测试的虚拟从机数
+#define BENCH_LOAD_SECONDS 60            ///< 总线负载测试每档的虚拟运行时间（秒）
+#define BENCH_LOAD_POLL_US 200           ///< 总线负载测试中网关主循环的轮询间隔（微秒）
+#define BENCH_TURN_TRANSACTIONS 2000     ///< 换向测试的问答次数
+#define BENCH_TURN_LATENCY_US 500        ///< 换向测试中从机的应答延时（微秒）
+#define BENCH_TURN_FIXED_US 5000         ///< 对照：没有方向控制时每个应答后的固定等待（微秒）
+#define BENCH_TURN_POLL_US 20            ///< 换向测试中网关的轮询间隔（微秒）
+#define BENCH_TURN_DE_PIN 5              ///< 换向测试使用的DE引脚（主机上只用于启用方向控制）
+#define BENCH_PTY_MS 500                 ///< pty吞吐测试每档的发送时长（毫秒）
+
+/**
+ * @brief 主机端性能测试
+ * @details 覆盖bsp中主循环热路径上的基础操作：队列、校验、帧解析、帧构建和定时器。
+ *          定时器测试在虚拟时钟下运行，测量的是CPU耗时而不是实际时间流逝。
+ *          结果以JSON输出（每行一项），可保存为基线，之后的结果与基线比对，
+ *          超过容差的项判为性能退化。
+ */
+class Benchmark {
+public:
+    void queue();      ///< SimpleQueue逐字节push/pop与批量writableSpan/commit
+    void checksums();  ///< MODBUS::calculateXOR与UART::CRC16_MudBus
+    void parser();     ///< parseModbusFrame：干净流与带噪声流
+    void setSlave();   ///< MODBUS::set_slave帧构建
+
+    /**
+     * @brief 定时器对比：N个独立Timer逐个isTimeout()与时间轮advance()
+     * @details N取10/100/1000，超时1~100毫秒随机分布，到期后立即重新启动；
+     *          另测单次Timer::isTimeout()的耗时
+     */
+    void timers();
+
+    /**
+     * @brief 网关选择仿真：按链路开销选择（带迟滞）与只按分片归属选择的送达时延对比
+     * @details 3个网关都能到达所有从机，真实链路质量随机游走，公告开销带测量噪声；
+     *          时延和丢包由真实质量决定，丢包后等待应答超时再重发。结果的耗时为平均送达时延
+     */
+    void gatewaySelection();
+
+    /**
+     * @brief 总线负载测试：网关经命令表驱动虚拟从机总线，逐档提高到达速率直到饱和
+     * @details 命令随机到达并排队，半双工总线上一问一答，应答超时按命令表计；
+     *          在虚拟时钟下运行，线路时间和从机应答延时都是确定的。
+     *          每档输出p50/p99送达时延（从命令到达到应答解析完成）和完成的命令数
+     */
+    void gatewayLoad();
+
+    /**
+     * @brief RS-485换向测试：方向控制（精确换向静默）与固定延时的一问一答吞吐对比
+     * @details 在虚拟时钟下由仿真总线检查DE时序，count为冲突与截断次数，应为0
+     */
+    void busTurnaround();
+
+    /**
+     * @brief pty串口吞吐测试：按115200和921600波特率折算的字节速率经pty送入从机状态帧
+     * @details 真实的termios/epoll收发路径，实时运行，结果受机器负载影响，不在runAll()中。
+     *          pty_frames耗时为接收线程每帧的CPU时间、count为解析出的帧数；
+     *          pty_lost为丢失的帧数；pty_read_bytes为平均每次read()读到的字节数
+     * @return 两档都没有丢帧返回true
+     */
+    bool serialThroughput();
+
+    /**
+     * @brief 运行全部测试
+     */
+    void runAll();
+
+    /**
+     * @brief 打印测试结果（便于阅读）
+     */
+    void report(FILE *out);
+
+    /**
+     * @brief 以JSON输出测试结果，可直接保存为基线
+     */
+    void writeJson(FILE *out);
+
+    /**
+     * @brief 与基线比对
+     * @param path 基线文件（writeJson的输出）
+     * @param tolerance 容差，耗时超过基线*(1+tolerance)判为退化
+     * @param out 退化项输出
+     * @return 无退化返回true；基线不存在或格式错误返回false
+     */
+    bool checkBaseline(const char *path, double tolerance, FILE *out);
+
+private:
+    struct Result {
+        std::string name;
+        uint32_t n;     ///< 规模参数（定时器数、帧长等），无则为0
+        double ns;      ///< 每次操作耗时（纳秒），定时器对比为每轮主循环耗时
+        uint32_t count; ///< 结果计数（到期次数、解析出的帧数等），用于确认两种实现行为一致
+    };
+
+    std::vector<Result> results;
+
+    void add(const char *name, uint32_t n, double ns, uint32_t count);
+};
+
+#endif // __linux__
+
+#endif // BENCHMARK_HPP
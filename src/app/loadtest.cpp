@@ -0,0 +1,185 @@
+#include "loadtest.hpp"
+
+#if defined(__linux__) && defined(MESH_TRANSPORT_UDP)
+
+#include <algorithm>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+UdpLoadTest *UdpLoadTest::active = nullptr;
+UdpMeshTransport *UdpLoadTest::controller = nullptr;
+
+/**
+ * @brief UdpLoadTest构造函数实现
+ */
+UdpLoadTest::UdpLoadTest(const LOAD_CONFIG &config)
+    : config(config), sent(0), busy(0), joined(0), send_s(0)
+{
+}
+
+/**
+ * @brief 网关进程主函数实现，不返回
+ * @details 串口输出重定向到/dev/null；本网关总线上的从机在启动时已知（相当于已完成一次发现），
+ *          控制节点指定本网关时直接接受。父进程退出时子进程随之结束
+ */
+void UdpLoadTest::gatewayMain(uint16_t index, uint32_t run_ms)
+{
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+    SLAVEBUS_CONFIG bus_config = {SERIAL_BAUD, LOAD_SLAVES, 1000, 5000, 0, 0, index + 1u, 0};
+    VirtualSlaveBus bus(bus_config);
+    UdpMeshTransport transport(LOAD_NODE_BASE + index);
+    APP app(&bus, &transport);
+    app.begin();
+    for (uint8_t addr = 1; addr <= LOAD_SLAVES; addr++) {
+        app.getMesh().noteReach(addr);
+    }
+    uint32_t start = millis();
+    while (millis() - start < run_ms) {
+        app.modbus_exec();
+        app.exec();
+        usleep(LOAD_POLL_US);
+    }
+    _exit(0);
+}
+
+/**
+ * @brief 控制节点收到消息：时间链计入端到端时延，忙消息计数
+ * @details 时间链格式见APP::sendLatencyTrail，第二个字段为控制节点发出时间
+ */
+void UdpLoadTest::onReceive(uint32_t /*from*/, String &msg)
+{
+    if (active == nullptr) return;
+    if (msg.startsWith("LAT_")) {
+        char *end;
+        strtoul(msg.c_str() + 4, &end, 10);
+        if (*end != '_') return;
+        uint32_t origin = strtoul(end + 1, nullptr, 10);
+        active->latency.push_back(controller->getNodeTime() - origin);
+    } else if (msg.startsWith("BUSY_")) {
+        active->busy++;
+    }
+}
+
+/**
+ * @brief 负载测试实现
+ */
+bool UdpLoadTest::run()
+{
+    UdpMeshTransport ctrl(LOAD_NODE_BASE - 1);
+    ctrl.onReceive(onReceive);
+    if (!ctrl.init()) {
+        perror("loadtest: controller transport init");
+        return false;
+    }
+    active = this;
+    controller = &ctrl;
+
+    uint32_t run_ms = LOAD_JOIN_TIMEOUT + config.seconds * 1000 + LOAD_DRAIN_MS + 1000;
+    fflush(stdout);
+    for (uint16_t i = 0; i < config.gateways; i++) {
+        int pid = fork();
+        if (pid == 0) {
+            gatewayMain(i, run_ms);
+        }
+        if (pid > 0) {
+            pids.push_back(pid);
+        }
+    }
+
+    uint32_t start = millis();
+    while (millis() - start < LOAD_JOIN_TIMEOUT && ctrl.getNodeList().size() < config.gateways) {
+        ctrl.update();
+        usleep(1000);
+    }
+    std::list<uint32_t> nodes = ctrl.getNodeList();
+    std::vector<uint32_t> gateways(nodes.begin(), nodes.end());
+    std::sort(gateways.begin(), gateways.end());
+    joined = (uint32_t)gateways.size();
+    if (joined < config.gateways) {
+        stopGateways();
+        active = nullptr;
+        controller = nullptr;
+        return false;
+    }
+
+    uint32_t total = config.rate * config.seconds;
+    uint64_t t0 = Clock::micros64();
+    while (sent < total) {
+        ctrl.update();
+        if (Clock::micros64() - t0 < (uint64_t)sent * 1000000 / config.rate) {
+            usleep(50);
+            continue;
+        }
+        uint32_t gw = gateways[sent % joined];
+        uint8_t addr = 1 + (sent / joined) % LOAD_SLAVES;
+        uint8_t payload[MotorFrame::PAYLOAD_LEN] = {addr, 0x03, 0x01, addr, 0x00, (uint8_t)(sent % SLAVE_CMD_COUNT), 0x00};
+        uint8_t frame[MotorFrame::FRAME_SIZE];
+        MotorFrame::encode(frame, payload);
+        String msg;
+        msg.concat((const char *)frame, sizeof(frame));
+        uint32_t origin = ctrl.getNodeTime();
+        msg.concat((char)MESH_STAMP_TAG);
+        for (uint8_t i = 0; i < 4; i++) {
+            msg.concat((char)(origin >> (8 * i)));
+        }
+        msg.concat((char)LATENCY_FLAG_TRACE);
+        msg.concat((char)MESH_ROUTE_TAG);
+        for (uint8_t i = 0; i < 4; i++) {
+            msg.concat((char)(gw >> (8 * i)));
+        }
+        ctrl.sendSingle(gw, msg);
+        sent++;
+    }
+    send_s = (Clock::micros64() - t0) / 1e6;
+
+    start = millis();
+    while (millis() - start < LOAD_DRAIN_MS) {
+        ctrl.update();
+        usleep(200);
+    }
+    stopGateways();
+    active = nullptr;
+    controller = nullptr;
+    return true;
+}
+
+/**
+ * @brief 结束所有网关进程
+ */
+void UdpLoadTest::stopGateways()
+{
+    for (int pid : pids) {
+        kill(pid, SIGTERM);
+    }
+    for (int pid : pids) {
+        waitpid(pid, nullptr, 0);
+    }
+    pids.clear();
+}
+
+/**
+ * @brief 打印结果实现
+ */
+void UdpLoadTest::report(FILE *out)
+{
+    std::vector<uint32_t> sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+    double secs = send_s > 0 ? send_s : 1e-9;
+    fprintf(out, "gateways     : %u of %u joined\n", joined, config.gateways);
+    fprintf(out, "commands     : %u sent in %.2f s, %zu completed (%.0f cmd/s), %u busy\n",
+            sent, send_s, sorted.size(), sorted.size() / secs, busy);
+    if (!sorted.empty()) {
+        fprintf(out, "latency      : p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", sorted[sorted.size() / 2] / 1000.0,
+                sorted[sorted.size() * 99 / 100] / 1000.0, sorted.back() / 1000.0);
+    }
+}
+
+#endif // __linux__ && MESH_TRANSPORT_UDP
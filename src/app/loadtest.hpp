@@ -0,0 +1,94 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : loadtest.hpp
+ * @brief          : Header for loadtest.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef LOADTEST_HPP
+#define LOADTEST_HPP
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <vector>
+#include "app.hpp"
+#include "../bsp/udpmesh.hpp"
+#include "../bsp/slavebus.hpp"
+
+#if defined(MESH_TRANSPORT_UDP)
+
+#define LOAD_GATEWAYS 100        ///< 默认网关进程数
+#define LOAD_SECONDS 10          ///< 默认发送时长（秒）
+#define LOAD_RATE 1000           ///< 默认总命令速率（条/秒），均分到各网关
+#define LOAD_SLAVES 8            ///< 每个网关总线上的虚拟从机数
+#define LOAD_JOIN_TIMEOUT 10000  ///< 等待所有网关出现在邻居表中的时间（毫秒）
+#define LOAD_DRAIN_MS 1000       ///< 停止发送后等待最后的时间链（毫秒）
+#define LOAD_POLL_US 200         ///< 网关主循环每轮之后的休眠（微秒）
+#define LOAD_NODE_BASE 0x10000   ///< 网关节点ID起始值，控制节点为LOAD_NODE_BASE-1
+
+/**
+ * @brief 负载测试配置
+ */
+typedef struct {
+    uint16_t gateways; ///< 网关进程数
+    uint16_t seconds;  ///< 发送时长（秒）
+    uint32_t rate;     ///< 总命令速率（条/秒）
+} LOAD_CONFIG;
+
+/**
+ * @brief 多进程mesh负载测试（UDP传输层，真实套接字和进程调度）
+ * @details 每个网关是一个子进程：APP接在UdpMeshTransport和虚拟从机总线上，按真实时间运行。
+ *          本进程作为控制节点，在所有网关入网后按配置速率轮流向各网关单播命令帧，
+ *          命令带时间戳附加段（LATENCY_FLAG_TRACE）和指定网关附加段，网关在从机应答后回传时间链。
+ *          统计送达的命令数/秒和端到端时延（控制节点发出到收到时间链），同一台机器上mesh时间天然同步
+ */
+class UdpLoadTest {
+public:
+    UdpLoadTest(const LOAD_CONFIG &config);
+
+    /**
+     * @brief 启动网关进程、发送命令并收集时间链，结束时停止所有网关进程
+     * @return 控制节点传输层初始化失败或网关未全部入网返回false
+     */
+    bool run();
+
+    /**
+     * @brief 打印结果
+     */
+    void report(FILE *out);
+
+    uint32_t getSent() const { return sent; }           ///< 发出的命令数
+    uint32_t getCompleted() const { return (uint32_t)latency.size(); } ///< 收到时间链的命令数
+    uint32_t getBusy() const { return busy; }           ///< 收到的忙消息数
+
+private:
+    LOAD_CONFIG config;
+    std::vector<int> pids;
+    std::vector<uint32_t> latency; ///< 端到端时延（微秒）
+    uint32_t sent;
+    uint32_t busy;
+    uint32_t joined;    ///< 入网的网关数
+    double send_s;      ///< 实际发送时长（秒）
+
+    static UdpLoadTest *active;
+    static UdpMeshTransport *controller;
+
+    static void gatewayMain(uint16_t index, uint32_t run_ms);
+    static void onReceive(uint32_t from, String &msg);
+    void stopGateways();
+};
+
+#endif // MESH_TRANSPORT_UDP
+
+#endif // __linux__
+
+#endif // LOADTEST_HPP
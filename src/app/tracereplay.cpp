@@ -0,0 +1,200 @@
+#include "tracereplay.hpp"
+
+#if defined(__linux__)
+
+#include <chrono>
+#include <thread>
+
+int ReplayPort::read()
+{
+    return rx_pos < rx.size() ? (uint8_t)rx[rx_pos++] : -1;
+}
+
+size_t ReplayPort::read(uint8_t *buf, size_t len)
+{
+    size_t n = rx.size() - rx_pos;
+    if (n > len) n = len;
+    memcpy(buf, rx.data() + rx_pos, n);
+    rx_pos += n;
+    if (rx_pos == rx.size()) {
+        rx.clear();
+        rx_pos = 0;
+    }
+    return n;
+}
+
+size_t ReplayPort::write(const uint8_t *buf, size_t len)
+{
+    tx.push_back(std::string((const char *)buf, len));
+    return len;
+}
+
+void ReplayPort::feed(const uint8_t *data, size_t len)
+{
+    rx.append((const char *)data, len);
+}
+
+/**
+ * @brief 读取无符号LEB128
+ */
+static bool getVarint(FILE *f, uint32_t *v)
+{
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int c = fgetc(f);
+        if (c == EOF) return false;
+        value |= (uint32_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            *v = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 读取记录文件实现
+ */
+bool TraceReplay::load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr) return false;
+    char magic[4];
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, TRACE_MAGIC, 4) != 0 || fgetc(f) != TRACE_VERSION) {
+        fclose(f);
+        return false;
+    }
+
+    records.clear();
+    expected.clear();
+    recorded_s = 0;
+    int type;
+    while ((type = fgetc(f)) != EOF) {
+        Record r;
+        uint32_t len;
+        r.type = (uint8_t)type;
+        if (!getVarint(f, &r.dt_us) || !getVarint(f, &len)) break;
+        r.data.resize(len);
+        if (len && fread(&r.data[0], 1, len, f) != len) break;
+        recorded_s += r.dt_us / 1e6;
+        if (r.type == TRACE_TX) expected.push_back(r.data);
+        records.push_back(r);
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief 录制合成会话实现
+ * @details 每帧：mesh收到命令帧，下发后从机应答，虚拟时钟前进2ms
+ */
+bool TraceReplay::recordSample(const char *path, uint8_t frames)
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);
+    bool ok;
+    {
+        ReplayPort port;
+        ReplayTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();
+        ok = app.getTrace().startFile(path);
+        for (uint8_t i = 0; ok && i < frames; i++) {
+            uint8_t addr = 0x10 + i;
+            uint8_t payload[MotorFrame::PAYLOAD_LEN] = {addr, 0x03, 0x01, 0x00, 0x00, 0x01, 0x00};
+            uint8_t frame[MotorFrame::FRAME_SIZE];
+            MotorFrame::encode(frame, payload);
+            String msg;
+            msg.concat((const char *)frame, MotorFrame::FRAME_SIZE);
+            transport.deliver(1, msg);
+            app.received_handle();
+            clock.advance(1000);
+            payload[4] = 0x02;//应答：状态字段
+            MotorFrame::encode(frame, payload);
+            port.feed(frame, MotorFrame::FRAME_SIZE);
+            app.modbus_exec();
+            app.exec();
+            clock.advance(1000);
+        }
+        app.getTrace().stop();
+    }
+    Clock::setSource(nullptr);
+    return ok;
+}
+
+/**
+ * @brief 回放实现
+ * @details 回放期间安装虚拟时钟，APP看到的时间（准入、主循环50ms节拍、存活检测、分片超时等）
+ *          只按记录中的时间间隔推进，与回放快慢无关；每条记录注入后执行一遍APP的串口接收、命令下发和主循环
+ */
+void TraceReplay::run(bool realtime)
+{
+    VirtualClock clock;
+    Clock::setSource(&clock);//在构造APP之前安装，时间轮等以虚拟时间为起点
+    {
+        ReplayPort port;
+        ReplayTransport transport;
+        APP app(&port, &transport);
+        app.begin();
+        app.exec();//完成分阶段启动（开始组网），之后的mesh消息才有回调接收
+        replay(app, port, transport, clock, realtime);
+    }
+    Clock::setSource(nullptr);
+}
+
+/**
+ * @brief 按记录顺序注入并比对发出的帧
+ */
+void TraceReplay::replay(APP &app, ReplayPort &port, ReplayTransport &transport, VirtualClock &clock, bool realtime)
+{
+    rx_bytes = 0;
+    mesh_msgs = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto due = start;
+    for (const Record &r : records) {
+        clock.advance(r.dt_us);
+        if (realtime) {
+            due += std::chrono::microseconds(r.dt_us);
+            std::this_thread::sleep_until(due);
+        }
+        if (r.type == TRACE_RX) {
+            port.feed((const uint8_t *)r.data.data(), r.data.size());
+            rx_bytes += r.data.size();
+        } else if (r.type == TRACE_MESH && r.data.size() >= 4) {
+            const uint8_t *p = (const uint8_t *)r.data.data();
+            uint32_t from = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+            String msg;
+            msg.concat(r.data.data() + 4, r.data.size() - 4);
+            transport.deliver(from, msg);
+            mesh_msgs++;
+        } else {
+            continue;//TX记录只用于比对
+        }
+        app.modbus_exec();
+        app.received_handle();
+        app.exec();
+    }
+    elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    produced = port.tx.size();
+    tx_matched = 0;
+    for (size_t i = 0; i < produced && i < expected.size(); i++) {
+        if (port.tx[i] == expected[i]) tx_matched++;
+    }
+}
+
+/**
+ * @brief 打印回放报告实现
+ */
+void TraceReplay::report(FILE *out)
+{
+    double secs = elapsed_s > 0 ? elapsed_s : 1e-9;
+    fprintf(out, "records      : %zu (recorded %.3f s, replayed %.3f s)\n", records.size(), recorded_s, elapsed_s);
+    fprintf(out, "rx bytes     : %zu (%.0f B/s)\n", rx_bytes, rx_bytes / secs);
+    fprintf(out, "mesh msgs    : %zu (%.0f msg/s)\n", mesh_msgs, mesh_msgs / secs);
+    fprintf(out, "tx frames    : %zu expected, %zu produced, %zu matched\n", expected.size(), produced, tx_matched);
+    fprintf(out, "equivalent   : %s\n", isEquivalent() ? "yes" : "no");
+}
+
+#endif // __linux__
@@ -0,0 +1,119 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : tracereplay.hpp
+ * @brief          : Header for tracereplay.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef TRACEREPLAY_HPP
+#define TRACEREPLAY_HPP
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "app.hpp"
+
+/**
+ * @brief 回放用串口端口：RX数据来自记录，TX帧保存下来用于比对
+ */
+class ReplayPort : public SerialPort {
+public:
+    bool begin(uint32_t /*baud*/) override { return true; }
+    int available() override { return (int)(rx.size() - rx_pos); }
+    int read() override;
+    size_t read(uint8_t *buf, size_t len) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+
+    void feed(const uint8_t *data, size_t len); ///< 注入串口收到的字节
+    std::vector<std::string> tx; ///< 实际发出的帧（每次write为一帧）
+
+private:
+    std::string rx;
+    size_t rx_pos = 0;
+};
+
+/**
+ * @brief 回放用mesh传输层：由回放驱动注入收到的消息，发出的消息只计数
+ */
+class ReplayTransport : public MeshTransport {
+public:
+    bool init() override { return true; }
+    void update() override {}
+    bool sendBroadcast(String & /*msg*/) override { sent++; return true; }
+    bool sendSingle(uint32_t /*dest*/, String & /*msg*/) override { sent++; return true; }
+    uint32_t getNodeId() override { return 1; }
+    std::list<uint32_t> getNodeList() override { return std::list<uint32_t>(); }
+    uint32_t getNodeTime() override { return (uint32_t)Clock::micros64(); }
+
+    void deliver(uint32_t from, String &msg) { if (receivedCb) receivedCb(from, msg); }
+    uint32_t sent = 0; ///< 发出的mesh消息数
+};
+
+/**
+ * @brief 流量记录回放驱动
+ * @details 读取TraceRecorder生成的文件，把RX字节和mesh消息按记录顺序喂给APP，
+ *          可按记录时间回放或尽快回放；统计吞吐并把APP发出的帧与记录中的TX帧逐帧比对。
+ *          回放期间Clock换成虚拟时钟，按记录的时间间隔推进，两种回放方式的结果相同。
+ *          APP内部有静态单例，回放时进程中不能同时存在其他APP
+ */
+class TraceReplay {
+public:
+    /**
+     * @brief 读取记录文件
+     * @return 文件不存在或格式错误返回false
+     */
+    bool load(const char *path);
+
+    /**
+     * @brief 在虚拟时钟下录制一段合成会话（mesh命令帧和从机应答交替）
+     * @param path 记录文件路径
+     * @param frames 命令帧数
+     * @return 文件打开失败返回false
+     */
+    static bool recordSample(const char *path, uint8_t frames);
+
+    /**
+     * @brief 回放
+     * @param realtime true按记录时间回放，false尽快回放
+     */
+    void run(bool realtime);
+
+    /**
+     * @brief 打印回放报告
+     */
+    void report(FILE *out);
+
+    bool isEquivalent() const { return tx_matched == expected.size() && produced == expected.size(); }
+
+private:
+    struct Record {
+        uint8_t type;
+        uint32_t dt_us;
+        std::string data;
+    };
+
+    std::vector<Record> records;
+    std::vector<std::string> expected; ///< 记录中的TX帧
+    size_t produced = 0;               ///< 回放时实际发出的帧数
+    size_t tx_matched = 0;             ///< 与记录逐帧一致的帧数
+    size_t rx_bytes = 0;
+    size_t mesh_msgs = 0;
+    double elapsed_s = 0;
+    double recorded_s = 0;
+
+    void replay(APP &app, ReplayPort &port, ReplayTransport &transport, VirtualClock &clock, bool realtime);
+};
+
+#endif // __linux__
+
+#endif // TRACEREPLAY_HPP
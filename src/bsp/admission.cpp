@@ -0,0 +1,161 @@
+#include "admission.hpp"
+
+/**
+ * @brief Admission构造函数实现
+ * @details 清空来源节点表，全局预算在begin()中按波特率设置
+ */
+Admission::Admission()
+{
+    memset(table, 0, sizeof(table));
+    global_tokens = 0;
+    global_last_refill = 0;
+    global_rate = 1;
+    admitted = 0;
+    rejected = 0;
+}
+
+/**
+ * @brief 根据串口波特率设置全局预算实现
+ * @param baud 串口波特率
+ */
+void Admission::begin(uint32_t baud)
+{
+    global_rate = baud / ADMISSION_BITS_PER_CMD;//9600波特率约36次/秒
+    if (global_rate == 0) global_rate = 1;
+    global_tokens = ADMISSION_GLOBAL_BURST * ADMISSION_TOKEN_SCALE;
+    global_last_refill = Clock::millis();
+    memset(table, 0, sizeof(table));
+}
+
+/**
+ * @brief 按经过时间补充令牌
+ * @details 速率单位为令牌/秒，令牌按千倍定点保存，因此每毫秒补充rate个单位
+ */
+void Admission::refill(uint32_t &tokens, uint32_t &last, uint32_t now, uint32_t rate, uint32_t burst)
+{
+    uint32_t elapsed = now - last;
+    uint32_t cap = burst * ADMISSION_TOKEN_SCALE;
+    last = now;
+    if (elapsed >= cap / rate) {//已足够补满，同时避免乘法溢出
+        tokens = cap;
+        return;
+    }
+    tokens += elapsed * rate;
+    if (tokens > cap) tokens = cap;
+}
+
+/**
+ * @brief 计算攒够一个令牌还需等待的时间（毫秒）
+ */
+uint32_t Admission::waitTime(uint32_t tokens, uint32_t rate)
+{
+    if (tokens >= ADMISSION_TOKEN_SCALE) return 0;
+    return (ADMISSION_TOKEN_SCALE - tokens + rate - 1) / rate;
+}
+
+/**
+ * @brief 统计活跃来源节点数
+ */
+uint8_t Admission::activeCount(uint32_t now)
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < ADMISSION_TABLE_SIZE; i++) {
+        if (table[i].node_id != 0 && (now - table[i].last_seen) < ADMISSION_ACTIVE_WINDOW) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 查找来源节点的令牌桶，不存在时替换最久未活动的表项
+ */
+Admission::Bucket *Admission::lookup(uint32_t from, uint32_t now)
+{
+    for (uint8_t i = 0; i < ADMISSION_TABLE_SIZE; i++) {
+        if (table[i].node_id == from) {
+            return &table[i];
+        }
+    }
+    Bucket *oldest = &table[0];
+    for (uint8_t i = 0; i < ADMISSION_TABLE_SIZE; i++) {
+        if (table[i].node_id == 0) {
+            oldest = &table[i];
+            break;
+        }
+        if ((now - table[i].last_seen) > (now - oldest->last_seen)) {
+            oldest = &table[i];
+        }
+    }
+    oldest->node_id = from;
+    oldest->tokens = ADMISSION_NODE_BURST * ADMISSION_TOKEN_SCALE;
+    oldest->last_refill = now;
+    oldest->last_seen = now;
+    oldest->notify_until = now;
+    return oldest;
+}
+
+/**
+ * @brief 判断来自某节点的命令是否准入实现
+ * @details 先按全局速率补充全局桶，再按公平份额（全局速率/活跃节点数）补充来源桶，
+ *          两个桶都至少有一个令牌时准入并各扣一个令牌
+ */
+uint32_t Admission::admit(uint32_t from, uint32_t now)
+{
+    Bucket *b = lookup(from, now);
+    b->last_seen = now;
+
+    uint8_t active = activeCount(now);
+    uint32_t node_rate = global_rate / (active ? active : 1);
+    if (node_rate == 0) node_rate = 1;
+
+    refill(global_tokens, global_last_refill, now, global_rate, ADMISSION_GLOBAL_BURST);
+    refill(b->tokens, b->last_refill, now, node_rate, ADMISSION_NODE_BURST);
+
+    if (global_tokens >= ADMISSION_TOKEN_SCALE && b->tokens >= ADMISSION_TOKEN_SCALE) {
+        global_tokens -= ADMISSION_TOKEN_SCALE;
+        b->tokens -= ADMISSION_TOKEN_SCALE;
+        admitted++;
+        return 0;
+    }
+
+    rejected++;
+    uint32_t wait_global = waitTime(global_tokens, global_rate);
+    uint32_t wait_node = waitTime(b->tokens, node_rate);
+    uint32_t wait = wait_global > wait_node ? wait_global : wait_node;
+    return wait ? wait : 1;
+}
+
+/**
+ * @brief 判断是否需要向来源节点发送忙消息实现
+ */
+bool Admission::shouldNotify(uint32_t from, uint32_t now, uint32_t retry_after)
+{
+    Bucket *b = lookup(from, now);
+    if ((int32_t)(now - b->notify_until) < 0) {
+        return false;//本窗口内已通知过
+    }
+    b->notify_until = now + retry_after;
+    return true;
+}
+
+/**
+ * @brief 释放一个全局令牌实现
+ */
+void Admission::refund(uint32_t from)
+{
+    uint32_t cap = ADMISSION_GLOBAL_BURST * ADMISSION_TOKEN_SCALE;
+    global_tokens += ADMISSION_TOKEN_SCALE;
+    if (global_tokens > cap) global_tokens = cap;
+    for (uint8_t i = 0; i < ADMISSION_TABLE_SIZE; i++) {
+        if (table[i].node_id == from) {
+            table[i].tokens += ADMISSION_TOKEN_SCALE;
+            if (table[i].tokens > ADMISSION_NODE_BURST * ADMISSION_TOKEN_SCALE) {
+                table[i].tokens = ADMISSION_NODE_BURST * ADMISSION_TOKEN_SCALE;
+            }
+            break;
+        }
+    }
+    if (admitted) admitted--;
+    rejected++;
+}
@@ -0,0 +1,96 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : admission.hpp
+ * @brief          : Header for admission.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#include <Arduino.h>
+#include "time.hpp"
+
+// 准入控制配置
+#define ADMISSION_TABLE_SIZE 8          // 同时跟踪的来源节点数（固定表，无动态内存）
+#define ADMISSION_NODE_BURST 4          // 单个来源节点允许的突发命令数
+#define ADMISSION_GLOBAL_BURST 8        // 全局突发命令数，应与网关命令队列容量一致
+#define ADMISSION_BITS_PER_CMD 260      // 一问一答：2帧*13字节*10bit
+#define ADMISSION_ACTIVE_WINDOW 1000    // 来源节点活跃判定窗口（毫秒），用于公平分配速率
+#define ADMISSION_TOKEN_SCALE 1000      // 令牌定点倍数：1个令牌=1000个单位
+
+/**
+ * @brief 网关串口链路的准入控制（令牌桶）
+ * @details 全局桶速率由串口波特率推算（每秒可完成的一问一答次数），
+ *          每个来源节点一个桶，速率为全局速率在活跃节点间的均分，
+ *          保证单个控制节点无法占满串口，排队时延上限为 全局突发/全局速率。
+ */
+class Admission {
+public:
+    Admission();
+
+    /**
+     * @brief 根据串口波特率设置全局预算
+     * @param baud 串口波特率
+     */
+    void begin(uint32_t baud);
+
+    /**
+     * @brief 判断来自某节点的命令是否准入
+     * @param from 来源节点ID
+     * @param now 当前时间（毫秒）
+     * @return 0表示准入；非0表示拒绝，值为建议的重试等待时间（毫秒）
+     */
+    uint32_t admit(uint32_t from, uint32_t now);
+
+    /**
+     * @brief 判断是否需要向来源节点发送忙消息
+     * @details 同一重试窗口内只通知一次，避免忙消息本身占用空口
+     * @param from 来源节点ID
+     * @param now 当前时间（毫秒）
+     * @param retry_after 重试等待时间（毫秒）
+     * @return 需要发送返回true
+     */
+    bool shouldNotify(uint32_t from, uint32_t now, uint32_t retry_after);
+
+    /**
+     * @brief 释放一个全局令牌
+     * @details 已准入的命令未能入队时调用，避免令牌被白白消耗
+     */
+    void refund(uint32_t from);
+
+    uint32_t getAdmitted() const { return admitted; }   ///< 准入命令数
+    uint32_t getRejected() const { return rejected; }   ///< 拒绝命令数
+    uint32_t getGlobalRate() const { return global_rate; } ///< 全局速率（命令/秒）
+
+private:
+    struct Bucket {
+        uint32_t node_id;      ///< 来源节点ID，0表示空闲
+        uint32_t tokens;       ///< 当前令牌（定点）
+        uint32_t last_refill;  ///< 上次补充令牌时间
+        uint32_t last_seen;    ///< 最近一次收到命令的时间
+        uint32_t notify_until; ///< 在此时间之前不再重复发送忙消息
+    };
+
+    Bucket table[ADMISSION_TABLE_SIZE];
+    uint32_t global_tokens;
+    uint32_t global_last_refill;
+    uint32_t global_rate;
+    uint32_t admitted;
+    uint32_t rejected;
+
+    Bucket *lookup(uint32_t from, uint32_t now);
+    uint8_t activeCount(uint32_t now);
+    static void refill(uint32_t &tokens, uint32_t &last, uint32_t now, uint32_t rate, uint32_t burst);
+    static uint32_t waitTime(uint32_t tokens, uint32_t rate);
+};
+
+#endif // ADMISSION_HPP
@@ -0,0 +1,10 @@
+#include "command.hpp"
+
+/**
+ * @brief 单命令帧下发实现
+ */
+bool SlaveCommands::sendFrame(MODBUS &bus, uint8_t addr, uint8_t code)
+{
+    bus.set_slave(addr, code);
+    return true;
+}
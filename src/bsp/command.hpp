@@ -0,0 +1,116 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : command.hpp
+ * @brief          : Header for command.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef COMMAND_HPP
+#define COMMAND_HPP
+
+#include <Arduino.h>
+#include "modbus.hpp"
+
+/**
+ * @brief 从机命令码
+ */
+typedef enum {
+    SLAVE_CMD_IDLE = 0,    ///< 空闲
+    SLAVE_CMD_FORWARD = 1, ///< 正转
+    SLAVE_CMD_REVERSE = 2, ///< 反转
+    SLAVE_CMD_STOP = 3,    ///< 停止
+    SLAVE_CMD_READ = 4,    ///< 读取状态
+    SLAVE_CMD_COUNT
+} SLAVE_CMD;
+
+/**
+ * @brief 命令优先级
+ */
+typedef enum {
+    CMD_PRIO_NORMAL, ///< 受准入速率限制
+    CMD_PRIO_HIGH,   ///< 安全相关（停止），速率受限时仍准入，只受队列容量限制
+} CMD_PRIORITY;
+
+/**
+ * @brief 命令处理函数：把命令发到一条总线
+ * @return 已发出返回true
+ */
+typedef bool (*CmdHandler)(MODBUS &bus, uint8_t addr, uint8_t code);
+
+/**
+ * @brief 命令表项
+ */
+typedef struct {
+    uint8_t code;       ///< 命令码，与表中下标相同
+    uint8_t priority;   ///< CMD_PRIORITY
+    bool reply;         ///< 从机是否应答状态帧
+    uint16_t timeout;   ///< 应答超时（毫秒）
+    CmdHandler handler; ///< 下发处理
+    const char *name;   ///< 名称（日志）
+} SLAVE_CMD_DEF;
+
+/**
+ * @brief 单个命令的计数
+ */
+typedef struct {
+    uint32_t sent;     ///< 下发到串口的次数
+    uint32_t replies;  ///< 超时前收到应答的次数
+    uint32_t timeouts; ///< 应答超时的次数
+} CMD_COUNTERS;
+
+/**
+ * @brief 编译期从机命令表
+ * @details 表按命令码排列，查找就是一次带边界检查的下标访问；
+ *          新增命令只需在SLAVE_CMD中加码并在表中加一行，static_assert保证顺序和数量一致
+ */
+class SlaveCommands {
+public:
+    static bool sendFrame(MODBUS &bus, uint8_t addr, uint8_t code); ///< 单命令帧（set_slave）
+
+    static constexpr SLAVE_CMD_DEF TABLE[] = {
+        {SLAVE_CMD_IDLE,    CMD_PRIO_NORMAL, true, 100, sendFrame, "idle"},
+        {SLAVE_CMD_FORWARD, CMD_PRIO_NORMAL, true, 100, sendFrame, "forward"},
+        {SLAVE_CMD_REVERSE, CMD_PRIO_NORMAL, true, 100, sendFrame, "reverse"},
+        {SLAVE_CMD_STOP,    CMD_PRIO_HIGH,   true, 100, sendFrame, "stop"},
+        {SLAVE_CMD_READ,    CMD_PRIO_NORMAL, true, 100, sendFrame, "read"},
+    };
+
+    /**
+     * @brief 查找命令
+     * @return 未知命令码返回nullptr
+     */
+    static constexpr const SLAVE_CMD_DEF *find(uint8_t code)
+    {
+        return code < SLAVE_CMD_COUNT ? &TABLE[code] : nullptr;
+    }
+
+    /**
+     * @brief 网关收到的13字节命令帧是否完整（帧头、长度、帧尾），不校验XOR（与控制节点现有行为一致）
+     */
+    static bool wellFormed(const uint8_t *frame)
+    {
+        return frame[0] == 0x7B && frame[1] == 0x7B && frame[MotorFrame::LEN_POS] == 0x09
+            && frame[MotorFrame::TAIL_POS] == 0x7D && frame[MotorFrame::TAIL_POS + 1] == 0x7D;
+    }
+
+    /**
+     * @brief 表从下标i起是否按命令码顺序排列
+     */
+    static constexpr bool ordered(size_t i)
+    {
+        return i == sizeof(TABLE) / sizeof(TABLE[0]) || (TABLE[i].code == i && ordered(i + 1));
+    }
+};
+
+static_assert(sizeof(SlaveCommands::TABLE) / sizeof(SlaveCommands::TABLE[0]) == SLAVE_CMD_COUNT, "command table must cover every SLAVE_CMD");
+static_assert(SlaveCommands::ordered(0), "command table must be indexed by command code");
+
+#endif // COMMAND_HPP
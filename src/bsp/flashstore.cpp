@@ -0,0 +1,127 @@
+#include "flashstore.hpp"
+
+#if !defined(__linux__)
+#include <EEPROM.h>
+#else
+#include <stdio.h>
+#endif
+
+static uint8_t xorSum(const uint8_t *data, size_t len)
+{
+    uint8_t x = 0;
+    for (size_t i = 0; i < len; i++) {
+        x ^= data[i];
+    }
+    return x;
+}
+
+/**
+ * @brief 读取记录实现
+ */
+bool FlashStore::load(void *data, size_t len)
+{
+    uint8_t buf[FLASH_STORE_SIZE];
+    if (len + 3 > FLASH_STORE_SIZE || !readRaw(buf, len + 3)) return false;
+    if (buf[0] != FLASH_STORE_MAGIC || buf[1] != len || buf[len + 2] != xorSum(buf + 2, len)) {
+        return false;
+    }
+    memcpy(data, buf + 2, len);
+    return true;
+}
+
+/**
+ * @brief 保存记录实现
+ */
+bool FlashStore::save(const void *data, size_t len)
+{
+    uint8_t buf[FLASH_STORE_SIZE];
+    uint8_t old[FLASH_STORE_SIZE];
+    if (len + 3 > FLASH_STORE_SIZE) return false;
+    buf[0] = FLASH_STORE_MAGIC;
+    buf[1] = len;
+    memcpy(buf + 2, data, len);
+    buf[len + 2] = xorSum(buf + 2, len);
+    if (readRaw(old, len + 3) && memcmp(old, buf, len + 3) == 0) {
+        return true;//内容相同，不擦写
+    }
+    if (!writeRaw(buf, len + 3)) return false;
+    writes++;
+    return true;
+}
+
+#if !defined(__linux__)
+
+/**
+ * @brief 首次使用时映射EEPROM仿真区
+ */
+void EepromFlashStore::start()
+{
+    if (!started) {
+        EEPROM.begin(FLASH_STORE_SIZE);
+        started = true;
+    }
+}
+
+bool EepromFlashStore::readRaw(uint8_t *buf, size_t len)
+{
+    start();
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = EEPROM.read(i);
+    }
+    return true;
+}
+
+/**
+ * @brief 写入实现：commit()会擦写整个flash扇区
+ */
+bool EepromFlashStore::writeRaw(const uint8_t *buf, size_t len)
+{
+    start();
+    for (size_t i = 0; i < len; i++) {
+        EEPROM.write(i, buf[i]);
+    }
+    return EEPROM.commit();
+}
+
+#else
+
+/**
+ * @brief SimFlashStore构造函数实现：有文件时从文件恢复内容
+ */
+SimFlashStore::SimFlashStore(const char *path) : path(path)
+{
+    memset(mem, 0xFF, sizeof(mem));
+    if (path != nullptr) {
+        FILE *f = fopen(path, "rb");
+        if (f != nullptr) {
+            size_t n = fread(mem, 1, sizeof(mem), f);
+            (void)n;
+            fclose(f);
+        }
+    }
+}
+
+void SimFlashStore::erase()
+{
+    memset(mem, 0xFF, sizeof(mem));
+    if (path != nullptr) remove(path);
+}
+
+bool SimFlashStore::readRaw(uint8_t *buf, size_t len)
+{
+    memcpy(buf, mem, len);
+    return true;
+}
+
+bool SimFlashStore::writeRaw(const uint8_t *buf, size_t len)
+{
+    memcpy(mem, buf, len);
+    if (path == nullptr) return true;
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr) return false;
+    bool ok = fwrite(mem, 1, sizeof(mem), f) == sizeof(mem);
+    fclose(f);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : flashstore.hpp
+ * @brief          : Header for flashstore.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef FLASHSTORE_HPP
+#define FLASHSTORE_HPP
+
+#include <Arduino.h>
+
+#define FLASH_STORE_SIZE 64     ///< 保存区大小（字节）
+#define FLASH_STORE_MAGIC 0xA5  ///< 记录有效标志
+
+/**
+ * @brief 掉电保存的小块配置存储接口
+ * @details 记录格式：魔数(1) 长度(1) 数据(n) 异或校验(1)，校验失败或长度不符时load返回false
+ */
+class FlashStore {
+public:
+    virtual ~FlashStore() {}
+
+    /**
+     * @brief 读取记录
+     * @param data 输出缓冲区
+     * @param len 记录长度，必须与保存时一致
+     * @return 无有效记录返回false
+     */
+    bool load(void *data, size_t len);
+
+    /**
+     * @brief 保存记录（内容未变化时不写入，减少擦写次数）
+     * @return 写入失败或记录过长返回false
+     */
+    bool save(const void *data, size_t len);
+
+    uint32_t getWrites() const { return writes; } ///< 实际写入次数
+
+protected:
+    virtual bool readRaw(uint8_t *buf, size_t len) = 0;
+    virtual bool writeRaw(const uint8_t *buf, size_t len) = 0;
+
+private:
+    uint32_t writes = 0;
+};
+
+#if !defined(__linux__)
+/**
+ * @brief 基于ESP8266 EEPROM仿真（flash扇区）的存储
+ */
+class EepromFlashStore : public FlashStore {
+protected:
+    bool readRaw(uint8_t *buf, size_t len) override;
+    bool writeRaw(const uint8_t *buf, size_t len) override;
+
+private:
+    bool started = false;
+    void start();
+};
+#else
+/**
+ * @brief 主机模拟的flash存储：内存保存，可选同步到文件以模拟重启后保留
+ */
+class SimFlashStore : public FlashStore {
+public:
+    /**
+     * @param path 文件路径，nullptr表示只保存在内存中
+     */
+    SimFlashStore(const char *path = nullptr);
+
+    void erase(); ///< 模拟整片擦除
+
+protected:
+    bool readRaw(uint8_t *buf, size_t len) override;
+    bool writeRaw(const uint8_t *buf, size_t len) override;
+
+private:
+    const char *path;
+    uint8_t mem[FLASH_STORE_SIZE];
+};
+#endif
+
+#endif // FLASHSTORE_HPP
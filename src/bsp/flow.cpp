@@ -0,0 +1,116 @@
+#include "flow.hpp"
+#include "time.hpp"
+
+/**
+ * @brief FlowScheduler构造函数实现
+ */
+FlowScheduler::FlowScheduler(void *ctx) : ctx(ctx)
+{
+    memset(flows, 0, sizeof(flows));
+    memset(&stats, 0, sizeof(stats));
+    next_deadline = 0;
+    have_deadline = false;
+}
+
+/**
+ * @brief 设置等待条件实现
+ */
+void FlowScheduler::arm(FLOW *f, uint8_t mask, uint8_t key, uint32_t ms)
+{
+    f->wait = mask | FLOW_WAIT_TIME;
+    f->key = key;
+    f->deadline = Clock::millis() + ms;
+    f->event = FLOW_WAIT_NONE;
+}
+
+/**
+ * @brief 恢复一个流程，结束时回收FLOW
+ */
+void FlowScheduler::resume(FLOW *f, uint8_t event, uint32_t value)
+{
+    f->wait = FLOW_WAIT_NONE;
+    f->event = event;
+    f->value = value;
+    if (f->fn(f, ctx) == FLOW_WAITING) {
+        if (!have_deadline || (int32_t)(f->deadline - next_deadline) < 0) {
+            next_deadline = f->deadline;
+            have_deadline = true;
+        }
+        return;
+    }
+    if (f->result == 0) {
+        stats.finished++;
+    } else {
+        stats.failed++;
+    }
+    f->fn = nullptr;
+    stats.active--;
+}
+
+/**
+ * @brief 启动流程实现
+ */
+FLOW *FlowScheduler::spawn(FlowFn fn, uint8_t arg)
+{
+    for (uint16_t i = 0; i < FLOW_MAX; i++) {
+        FLOW *f = &flows[i];
+        if (f->fn != nullptr) continue;
+        memset(f, 0, sizeof(FLOW));
+        f->fn = fn;
+        f->arg = arg;
+        stats.spawned++;
+        stats.active++;
+        if (stats.active > stats.peak) stats.peak = stats.active;
+        resume(f, FLOW_WAIT_NONE, 0);
+        return f->fn != nullptr ? f : nullptr;
+    }
+    stats.rejected++;
+    return nullptr;
+}
+
+/**
+ * @brief 送达事件实现
+ * @details 先记下本次要唤醒的流程再逐个恢复，恢复过程中新启动或重新等待的流程不会被同一事件唤醒
+ */
+uint16_t FlowScheduler::notify(FLOW_WAIT kind, uint8_t key, uint32_t value)
+{
+    if (stats.active == 0) return 0;
+    uint8_t match[(FLOW_MAX + 7) / 8];
+    memset(match, 0, sizeof(match));
+    for (uint16_t i = 0; i < FLOW_MAX; i++) {
+        const FLOW *f = &flows[i];
+        if (f->fn != nullptr && (f->wait & kind) && f->key == key) {
+            match[i >> 3] |= 1 << (i & 7);
+        }
+    }
+    uint16_t woken = 0;
+    for (uint16_t i = 0; i < FLOW_MAX; i++) {
+        if (match[i >> 3] & (1 << (i & 7))) {
+            resume(&flows[i], kind, value);
+            woken++;
+        }
+    }
+    return woken;
+}
+
+/**
+ * @brief 超时检查实现
+ */
+void FlowScheduler::poll()
+{
+    if (!have_deadline) return;
+    uint32_t now = Clock::millis();
+    if ((int32_t)(now - next_deadline) < 0) return;
+    have_deadline = false;
+    for (uint16_t i = 0; i < FLOW_MAX; i++) {
+        FLOW *f = &flows[i];
+        if (f->fn == nullptr || f->wait == FLOW_WAIT_NONE) continue;
+        if ((int32_t)(now - f->deadline) >= 0) {
+            if (f->wait != FLOW_WAIT_TIME) stats.timeouts++;//FLOW_SLEEP到期不算超时
+            resume(f, FLOW_WAIT_TIME, 0);
+        } else if (!have_deadline || (int32_t)(f->deadline - next_deadline) < 0) {
+            next_deadline = f->deadline;
+            have_deadline = true;
+        }
+    }
+}
@@ -0,0 +1,149 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : flow.hpp
+ * @brief          : Header for flow.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef FLOW_HPP
+#define FLOW_HPP
+
+#include <Arduino.h>
+
+#define FLOW_MAX 128  ///< 同时运行的流程数上限，每个流程一个固定大小的FLOW（ESP8266上20字节，共2.5KB）
+
+/**
+ * @brief 流程等待的事件（位掩码，可同时等待多种）
+ */
+typedef enum {
+    FLOW_WAIT_NONE  = 0x00,
+    FLOW_WAIT_REPLY = 0x01,  ///< 从机应答，key为从机地址，value为parseModbusFrame的返回值
+    FLOW_WAIT_MESH  = 0x02,  ///< 发往该从机的mesh命令，key为从机地址，value为来源节点
+    FLOW_WAIT_TIME  = 0x04,  ///< 超时（等待其他事件时总是同时等待超时）
+} FLOW_WAIT;
+
+/**
+ * @brief 流程函数返回值
+ */
+typedef enum {
+    FLOW_WAITING,  ///< 已挂起等待事件
+    FLOW_EXITED,   ///< 已结束，FLOW被回收
+} FLOW_STATUS;
+
+struct FLOW;
+typedef uint8_t (*FlowFn)(FLOW *f, void *ctx);
+
+/**
+ * @brief 流程控制块
+ * @details 无栈：流程函数每次恢复都从头调用，由lc跳到上次挂起处，
+ *          跨挂起点的数据只能放在FLOW的字段中（局部变量不保留）。
+ *          流程所属对象由调度器统一保存并在调用时传入，不占每个FLOW的空间
+ */
+typedef struct FLOW {
+    FlowFn fn;          ///< 流程函数，nullptr表示空闲
+    uint32_t deadline;  ///< 超时时间（毫秒）
+    uint32_t value;     ///< 唤醒事件附带的值
+    uint16_t lc;        ///< 恢复位置（源码行号），0表示从头开始
+    uint8_t wait;       ///< 等待的事件（FLOW_WAIT位掩码）
+    uint8_t key;        ///< 等待的从机地址
+    uint8_t event;      ///< 唤醒的事件（FLOW_WAIT之一）
+    uint8_t arg;        ///< 启动参数
+    uint8_t step;       ///< 流程自用
+    uint8_t result;     ///< 结束码，0表示成功
+} FLOW;
+
+/**
+ * @brief 流程开始，必须是流程函数的第一条语句
+ */
+#define FLOW_BEGIN(f) switch ((f)->lc) { case 0:
+
+/**
+ * @brief 流程正常结束，必须是流程函数的最后一条语句
+ */
+#define FLOW_END(f) } (f)->result = 0; (f)->lc = 0; return FLOW_EXITED
+
+/**
+ * @brief 以结束码r结束流程
+ */
+#define FLOW_EXIT(f, r) do { (f)->result = (r); (f)->lc = 0; return FLOW_EXITED; } while (0)
+
+/**
+ * @brief 挂起，直到mask中的事件到达（key匹配）或ms毫秒后超时；恢复后(f)->event为唤醒的事件
+ * @details 以源码行号作为恢复位置，同一行中最多只能有一个挂起点
+ */
+#define FLOW_AWAIT(f, mask, k, ms) \
+    do { FlowScheduler::arm((f), (mask), (k), (ms)); (f)->lc = __LINE__; return FLOW_WAITING; case __LINE__:; } while (0)
+
+#define FLOW_AWAIT_REPLY(f, addr, ms) FLOW_AWAIT(f, FLOW_WAIT_REPLY, addr, ms)  ///< 等待从机应答
+#define FLOW_SLEEP(f, ms) FLOW_AWAIT(f, FLOW_WAIT_NONE, 0, ms)                   ///< 只等待时间
+
+/**
+ * @brief 流程统计
+ */
+typedef struct {
+    uint32_t spawned;   ///< 启动的流程数
+    uint32_t finished;  ///< 以结束码0结束的流程数
+    uint32_t failed;    ///< 以非0结束码结束的流程数
+    uint32_t rejected;  ///< 流程表已满而未能启动的次数
+    uint32_t timeouts;  ///< 等待超时的次数
+    uint16_t active;    ///< 当前运行的流程数
+    uint16_t peak;      ///< 同时运行的最大流程数
+} FLOW_STATS;
+
+/**
+ * @brief 流程调度器
+ * @details 用于停止→确认停止→反转→确认运行这类多步操作，避免在主循环中手写状态机。
+ *          事件由notify()送达，等待该事件的流程在notify()内立即恢复，与事件在同一轮主循环中处理；
+ *          超时由poll()检查，最近的超时时间未到时poll()不扫描流程表。
+ *          不使用堆，全部流程占用FLOW_MAX个FLOW
+ */
+class FlowScheduler {
+public:
+    /**
+     * @param ctx 流程所属对象，每次调用流程函数时传入
+     */
+    FlowScheduler(void *ctx);
+
+    /**
+     * @brief 启动流程，运行到第一个挂起点
+     * @return 流程表已满返回nullptr；流程已在第一次运行中结束时也返回nullptr
+     */
+    FLOW *spawn(FlowFn fn, uint8_t arg);
+
+    /**
+     * @brief 送达事件，恢复所有等待(kind, key)的流程
+     * @return 恢复的流程数
+     */
+    uint16_t notify(FLOW_WAIT kind, uint8_t key, uint32_t value);
+
+    /**
+     * @brief 检查超时，每轮主循环调用一次
+     */
+    void poll();
+
+    /**
+     * @brief 设置等待条件（由FLOW_AWAIT调用）
+     */
+    static void arm(FLOW *f, uint8_t mask, uint8_t key, uint32_t ms);
+
+    const FLOW_STATS &getStats() const { return stats; }
+
+private:
+    FLOW flows[FLOW_MAX];
+    void *ctx;
+    FLOW_STATS stats;
+    uint32_t next_deadline;  ///< 所有等待中流程最早的超时时间
+    bool have_deadline;
+
+    void resume(FLOW *f, uint8_t event, uint32_t value);
+};
+
+#endif // FLOW_HPP
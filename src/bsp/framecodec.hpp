@@ -0,0 +1,208 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : framecodec.hpp
+ * @brief          : Compile-time frame codec for the slave serial protocol.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef FRAMECODEC_HPP
+#define FRAMECODEC_HPP
+
+#include <Arduino.h>
+
+/**
+ * @brief 异或校验（1字节）
+ */
+struct XorChecksum {
+    static constexpr uint8_t SIZE = 1;
+
+    /**
+     * @brief 计算data[0..len-1]的校验并写入out
+     */
+    static void put(uint8_t *out, const uint8_t *data, uint8_t len)
+    {
+        uint8_t x = 0;
+        for (uint8_t i = 0; i < len; i++) {
+            x ^= data[i];
+        }
+        out[0] = x;
+    }
+};
+
+/**
+ * @brief CRC16校验（Modbus多项式0xA001，初值0xFFFF，低字节在前，与UART::CRC16_MudBus一致）
+ */
+struct Crc16Checksum {
+    static constexpr uint8_t SIZE = 2;
+
+    static void put(uint8_t *out, const uint8_t *data, uint8_t len)
+    {
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (uint8_t b = 0; b < 8; b++) {
+                crc = (crc >> 1) ^ (0xA001 & (uint16_t)-(int16_t)(crc & 1));
+            }
+        }
+        out[0] = (uint8_t)crc;
+        out[1] = (uint8_t)(crc >> 8);
+    }
+};
+
+/**
+ * @brief 编译期帧编解码器
+ * @details 帧格式：Header Header Length 负载 校验 Tail Tail
+ *          Length为最后一个负载字节的下标（与calculateXOR一致），校验覆盖Length字节到最后一个负载字节。
+ *          所有字段偏移和帧长都是编译期常量，缓冲区可按FRAME_SIZE精确分配；
+ *          decode用按位与合并各项检查，没有数据相关的分支。
+ * @tparam Header 帧头字节（重复两次）
+ * @tparam Tail 帧尾字节（重复两次）
+ * @tparam Length 长度字节的值
+ * @tparam Checksum 校验策略：XorChecksum或Crc16Checksum
+ */
+template <uint8_t Header, uint8_t Tail, uint8_t Length, class Checksum>
+class FrameCodec {
+public:
+    static constexpr uint8_t LEN_POS = 2;                        ///< 长度字节下标
+    static constexpr uint8_t PAYLOAD_POS = 3;                    ///< 负载起始下标
+    static constexpr uint8_t PAYLOAD_LEN = Length - LEN_POS;     ///< 负载长度
+    static constexpr uint8_t CHECKED_LEN = Length - LEN_POS + 1; ///< 校验覆盖长度
+    static constexpr uint8_t CHK_POS = Length + 1;               ///< 校验下标
+    static constexpr uint8_t TAIL_POS = CHK_POS + Checksum::SIZE;///< 帧尾下标
+    static constexpr uint8_t FRAME_SIZE = TAIL_POS + 2;          ///< 帧长
+
+    static_assert(Length > LEN_POS, "frame must carry at least one payload byte");
+    static_assert(Length < 250, "frame length must fit in uint8_t");
+
+    /**
+     * @brief 编码
+     * @param frame 输出缓冲区，至少FRAME_SIZE字节
+     * @param payload 负载，PAYLOAD_LEN字节
+     */
+    static void encode(uint8_t *frame, const uint8_t *payload)
+    {
+        frame[0] = Header;
+        frame[1] = Header;
+        frame[LEN_POS] = Length;
+        memcpy(frame + PAYLOAD_POS, payload, PAYLOAD_LEN);
+        Checksum::put(frame + CHK_POS, frame + LEN_POS, CHECKED_LEN);
+        frame[TAIL_POS] = Tail;
+        frame[TAIL_POS + 1] = Tail;
+    }
+
+    /**
+     * @brief 校验一帧
+     * @param frame FRAME_SIZE字节
+     * @return 帧头、长度、校验、帧尾全部正确返回true
+     */
+    static bool decode(const uint8_t *frame)
+    {
+        uint8_t chk[Checksum::SIZE];
+        Checksum::put(chk, frame + LEN_POS, CHECKED_LEN);
+        uint8_t ok = (frame[0] == Header) & (frame[1] == Header) & (frame[LEN_POS] == Length)
+                   & (frame[TAIL_POS] == Tail) & (frame[TAIL_POS + 1] == Tail);
+        for (uint8_t i = 0; i < Checksum::SIZE; i++) {
+            ok &= (frame[CHK_POS + i] == chk[i]);
+        }
+        return ok;
+    }
+
+    /**
+     * @brief 取负载字段
+     * @param frame 已校验的帧
+     * @param field 负载内偏移
+     */
+    static uint8_t field(const uint8_t *frame, uint8_t field)
+    {
+        return frame[PAYLOAD_POS + field];
+    }
+};
+
+/**
+ * @brief 变长帧编解码器
+ * @details 帧格式与FrameCodec相同，但长度字节在运行时从帧中读取：
+ *          帧长 = 长度字节 + 1 + 校验长度 + 2，且不超过MaxFrame。
+ *          解析器收到长度字节后即可确定帧边界和校验位置，过长或过短的长度直接判为无效。
+ * @tparam Header 帧头字节（重复两次）
+ * @tparam Tail 帧尾字节（重复两次）
+ * @tparam MaxFrame 最大帧长（缓冲区大小）
+ * @tparam Checksum 校验策略：XorChecksum或Crc16Checksum
+ */
+template <uint8_t Header, uint8_t Tail, uint8_t MaxFrame, class Checksum>
+class VarFrameCodec {
+public:
+    static constexpr uint8_t LEN_POS = 2;                                   ///< 长度字节下标
+    static constexpr uint8_t PAYLOAD_POS = 3;                               ///< 负载起始下标
+    static constexpr uint8_t OVERHEAD = PAYLOAD_POS + Checksum::SIZE + 2;  ///< 帧头+长度+校验+帧尾
+    static constexpr uint8_t MAX_PAYLOAD = MaxFrame - OVERHEAD;             ///< 最大负载长度
+
+    static_assert(MaxFrame > OVERHEAD, "max frame must hold at least one payload byte");
+    static_assert(MaxFrame < Header && MaxFrame < Tail, "length byte must not alias header/tail");
+
+    /**
+     * @brief 由长度字节计算帧长
+     */
+    static constexpr uint8_t frameSize(uint8_t length) { return length + 1 + Checksum::SIZE + 2; }
+
+    /**
+     * @brief 长度字节是否有效（至少1字节负载且不超过最大帧长）
+     */
+    static constexpr bool validLength(uint8_t length)
+    {
+        return length > LEN_POS && length <= MaxFrame - 1 - Checksum::SIZE - 2;
+    }
+
+    /**
+     * @brief 编码
+     * @param frame 输出缓冲区，至少MaxFrame字节
+     * @param payload 负载
+     * @param len 负载长度，不超过MAX_PAYLOAD
+     * @return 帧长，负载过长返回0
+     */
+    static uint8_t encode(uint8_t *frame, const uint8_t *payload, uint8_t len)
+    {
+        if (len == 0 || len > MAX_PAYLOAD) return 0;
+        uint8_t length = LEN_POS + len;
+        frame[0] = Header;
+        frame[1] = Header;
+        frame[LEN_POS] = length;
+        memcpy(frame + PAYLOAD_POS, payload, len);
+        Checksum::put(frame + length + 1, frame + LEN_POS, len + 1);
+        frame[length + 1 + Checksum::SIZE] = Tail;
+        frame[length + 2 + Checksum::SIZE] = Tail;
+        return frameSize(length);
+    }
+
+    /**
+     * @brief 校验一帧（调用者已按frameSize(frame[LEN_POS])收齐）
+     * @return 长度、帧头、校验、帧尾全部正确返回true
+     */
+    static bool decode(const uint8_t *frame)
+    {
+        uint8_t length = frame[LEN_POS];
+        if (!validLength(length)) return false;
+        uint8_t chk[Checksum::SIZE];
+        Checksum::put(chk, frame + LEN_POS, length - LEN_POS + 1);
+        uint8_t tail = length + 1 + Checksum::SIZE;
+        uint8_t ok = (frame[0] == Header) & (frame[1] == Header) & (frame[tail] == Tail) & (frame[tail + 1] == Tail);
+        for (uint8_t i = 0; i < Checksum::SIZE; i++) {
+            ok &= (frame[length + 1 + i] == chk[i]);
+        }
+        return ok;
+    }
+
+    /**
+     * @brief 负载长度
+     */
+    static uint8_t payloadLen(const uint8_t *frame) { return frame[LEN_POS] - LEN_POS; }
+};
+
+#endif // FRAMECODEC_HPP
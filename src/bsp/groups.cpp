@@ -0,0 +1,76 @@
+#include "groups.hpp"
+
+SlaveGroups *SlaveGroups::instance = nullptr;
+
+/**
+ * @brief SlaveGroups构造函数实现
+ */
+SlaveGroups::SlaveGroups()
+{
+    memset(groups, 0, sizeof(groups));
+    memset(&stats, 0, sizeof(stats));
+    instance = this;
+}
+
+SlaveGroups::~SlaveGroups()
+{
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+/**
+ * @brief 配置组实现：已有的组直接覆盖成员
+ */
+bool SlaveGroups::configure(uint8_t id, uint8_t bus_addr, const uint8_t *members, uint8_t count)
+{
+    if (id == 0 || count > GROUP_MAX_MEMBERS) return false;
+    SLAVE_GROUP *slot = nullptr;
+    for (uint8_t i = 0; i < GROUP_MAX; i++) {
+        if (groups[i].count != 0 && groups[i].id == id) {
+            slot = &groups[i];
+            break;
+        }
+        if (slot == nullptr && groups[i].count == 0) {
+            slot = &groups[i];
+        }
+    }
+    if (slot == nullptr) {
+        return count == 0;//删除不存在的组
+    }
+    slot->id = id;
+    slot->bus_addr = bus_addr;
+    slot->count = count;
+    memcpy(slot->members, members, count);
+    return true;
+}
+
+/**
+ * @brief 解析组配置消息实现
+ */
+bool SlaveGroups::configure(const String &msg)
+{
+    const uint8_t *p = (const uint8_t *)msg.c_str() + 3;
+    if (msg.length() < 6 || msg.length() < 6u + p[2]) return false;
+    return configure(p[0], p[1], p + 3, p[2]);
+}
+
+const SLAVE_GROUP *SlaveGroups::find(uint8_t id) const
+{
+    for (uint8_t i = 0; i < GROUP_MAX; i++) {
+        if (groups[i].count != 0 && groups[i].id == id) {
+            return &groups[i];
+        }
+    }
+    return nullptr;
+}
+
+void SlaveGroups::record(uint32_t completion, uint32_t skew, uint32_t frames)
+{
+    stats.commands++;
+    stats.frames += frames;
+    stats.last_completion = completion;
+    stats.last_skew = skew;
+    if (completion > stats.max_completion) stats.max_completion = completion;
+    if (skew > stats.max_skew) stats.max_skew = skew;
+}
@@ -0,0 +1,106 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : groups.hpp
+ * @brief          : Header for groups.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef GROUPS_HPP
+#define GROUPS_HPP
+
+#include <Arduino.h>
+
+#define GROUP_MAX 8                 ///< 组数上限
+#define GROUP_MAX_MEMBERS 16        ///< 每组成员数上限（一次连发的帧数上限）
+#define GROUP_CFG_TAG "GRP"         ///< 组配置："GRP" 组号 组帧地址 成员数 [成员地址]...，成员数为0删除该组
+#define GROUP_CMD_TAG "GRC"         ///< 组命令："GRC" 组号 命令码
+
+/**
+ * @brief 从机组
+ */
+typedef struct {
+    uint8_t id;        ///< 组号（非0）
+    uint8_t bus_addr;  ///< 组帧地址：从机支持组/广播地址时只发一帧，0表示逐个连发
+    uint8_t count;     ///< 成员数，0表示空闲
+    uint8_t members[GROUP_MAX_MEMBERS]; ///< 成员从机地址
+} SLAVE_GROUP;
+
+/**
+ * @brief 组命令统计（时间由串口线路时间推算，单位微秒）
+ */
+typedef struct {
+    uint32_t commands;          ///< 执行的组命令数
+    uint32_t frames;            ///< 为组命令发出的帧数
+    uint32_t unknown;           ///< 组号未配置而丢弃的组命令数
+    uint32_t not_owned;         ///< 本网关不负责任何成员总线而跳过的组命令数
+    uint32_t last_completion;   ///< 最近一次：从开始下发到最后一帧发送完成
+    uint32_t max_completion;
+    uint32_t last_skew;         ///< 最近一次：第一个成员与最后一个成员收到命令的时间差
+    uint32_t max_skew;
+} GROUP_STATS;
+
+/**
+ * @brief 从机组表
+ * @details 组由管理节点通过mesh配置，其他节点发来的GRP被丢弃（见MeshNode::addAdmin）。
+ *          每条总线上的成员只由其中最小地址的归属网关下发，
+ *          归属未知（还没有网关学到该地址）时不下发。支持组地址的组只发一帧（同Modbus广播，从机不应答）；
+ *          不需要应答的命令把所有成员的命令帧拼成一次串口写入连续发出，成员间的启动偏差只剩帧间的线路时间；
+ *          需要应答的命令逐个作为事务下发，避免成员应答互相冲突
+ */
+class SlaveGroups {
+public:
+    SlaveGroups();
+    ~SlaveGroups();
+
+    /**
+     * @brief 配置一个组
+     * @param id 组号（非0）
+     * @param bus_addr 组帧地址，0表示逐个连发
+     * @param members 成员地址
+     * @param count 成员数，0删除该组
+     * @return 组号为0、成员过多或组表已满返回false
+     */
+    bool configure(uint8_t id, uint8_t bus_addr, const uint8_t *members, uint8_t count);
+
+    /**
+     * @brief 解析组配置消息并配置
+     * @return 格式错误或配置失败返回false
+     */
+    bool configure(const String &msg);
+
+    /**
+     * @brief 查找组
+     * @return 组号未配置返回nullptr
+     */
+    const SLAVE_GROUP *find(uint8_t id) const;
+
+    /**
+     * @brief 登记一次组命令的执行结果
+     * @param completion 从开始下发到最后一帧发送完成（微秒）
+     * @param skew 成员间启动偏差（微秒）
+     * @param frames 发出的帧数
+     */
+    void record(uint32_t completion, uint32_t skew, uint32_t frames);
+
+    void noteUnknown() { stats.unknown++; }
+    void noteNotOwned() { stats.not_owned++; }
+    const GROUP_STATS &getStats() const { return stats; }
+
+    static SlaveGroups *getInstance() { return instance; }
+
+private:
+    SLAVE_GROUP groups[GROUP_MAX];
+    GROUP_STATS stats;
+
+    static SlaveGroups *instance;
+};
+
+#endif // GROUPS_HPP
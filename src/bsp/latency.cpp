@@ -0,0 +1,108 @@
+#include "latency.hpp"
+
+/**
+ * @brief LatencyTracer构造函数实现
+ */
+LatencyTracer::LatencyTracer()
+{
+    memset(pending, 0, sizeof(pending));
+    memset(pending_used, 0, sizeof(pending_used));
+    memset(hist, 0, sizeof(hist));
+    sample_n = LATENCY_SAMPLE_N;
+    sample_count = 0;
+    unmatched = 0;
+}
+
+/**
+ * @brief 计入直方图
+ */
+void LatencyTracer::record(LAT_STAGE stage, uint32_t us)
+{
+    LAT_HIST &h = hist[stage];
+    uint8_t b = 0;
+    while ((us >> (b + 1)) != 0 && b < LATENCY_BUCKETS - 1) {
+        b++;
+    }
+    if (h.buckets[b] != UINT32_MAX) h.buckets[b]++;
+    h.count++;
+    h.sum_us += us;
+    if (us > h.max_us) h.max_us = us;
+}
+
+/**
+ * @brief 串口发送完成后登记命令实现
+ * @details 同一从机地址只保留最新一条，被覆盖的计为unmatched
+ */
+void LatencyTracer::onSent(const LAT_TRAIL &trail)
+{
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < LATENCY_PENDING; i++) {
+        if (pending_used[i] && pending[i].addr == trail.addr) {
+            slot = i;
+            unmatched++;
+            break;
+        }
+        if (!pending_used[i] && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {//表满，替换最早发送的
+        slot = 0;
+        for (uint8_t i = 1; i < LATENCY_PENDING; i++) {
+            if ((int32_t)(pending[i].tx_done - pending[slot].tx_done) < 0) slot = i;
+        }
+        unmatched++;
+    }
+    pending[slot] = trail;
+    pending_used[slot] = true;
+}
+
+/**
+ * @brief 收到从机回复时结算实现
+ */
+bool LatencyTracer::onReply(uint8_t addr, uint32_t now, LAT_TRAIL *out)
+{
+    for (uint8_t i = 0; i < LATENCY_PENDING; i++) {
+        if (!pending_used[i] || pending[i].addr != addr) continue;
+
+        LAT_TRAIL &t = pending[i];
+        pending_used[i] = false;
+        t.reply = now;
+        uint32_t start = t.rx;
+        bool stamped = (t.flags & LATENCY_FLAG_STAMPED) != 0;
+        if (stamped) {
+            record(LAT_STAGE_MESH, t.rx - t.origin);
+            start = t.origin;
+        }
+        record(LAT_STAGE_QUEUE, t.dequeue - t.rx);
+        record(LAT_STAGE_SERIAL, t.tx_done - t.dequeue);
+        record(LAT_STAGE_REPLY, t.reply - t.tx_done);
+        record(LAT_STAGE_TOTAL, t.reply - start);
+
+        if (!stamped) return false;
+        bool report = (t.flags & LATENCY_FLAG_TRACE) != 0;
+        if (sample_n != 0 && ++sample_count >= sample_n) {
+            sample_count = 0;
+            report = true;
+        }
+        if (report) *out = t;
+        return report;
+    }
+    return false;
+}
+
+/**
+ * @brief 估算直方图分位数实现
+ */
+uint32_t LatencyTracer::percentile(LAT_STAGE stage, uint16_t permille) const
+{
+    const LAT_HIST &h = hist[stage];
+    if (h.count == 0) return 0;
+    uint32_t target = (uint32_t)((uint64_t)h.count * permille / 1000);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += h.buckets[b];
+        if (seen > target) return (2UL << b) - 1;
+    }
+    return h.max_us;
+}
@@ -0,0 +1,113 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : latency.hpp
+ * @brief          : Header for latency.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <Arduino.h>
+
+#define LATENCY_BUCKETS 24        ///< 直方图桶数，第i桶为[2^i, 2^(i+1))微秒，最后一桶约16秒以上
+#define LATENCY_PENDING 8         ///< 等待从机回复的命令数
+#define LATENCY_SAMPLE_N 16       ///< 默认每N条带时间戳的命令回传一次完整时间链
+#define LATENCY_FLAG_TRACE 0x01   ///< 命令附加段标志：要求回传时间链
+#define LATENCY_FLAG_STAMPED 0x80 ///< 网关解析到时间戳附加段时置位，origin有效（origin为0也是合法的mesh时间）
+
+// 各阶段
+typedef enum {
+    LAT_STAGE_MESH,     ///< 控制节点发出 -> 网关收到（需命令携带mesh时间戳）
+    LAT_STAGE_QUEUE,    ///< 网关收到 -> 出队下发
+    LAT_STAGE_SERIAL,   ///< 出队 -> 串口发送完成
+    LAT_STAGE_REPLY,    ///< 串口发送完成 -> 从机回复解析完成
+    LAT_STAGE_TOTAL,    ///< 起点（发出或收到）-> 从机回复解析完成
+    LAT_STAGE_COUNT
+} LAT_STAGE;
+
+/**
+ * @brief 一条命令的时间链（mesh时间，微秒）
+ */
+typedef struct {
+    uint8_t addr;        ///< 从机地址
+    uint8_t flags;       ///< LATENCY_FLAG_*
+    uint32_t from;       ///< 来源节点
+    uint32_t origin;     ///< 控制节点发出时间，flags带LATENCY_FLAG_STAMPED时有效
+    uint32_t rx;         ///< 网关收到
+    uint32_t dequeue;    ///< 出队下发
+    uint32_t tx_done;    ///< 串口发送完成
+    uint32_t reply;      ///< 从机回复解析完成
+} LAT_TRAIL;
+
+/**
+ * @brief 单阶段直方图
+ */
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} LAT_HIST;
+
+/**
+ * @brief 命令时延跟踪
+ * @details 命令在串口发送完成后按从机地址登记，收到该地址的回复时结算各阶段时延并计入直方图。
+ *          带origin时间戳的命令每LATENCY_SAMPLE_N条采样一条（或命令自带LATENCY_FLAG_TRACE），
+ *          采样命令的完整时间链由调用者回传给来源节点。
+ */
+class LatencyTracer {
+public:
+    LatencyTracer();
+
+    /**
+     * @brief 设置采样率
+     * @param n 每n条采样一条，0关闭采样
+     */
+    void setSampleRate(uint16_t n) { sample_n = n; }
+
+    /**
+     * @brief 串口发送完成后登记命令
+     * @param trail 已填写addr/from/origin/rx/dequeue/tx_done的时间链
+     */
+    void onSent(const LAT_TRAIL &trail);
+
+    /**
+     * @brief 收到从机回复时结算
+     * @param addr 从机地址
+     * @param now 当前mesh时间（微秒）
+     * @param out 需要回传时输出完整时间链
+     * @return 需要回传给来源节点时返回true
+     */
+    bool onReply(uint8_t addr, uint32_t now, LAT_TRAIL *out);
+
+    const LAT_HIST &getHist(LAT_STAGE stage) const { return hist[stage]; }
+    uint32_t getUnmatched() const { return unmatched; } ///< 被新命令覆盖、未等到回复的登记数
+
+    /**
+     * @brief 估算直方图分位数
+     * @param permille 千分位，如990表示P99
+     * @return 所在桶的上界（微秒）
+     */
+    uint32_t percentile(LAT_STAGE stage, uint16_t permille) const;
+
+private:
+    LAT_TRAIL pending[LATENCY_PENDING];
+    bool pending_used[LATENCY_PENDING];
+    LAT_HIST hist[LAT_STAGE_COUNT];
+    uint16_t sample_n;
+    uint16_t sample_count;
+    uint32_t unmatched;
+
+    void record(LAT_STAGE stage, uint32_t us);
+};
+
+#endif // LATENCY_HPP
@@ -0,0 +1,76 @@
+#include "linkcost.hpp"
+
+/**
+ * @brief LinkCost构造函数实现：初始送达率按100%计
+ */
+LinkCost::LinkCost()
+{
+    delivery = 100 << 8;
+}
+
+void LinkCost::noteDelivery(bool ok)
+{
+    uint16_t sample = ok ? (100 << 8) : 0;
+    delivery = delivery - delivery / LINK_DELIVERY_ALPHA + sample / LINK_DELIVERY_ALPHA;
+}
+
+/**
+ * @brief 计算链路开销实现
+ */
+uint8_t LinkCost::compute(int rssi, uint8_t hops, size_t queued, size_t capacity) const
+{
+    int rssi_cost = (LINK_RSSI_GOOD - rssi) * LINK_RSSI_WEIGHT;
+    if (rssi_cost < 0) rssi_cost = 0;
+    if (rssi_cost > LINK_RSSI_MAX_COST) rssi_cost = LINK_RSSI_MAX_COST;
+    int hop_cost = hops * LINK_HOP_WEIGHT;
+    if (hop_cost > LINK_HOP_MAX_COST) hop_cost = LINK_HOP_MAX_COST;
+    int loss_cost = 100 - getDeliveryPct();
+    int queue_cost = capacity ? (int)(queued * LINK_QUEUE_MAX_COST / capacity) : 0;
+    int cost = rssi_cost + hop_cost + loss_cost + queue_cost;
+    return cost >= SHARD_COST_UNKNOWN ? SHARD_COST_UNKNOWN - 1 : (uint8_t)cost;
+}
+
+/**
+ * @brief GatewaySelector构造函数实现
+ */
+GatewaySelector::GatewaySelector()
+{
+    memset(addrs, 0, sizeof(addrs));
+    memset(chosen, 0, sizeof(chosen));
+    next = 0;
+    switches = 0;
+}
+
+/**
+ * @brief 选择网关实现
+ */
+uint32_t GatewaySelector::select(uint8_t addr, const ShardMap &shard)
+{
+    uint8_t best_cost = 0;
+    uint32_t best = shard.cheapest(addr, &best_cost);
+    if (best == 0) return 0;
+
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < LINK_SELECT_SLOTS; i++) {
+        if (chosen[i] != 0 && addrs[i] == addr) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        slot = next;
+        next = (next + 1) % LINK_SELECT_SLOTS;
+        addrs[slot] = addr;
+        chosen[slot] = best;
+        return best;
+    }
+    uint8_t cost = 0;
+    if (chosen[slot] != best) {
+        if (shard.reaches(chosen[slot], addr, &cost) && cost <= best_cost + LINK_COST_HYSTERESIS) {
+            return chosen[slot];//差距在迟滞范围内，保持原网关
+        }
+        chosen[slot] = best;
+        switches++;
+    }
+    return best;
+}
@@ -0,0 +1,86 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : linkcost.hpp
+ * @brief          : Header for linkcost.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef LINKCOST_HPP
+#define LINKCOST_HPP
+
+#include <Arduino.h>
+#include "shard.hpp"
+
+#define LINK_RSSI_GOOD -45          ///< 不计开销的RSSI（dBm）
+#define LINK_RSSI_WEIGHT 2          ///< RSSI每低1dBm的开销
+#define LINK_RSSI_MAX_COST 100
+#define LINK_HOP_WEIGHT 20          ///< 每跳的开销
+#define LINK_HOP_MAX_COST 80
+#define LINK_QUEUE_MAX_COST 50      ///< 命令队列满时的开销
+#define LINK_DELIVERY_ALPHA 8       ///< 送达率滑动平均：新样本权重1/8
+#define LINK_COST_HYSTERESIS 16     ///< 新网关开销至少低这么多才切换
+#define LINK_SELECT_SLOTS 16        ///< 记录当前所选网关的从机地址数
+
+/**
+ * @brief 网关链路开销
+ * @details 开销 = RSSI项 + 跳数项 + 丢失率(%) + 命令队列占用项，取值0~254，越小越好。
+ *          送达率由从机应答/超时按指数滑动平均统计
+ */
+class LinkCost {
+public:
+    LinkCost();
+
+    /**
+     * @brief 记录一次命令结果
+     * @param ok 超时前收到从机应答
+     */
+    void noteDelivery(bool ok);
+
+    /**
+     * @brief 计算链路开销
+     * @param rssi 上级链路RSSI（dBm）
+     * @param hops 到根节点的跳数
+     * @param queued 等待下发串口的命令数
+     * @param capacity 命令队列容量
+     */
+    uint8_t compute(int rssi, uint8_t hops, size_t queued, size_t capacity) const;
+
+    uint8_t getDeliveryPct() const { return (uint8_t)(delivery >> 8); } ///< 最近送达率（%）
+
+private:
+    uint16_t delivery;  ///< 送达率，8.8定点百分比
+};
+
+/**
+ * @brief 控制节点的网关选择（带迟滞）
+ * @details 每条命令选择能到达该从机、公告开销最低的网关；已选网关仍可达且开销
+ *          不比最优高出LINK_COST_HYSTERESIS时继续使用，避免开销抖动导致来回切换
+ */
+class GatewaySelector {
+public:
+    GatewaySelector();
+
+    /**
+     * @brief 选择网关
+     * @return 网关节点ID，没有网关公告可达时返回0
+     */
+    uint32_t select(uint8_t addr, const ShardMap &shard);
+
+    uint32_t getSwitches() const { return switches; } ///< 已选网关被替换的次数
+
+private:
+    uint8_t addrs[LINK_SELECT_SLOTS];
+    uint32_t chosen[LINK_SELECT_SLOTS];  ///< 0表示空闲
+    uint8_t next;                        ///< 表满时下一个替换位置
+    uint32_t switches;
+};
+
+#endif // LINKCOST_HPP
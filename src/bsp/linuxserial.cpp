@@ -0,0 +1,189 @@
+#include "linuxserial.hpp"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+
+/**
+ * @brief 波特率转换为termios速率常量
+ * @return 不支持的波特率返回B0
+ */
+static speed_t toSpeed(uint32_t baud)
+{
+    switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+    }
+}
+
+/**
+ * @brief LinuxSerialPort构造函数实现（设备路径）
+ */
+LinuxSerialPort::LinuxSerialPort(const char *path)
+    : path(path), fd(-1), epfd(-1), readable(false), read_calls(0), read_bytes(0)
+{
+}
+
+/**
+ * @brief LinuxSerialPort构造函数实现（已打开的文件描述符）
+ */
+LinuxSerialPort::LinuxSerialPort(int fd)
+    : path(nullptr), fd(fd), epfd(-1), readable(false), read_calls(0), read_bytes(0)
+{
+}
+
+/**
+ * @brief LinuxSerialPort析构函数实现，关闭文件描述符
+ */
+LinuxSerialPort::~LinuxSerialPort()
+{
+    if (epfd >= 0) close(epfd);
+    if (fd >= 0) close(fd);
+}
+
+/**
+ * @brief 打开并配置串口实现
+ * @details 原始模式8N1、非阻塞，并把文件描述符加入epoll；termios不支持的波特率直接失败，
+ *          不会悄悄按其他速率打开
+ */
+bool LinuxSerialPort::begin(uint32_t baud)
+{
+    speed_t speed = toSpeed(baud);
+    if (speed == B0) return false;
+    if (fd < 0) {
+        if (path == nullptr) return false;
+        fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0) return false;
+    } else {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {//pty主端不一定支持termios，失败时忽略
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    if (epfd < 0) {
+        epfd = epoll_create1(0);
+        if (epfd < 0) return false;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) return false;
+    }
+    readable = false;
+    return true;
+}
+
+/**
+ * @brief 等待可读事件实现
+ */
+bool LinuxSerialPort::waitReadable(int timeout_ms)
+{
+    if (readable) return true;
+    if (epfd < 0) return false;
+    struct epoll_event ev;
+    int n = epoll_wait(epfd, &ev, 1, timeout_ms);
+    readable = (n > 0) && (ev.events & EPOLLIN);
+    return readable;
+}
+
+/**
+ * @brief 获取可读字节数实现
+ * @details 先用epoll确认可读，再用FIONREAD取就绪字节数
+ */
+int LinuxSerialPort::available()
+{
+    if (!waitReadable(0)) return 0;
+    int n = 0;
+    if (ioctl(fd, FIONREAD, &n) < 0 || n <= 0) {
+        readable = false;
+        return 0;
+    }
+    return n;
+}
+
+int LinuxSerialPort::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+/**
+ * @brief 批量读取实现
+ * @details 一次read()系统调用读走尽可能多的就绪字节，读不满说明已读空
+ */
+size_t LinuxSerialPort::read(uint8_t *buf, size_t len)
+{
+    if (fd < 0 || len == 0) return 0;
+    ssize_t n = ::read(fd, buf, len);
+    read_calls++;
+    if (n <= 0) {
+        readable = false;
+        return 0;
+    }
+    if ((size_t)n < len) readable = false;
+    read_bytes += n;
+    return (size_t)n;
+}
+
+/**
+ * @brief 写入数据实现
+ * @details 非阻塞写，遇到EAGAIN时等待可写（最多100ms）后继续，保证整帧写出
+ */
+size_t LinuxSerialPort::write(const uint8_t *buf, size_t len)
+{
+    size_t sent = 0;
+    while (fd >= 0 && sent < len) {
+        ssize_t n = ::write(fd, buf + sent, len - sent);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            if (poll(&pfd, 1, 100) <= 0) break;
+        } else {
+            break;
+        }
+    }
+    return sent;
+}
+
+/**
+ * @brief 创建一对pty实现
+ */
+bool LinuxSerialPort::openPty(int *master, char *slave_name, size_t name_len)
+{
+    int m = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m < 0) return false;
+    if (grantpt(m) != 0 || unlockpt(m) != 0 || ptsname_r(m, slave_name, name_len) != 0) {
+        close(m);
+        return false;
+    }
+    *master = m;
+    return true;
+}
+
+#endif // __linux__
@@ -0,0 +1,79 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : linuxserial.hpp
+ * @brief          : Header for linuxserial.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef LINUXSERIAL_HPP
+#define LINUXSERIAL_HPP
+
+#if defined(__linux__)
+
+#include "serialport.hpp"
+
+/**
+ * @brief Linux termios串口端口
+ * @details 非阻塞打开串口设备，用epoll等待可读事件，每次可读事件用一次read()
+ *          读走所有就绪字节；可直接包装pty主端文件描述符，便于本机回环测试
+ */
+class LinuxSerialPort : public SerialPort {
+public:
+    /**
+     * @brief 按设备路径构造，begin()时打开
+     * @param path 设备路径，如"/dev/ttyUSB0"
+     */
+    LinuxSerialPort(const char *path);
+
+    /**
+     * @brief 包装已打开的文件描述符（如pty主端），begin()时只配置不再打开
+     * @param fd 文件描述符，析构时关闭
+     */
+    LinuxSerialPort(int fd);
+    ~LinuxSerialPort();
+
+    bool begin(uint32_t baud) override; ///< termios不支持的波特率返回false
+    int available() override;
+    int read() override;
+    size_t read(uint8_t *buf, size_t len) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+
+    /**
+     * @brief 等待可读事件
+     * @param timeout_ms 超时（毫秒），0为立即返回，-1为一直等待
+     * @return 可读返回true
+     */
+    bool waitReadable(int timeout_ms);
+
+    /**
+     * @brief 创建一对pty
+     * @param master 输出主端文件描述符
+     * @param slave_name 输出从端设备路径
+     * @param name_len slave_name缓冲区长度
+     * @return 成功返回true
+     */
+    static bool openPty(int *master, char *slave_name, size_t name_len);
+
+    uint32_t getReadCalls() const { return read_calls; } ///< read()系统调用次数
+    uint32_t getReadBytes() const { return read_bytes; } ///< 累计读取字节数
+
+private:
+    const char *path;
+    int fd;
+    int epfd;
+    bool readable; ///< 上次epoll报告可读且尚未读空
+    uint32_t read_calls;
+    uint32_t read_bytes;
+};
+
+#endif // __linux__
+
+#endif // LINUXSERIAL_HPP
@@ -0,0 +1,135 @@
+#include "liveness.hpp"
+
+/**
+ * @brief PeerLiveness构造函数实现
+ */
+PeerLiveness::PeerLiveness()
+{
+    memset(peers, 0, sizeof(peers));
+    interval = LIVENESS_DEFAULT_INTERVAL;
+    last_sent = 0;
+    last_churn = 0;
+    detections = 0;
+    last_detect_ms = 0;
+    max_detect_ms = 0;
+    recoveries = 0;
+    churn = 0;
+}
+
+/**
+ * @brief 查找表项，id为0时查找空闲表项
+ */
+LIVENESS_PEER *PeerLiveness::find(uint32_t id)
+{
+    for (uint8_t i = 0; i < LIVENESS_PEERS; i++) {
+        if (peers[i].id == id) {
+            return &peers[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 收到节点消息实现
+ * @details 表满时替换最久未收到消息的节点
+ */
+void PeerLiveness::heard(uint32_t id, uint32_t now, uint16_t interval)
+{
+    LIVENESS_PEER *p = find(id);
+    if (p == nullptr) {
+        p = find(0);
+        if (p == nullptr) {
+            p = &peers[0];
+            for (uint8_t i = 1; i < LIVENESS_PEERS; i++) {
+                if ((now - peers[i].last_seen) > (now - p->last_seen)) {
+                    p = &peers[i];
+                }
+            }
+        }
+        p->id = id;
+        p->interval = LIVENESS_DEFAULT_INTERVAL;
+        p->late_avg = LIVENESS_DEFAULT_INTERVAL;//没有样本时按最宽的超时判断
+        p->late_dev = 0;
+        p->alive = true;
+    } else if (!p->alive) {
+        p->alive = true;
+        recoveries++;
+    } else {
+        uint32_t gap = now - p->last_seen;
+        int32_t late = gap > p->interval ? (int32_t)(gap - p->interval) : 0;
+        if (late > 0xFFFF) late = 0xFFFF;
+        int32_t err = late - p->late_avg;
+        p->late_avg = (uint16_t)(p->late_avg + err / 8);
+        p->late_dev = (uint16_t)(p->late_dev + ((err < 0 ? -err : err) - p->late_dev) / 4);
+    }
+    p->last_seen = now;
+    if (interval != 0) {
+        p->interval = interval;
+    }
+}
+
+/**
+ * @brief 失联超时实现
+ */
+uint32_t PeerLiveness::timeout(const LIVENESS_PEER &p)
+{
+    uint32_t margin = (uint32_t)p.late_avg + 4U * p.late_dev;
+    if (margin < LIVENESS_MIN_MARGIN) margin = LIVENESS_MIN_MARGIN;
+    if (margin > p.interval) margin = p.interval;
+    return (uint32_t)p.interval * (LIVENESS_MISSES - 1) + margin;
+}
+
+/**
+ * @brief 拓扑变化实现
+ */
+void PeerLiveness::noteChurn(uint32_t now)
+{
+    churn++;
+    last_churn = now;
+    interval = interval / 2 < LIVENESS_MIN_INTERVAL ? LIVENESS_MIN_INTERVAL : interval / 2;
+}
+
+/**
+ * @brief 传输层断开实现：直接判为失联，不计入超时检测统计
+ */
+void PeerLiveness::dropped(uint32_t id)
+{
+    LIVENESS_PEER *p = find(id);
+    if (p != nullptr) {
+        p->alive = false;
+    }
+}
+
+/**
+ * @brief 失联检查实现
+ */
+void PeerLiveness::check(uint32_t now)
+{
+    for (uint8_t i = 0; i < LIVENESS_PEERS; i++) {
+        LIVENESS_PEER *p = &peers[i];
+        if (p->id == 0 || !p->alive) {
+            continue;
+        }
+        uint32_t silent = now - p->last_seen;
+        if (silent > timeout(*p)) {
+            p->alive = false;
+            detections++;
+            last_detect_ms = silent;
+            if (silent > max_detect_ms) max_detect_ms = silent;
+        }
+    }
+    if ((now - last_churn) > LIVENESS_STABLE_MS && interval < LIVENESS_MAX_INTERVAL) {
+        interval = (uint32_t)interval * 2 > LIVENESS_MAX_INTERVAL ? LIVENESS_MAX_INTERVAL : interval * 2;
+        last_churn = now;//下一次加倍再等一个稳定周期
+    }
+}
+
+bool PeerLiveness::isAlive(uint32_t id) const
+{
+    for (uint8_t i = 0; i < LIVENESS_PEERS; i++) {
+        if (peers[i].id == id) {
+            return peers[i].alive;
+        }
+    }
+    return false;
+}
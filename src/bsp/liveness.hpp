@@ -0,0 +1,117 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : liveness.hpp
+ * @brief          : Header for liveness.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef LIVENESS_HPP
+#define LIVENESS_HPP
+
+#include <Arduino.h>
+
+#define LIVENESS_PEERS 16              ///< 存活表容量
+#define LIVENESS_MIN_INTERVAL 2000     ///< 心跳间隔下限（毫秒），拓扑频繁变化时使用
+#define LIVENESS_MAX_INTERVAL 24000    ///< 心跳间隔上限（毫秒），拓扑稳定时逐步放宽到此
+#define LIVENESS_DEFAULT_INTERVAL 6000 ///< 初始心跳间隔，以及未公告间隔的节点按此判断
+#define LIVENESS_STABLE_MS 60000       ///< 超过该时间无拓扑变化则心跳间隔加倍
+#define LIVENESS_MISSES 3              ///< 最多错过几个间隔判为失联（消息到达抖动大时）
+#define LIVENESS_MIN_MARGIN 500        ///< 失联判定在LIVENESS_MISSES-1个间隔之外的最小余量（毫秒）
+#define LIVENESS_TAG "HB"              ///< 心跳："HB" 间隔(1字节，100毫秒为单位)
+
+/**
+ * @brief 存活表项
+ */
+typedef struct {
+    uint32_t id;        ///< 节点ID，0表示空闲
+    uint32_t last_seen; ///< 最近一次收到该节点任何消息的时间
+    uint16_t interval;  ///< 该节点公告的心跳间隔（毫秒）
+    uint16_t late_avg;  ///< 消息间隔超出心跳间隔部分的平滑均值（毫秒）
+    uint16_t late_dev;  ///< 超出部分的平均偏差（毫秒）
+    bool alive;         ///< false表示已判为失联
+} LIVENESS_PEER;
+
+/**
+ * @brief 节点存活检测
+ * @details 收到节点的任何消息（命令、状态、公告等）都视为该节点存活，心跳不再单独发送；
+ *          只有本机在一个心跳间隔内没有广播过任何消息时才发一条2+1字节的显式心跳。
+ *          心跳间隔随拓扑变化自适应：每次变化减半（更快发现失联），稳定一段时间后加倍（节省空口）。
+ *          失联超时随观察到的到达抖动自适应：每次收到消息，把间隔超出对方公告心跳间隔的部分
+ *          按均值1/8、偏差1/4平滑（同TCP重传超时估计），超时为 (LIVENESS_MISSES-1)个间隔 + 均值+4倍偏差，
+ *          余量限制在[LIVENESS_MIN_MARGIN, 一个间隔]内。新节点从最宽的LIVENESS_MISSES个间隔开始，
+ *          消息准时到达时逐步收紧，检测更快；到达抖动大或偶尔丢心跳时放宽，避免误判。
+ *          失联检测时延（最后一次消息到判定失联）计入统计。
+ */
+class PeerLiveness {
+public:
+    PeerLiveness();
+
+    /**
+     * @brief 收到节点消息
+     * @param interval 对方公告的心跳间隔（毫秒），0表示消息未携带（保持原值）
+     */
+    void heard(uint32_t id, uint32_t now, uint16_t interval = 0);
+
+    /**
+     * @brief 本机发出了广播（所有邻居都能据此确认本机存活）
+     */
+    void noteSent(uint32_t now) { last_sent = now; }
+
+    /**
+     * @brief 拓扑变化，心跳间隔减半
+     */
+    void noteChurn(uint32_t now);
+
+    /**
+     * @brief 传输层报告节点断开
+     */
+    void dropped(uint32_t id);
+
+    /**
+     * @brief 检查失联节点并按稳定时间放宽心跳间隔
+     */
+    void check(uint32_t now);
+
+    /**
+     * @brief 是否需要发送显式心跳
+     */
+    bool heartbeatDue(uint32_t now) const { return (now - last_sent) >= interval; }
+
+    uint16_t getInterval() const { return interval; }  ///< 本机当前心跳间隔（毫秒）
+    const LIVENESS_PEER *getPeer(uint8_t i) const { return &peers[i]; } ///< i小于LIVENESS_PEERS，id为0表示空闲
+    bool isAlive(uint32_t id) const;
+
+    /**
+     * @brief 节点的失联超时（毫秒）
+     */
+    static uint32_t timeout(const LIVENESS_PEER &p);
+
+    uint32_t getDetections() const { return detections; }      ///< 由超时判为失联的次数
+    uint32_t getLastDetectMs() const { return last_detect_ms; } ///< 最近一次失联检测时延（毫秒）
+    uint32_t getMaxDetectMs() const { return max_detect_ms; }   ///< 最大失联检测时延（毫秒）
+    uint32_t getRecoveries() const { return recoveries; }       ///< 判为失联后又收到消息的次数（误判或重新入网）
+    uint32_t getChurn() const { return churn; }                 ///< 拓扑变化次数
+
+private:
+    LIVENESS_PEER peers[LIVENESS_PEERS];
+    uint16_t interval;
+    uint32_t last_sent;
+    uint32_t last_churn;
+    uint32_t detections;
+    uint32_t last_detect_ms;
+    uint32_t max_detect_ms;
+    uint32_t recoveries;
+    uint32_t churn;
+
+    LIVENESS_PEER *find(uint32_t id);
+};
+
+#endif // LIVENESS_HPP
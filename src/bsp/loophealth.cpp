@@ -0,0 +1,79 @@
+#include "loophealth.hpp"
+
+/**
+ * @brief LoopHealth构造函数实现
+ */
+LoopHealth::LoopHealth()
+{
+    budget_us = LOOP_BUDGET_US;
+    pass_start = 0;
+    last_mark = 0;
+    last_stalled = false;
+    backlog = false;
+    passes = 0;
+    stalls = 0;
+    deferred = 0;
+    memset(&current, 0, sizeof(current));
+    memset(&worst, 0, sizeof(worst));
+}
+
+void LoopHealth::begin()
+{
+    pass_start = (uint32_t)Clock::micros64();
+    last_mark = pass_start;
+    backlog = false;
+    memset(current.stage_us, 0, sizeof(current.stage_us));
+}
+
+void LoopHealth::mark(LOOP_STAGE stage)
+{
+    uint32_t now = (uint32_t)Clock::micros64();
+    current.stage_us[stage] += now - last_mark;
+    last_mark = now;
+}
+
+/**
+ * @brief 本轮结束实现
+ */
+void LoopHealth::end()
+{
+    current.total_us = (uint32_t)Clock::micros64() - pass_start;
+    current.when_ms = Clock::millis();
+    passes++;
+    last_stalled = current.total_us > budget_us;
+    if (last_stalled) {
+        stalls++;
+    }
+    if (current.total_us > worst.total_us) {
+        worst = current;
+    }
+}
+
+void LoopHealth::noteBacklog(size_t pending, size_t capacity)
+{
+    if (pending * 100 > capacity * LOOP_BACKLOG_PERCENT) {
+        backlog = true;
+    }
+}
+
+/**
+ * @brief 是否推迟非关键工作实现
+ */
+bool LoopHealth::shouldDefer()
+{
+    uint32_t elapsed = (uint32_t)Clock::micros64() - pass_start;
+    bool defer = backlog || last_stalled || (uint64_t)elapsed * 100 > (uint64_t)budget_us * LOOP_PRESSURE_PERCENT;
+    if (defer) {
+        deferred++;
+    }
+    return defer;
+}
+
+LOOP_STAGE LoopHealth::getWorstStage() const
+{
+    uint8_t s = 0;
+    for (uint8_t i = 1; i < LOOP_STAGE_COUNT; i++) {
+        if (worst.stage_us[i] > worst.stage_us[s]) s = i;
+    }
+    return (LOOP_STAGE)s;
+}
@@ -0,0 +1,93 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : loophealth.hpp
+ * @brief          : Header for loophealth.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef LOOPHEALTH_HPP
+#define LOOPHEALTH_HPP
+
+#include <Arduino.h>
+#include "time.hpp"
+
+#define LOOP_BUDGET_US 20000        ///< 默认单轮主循环预算（微秒），9600波特率下约为19字节的接收时间
+#define LOOP_PRESSURE_PERCENT 50    ///< 本轮已用时间超过预算的该百分比时推迟非关键工作
+#define LOOP_BACKLOG_PERCENT 50     ///< 串口接收队列超过该百分比时推迟非关键工作
+
+// 主循环各阶段
+typedef enum {
+    LOOP_STAGE_MESH,     ///< mymesh.update()及其中触发的回调
+    LOOP_STAGE_LED,      ///< LED闪烁
+    LOOP_STAGE_HANDLE,   ///< 命令下发、流量记录、状态上行（含串口写）
+    LOOP_STAGE_SERIAL,   ///< 串口接收轮询和帧解析
+    LOOP_STAGE_PRINT,    ///< 推迟的状态打印
+    LOOP_STAGE_COUNT
+} LOOP_STAGE;
+
+/**
+ * @brief 一轮主循环的分阶段耗时
+ */
+typedef struct {
+    uint32_t total_us;                     ///< 本轮总耗时
+    uint32_t stage_us[LOOP_STAGE_COUNT];   ///< 各阶段耗时
+    uint32_t when_ms;                      ///< 发生时间
+} LOOP_TRACE;
+
+/**
+ * @brief 主循环健康监测
+ * @details 每轮由begin()/mark()/end()划分阶段并计时，超出预算计为一次卡顿，
+ *          记录最坏一轮的分阶段耗时。本轮已接近预算、上一轮卡顿或串口接收积压时，
+ *          shouldDefer()返回true，调用者据此跳过或推迟LED、打印等非关键工作，优先排空串口接收。
+ */
+class LoopHealth {
+public:
+    LoopHealth();
+
+    void setBudget(uint32_t us) { budget_us = us; } ///< 设置单轮预算（微秒）
+    uint32_t getBudget() const { return budget_us; }
+
+    void begin();                 ///< 本轮开始
+    void mark(LOOP_STAGE stage);  ///< 把上次标记以来的耗时计入stage
+    void end();                   ///< 本轮结束，判定是否卡顿
+
+    /**
+     * @brief 登记串口接收积压
+     * @param pending 接收队列中的字节数
+     * @param capacity 接收队列容量
+     */
+    void noteBacklog(size_t pending, size_t capacity);
+
+    /**
+     * @brief 是否应推迟非关键工作（调用一次视为推迟一次并计数）
+     */
+    bool shouldDefer();
+
+    uint32_t getPasses() const { return passes; }       ///< 总轮数
+    uint32_t getStalls() const { return stalls; }       ///< 超出预算的轮数
+    uint32_t getDeferred() const { return deferred; }   ///< 被推迟的非关键工作次数
+    const LOOP_TRACE &getWorst() const { return worst; } ///< 最坏一轮的分阶段耗时
+    LOOP_STAGE getWorstStage() const;                   ///< 最坏一轮中耗时最长的阶段
+
+private:
+    uint32_t budget_us;
+    uint32_t pass_start;
+    uint32_t last_mark;
+    bool last_stalled;
+    bool backlog;
+    uint32_t passes;
+    uint32_t stalls;
+    uint32_t deferred;
+    LOOP_TRACE current;
+    LOOP_TRACE worst;
+};
+
+#endif // LOOPHEALTH_HPP
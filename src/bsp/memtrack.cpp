@@ -0,0 +1,216 @@
+#include "memtrack.hpp"
+
+MEM_SITE MemTrack::sites[MEMTRACK_MAX_SITES + 1];
+uint8_t MemTrack::site_count = 0;
+MEM_SAMPLE MemTrack::history[MEMTRACK_HISTORY];
+uint8_t MemTrack::history_count = 0;
+uint8_t MemTrack::history_head = 0;
+uint32_t MemTrack::last_sample = 0;
+uint32_t MemTrack::violations = 0;
+bool MemTrack::steady_state = false;
+
+#if defined(__linux__) && defined(__GLIBC__)
+
+#include <malloc.h>
+#include <stdio.h>
+#include <errno.h>
+#include <atomic>
+
+// Linux上替换malloc系列函数，逐次统计分配次数和占用字节
+// 对齐分配也要替换，否则free()会减去从未加上的字节数
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<uint32_t> host_alloc_count(0);
+static std::atomic<size_t> host_bytes_in_use(0);
+
+/**
+ * @brief 统计一次成功的分配
+ */
+static void *countAlloc(void *p)
+{
+    if (p != nullptr) {
+        host_alloc_count++;
+        host_bytes_in_use += malloc_usable_size(p);
+    }
+    return p;
+}
+
+extern "C" void *malloc(size_t size)
+{
+    return countAlloc(__libc_malloc(size));
+}
+
+extern "C" void *calloc(size_t nmemb, size_t size)
+{
+    return countAlloc(__libc_calloc(nmemb, size));
+}
+
+extern "C" void *memalign(size_t alignment, size_t size)
+{
+    return countAlloc(__libc_memalign(alignment, size));
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size)
+{
+    return countAlloc(__libc_memalign(alignment, size));
+}
+
+extern "C" int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *p = countAlloc(__libc_memalign(alignment, size));
+    if (p == nullptr) {
+        return ENOMEM;
+    }
+    *memptr = p;
+    return 0;
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void *p = __libc_realloc(ptr, size);
+    if (p != nullptr) {
+        host_alloc_count++;
+        host_bytes_in_use += malloc_usable_size(p) - old;
+    } else if (size == 0) {
+        host_bytes_in_use -= old;
+    }
+    return p;
+}
+
+extern "C" void free(void *ptr)
+{
+    if (ptr != nullptr) {
+        host_bytes_in_use -= malloc_usable_size(ptr);
+    }
+    __libc_free(ptr);
+}
+
+uint32_t MemTrack::allocCount()
+{
+    return host_alloc_count;
+}
+
+/**
+ * @brief 读取当前堆状态实现（Linux）
+ * @details 按MEMTRACK_HOST_HEAP模拟ESP8266的可用堆，碎片率不可得，记为0
+ */
+void MemTrack::heapStats(uint32_t *free_heap, uint32_t *max_block, uint8_t *frag)
+{
+    *free_heap = freeHeap();
+    *max_block = *free_heap;
+    *frag = 0;
+}
+
+uint32_t MemTrack::freeHeap()
+{
+    size_t used = host_bytes_in_use;
+    return used < MEMTRACK_HOST_HEAP ? MEMTRACK_HOST_HEAP - used : 0;
+}
+
+#else
+
+/**
+ * @brief 目标板上无法逐次统计分配，分配次数由leave()按堆净增长计算
+ */
+uint32_t MemTrack::allocCount()
+{
+    return 0;
+}
+
+/**
+ * @brief 读取当前堆状态实现（ESP8266）
+ */
+void MemTrack::heapStats(uint32_t *free_heap, uint32_t *max_block, uint8_t *frag)
+{
+    *free_heap = ESP.getFreeHeap();
+    *max_block = ESP.getMaxFreeBlockSize();
+    *frag = ESP.getHeapFragmentation();
+}
+
+uint32_t MemTrack::freeHeap()
+{
+    return ESP.getFreeHeap();
+}
+
+#endif
+
+/**
+ * @brief 查找或注册调用点实现
+ */
+MEM_SITE *MemTrack::site(const char *tag, bool hot)
+{
+    for (uint8_t i = 0; i < site_count; i++) {
+        if (sites[i].tag == tag || strcmp(sites[i].tag, tag) == 0) {
+            return &sites[i];
+        }
+    }
+    MEM_SITE *s;
+    if (site_count < MEMTRACK_MAX_SITES) {
+        s = &sites[site_count++];
+        s->tag = tag;
+    } else {
+        s = &sites[MEMTRACK_MAX_SITES];//表满，共用溢出项
+        s->tag = "overflow";
+    }
+    s->hot = s->hot || hot;
+    return s;
+}
+
+/**
+ * @brief 退出调用点作用域时累计统计实现
+ */
+void MemTrack::leave(MEM_SITE *s, uint32_t allocs0, uint32_t free0)
+{
+    uint32_t free_heap = freeHeap();
+    uint32_t allocs = allocCount() - allocs0;
+    if (allocs == 0 && free_heap < free0) {
+        allocs = 1;//目标板：作用域内堆净增长，至少发生过一次分配
+    }
+    s->calls++;
+    s->allocs += allocs;
+    s->bytes += (int32_t)(free0 - free_heap);
+
+    if (steady_state && s->hot && allocs > 0) {
+        violations++;
+#if defined(__linux__) && defined(MEMTRACK_ABORT_ON_VIOLATION)
+        fprintf(stderr, "memtrack: hot path '%s' allocated %u times in steady state\n", s->tag, (unsigned)allocs);
+        abort();
+#endif
+    }
+}
+
+/**
+ * @brief 按间隔采样堆状态实现
+ */
+void MemTrack::sample(uint32_t now)
+{
+    if (history_count > 0 && (now - last_sample) < MEMTRACK_SAMPLE_INTERVAL) {
+        return;
+    }
+    last_sample = now;
+    MEM_SAMPLE *m = &history[history_head];
+    m->time_s = now / 1000;
+    heapStats(&m->free_heap, &m->max_block, &m->frag);
+    history_head = (history_head + 1) % MEMTRACK_HISTORY;
+    if (history_count < MEMTRACK_HISTORY) history_count++;
+}
+
+/**
+ * @brief 读取堆状态历史实现
+ */
+const MEM_SAMPLE *MemTrack::getHistory(uint8_t index)
+{
+    if (index >= history_count) return nullptr;
+    uint8_t oldest = (history_head + MEMTRACK_HISTORY - history_count) % MEMTRACK_HISTORY;
+    return &history[(oldest + index) % MEMTRACK_HISTORY];
+}
@@ -0,0 +1,129 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : memtrack.hpp
+ * @brief          : Header for memtrack.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef MEMTRACK_HPP
+#define MEMTRACK_HPP
+
+#include <Arduino.h>
+
+#define MEMTRACK_MAX_SITES 16            ///< 最多跟踪的调用点数
+#define MEMTRACK_HISTORY 32              ///< 堆状态历史采样点数
+#define MEMTRACK_SAMPLE_INTERVAL 10000   ///< 堆状态采样间隔（毫秒）
+#define MEMTRACK_HOST_HEAP 40960         ///< Linux上模拟的堆大小，与ESP8266可用堆相当
+
+/**
+ * @brief 单个调用点的分配统计
+ */
+typedef struct {
+    const char *tag;    ///< 调用点标签
+    uint32_t calls;     ///< 进入次数
+    uint32_t allocs;    ///< 分配次数（仅Linux可逐次统计，目标板上为净增长次数）
+    int32_t bytes;      ///< 净增加的堆字节数
+    bool hot;           ///< 热路径：稳态下不允许分配
+} MEM_SITE;
+
+/**
+ * @brief 堆状态采样
+ */
+typedef struct {
+    uint32_t time_s;      ///< 采样时间（秒）
+    uint32_t free_heap;   ///< 空闲堆
+    uint32_t max_block;   ///< 最大空闲块
+    uint8_t frag;         ///< 碎片率（%）
+} MEM_SAMPLE;
+
+/**
+ * @brief 堆分配跟踪
+ * @details 用MEMTRACK_SCOPE/MEMTRACK_HOT_SCOPE标记调用点，退出作用域时累计该调用点的
+ *          分配次数和净字节数；定期采样空闲堆、最大空闲块和碎片率。
+ *          Linux上替换malloc系列函数（含对齐分配）逐次计数，计数器为原子变量，其他线程分配不会丢计数；进入稳态后热路径发生分配会计为违规，
+ *          定义MEMTRACK_ABORT_ON_VIOLATION时直接abort()，用于让基准测试失败。
+ */
+class MemTrack {
+public:
+    /**
+     * @brief 查找或注册调用点
+     * @param tag 调用点标签（需为字符串常量）
+     * @param hot 是否热路径
+     * @return 调用点统计，表满时返回共享的溢出项
+     */
+    static MEM_SITE *site(const char *tag, bool hot);
+
+    /**
+     * @brief 按间隔采样堆状态，在主循环中调用
+     */
+    static void sample(uint32_t now);
+
+    /**
+     * @brief 读取当前堆状态
+     */
+    static void heapStats(uint32_t *free_heap, uint32_t *max_block, uint8_t *frag);
+
+    /**
+     * @brief 读取当前空闲堆，调用点作用域每次进出只读这一项（不遍历空闲链表求最大块和碎片率）
+     */
+    static uint32_t freeHeap();
+
+    /**
+     * @brief 设置稳态标志，稳态下热路径的分配计为违规
+     */
+    static void setSteadyState(bool steady) { steady_state = steady; }
+
+    static uint32_t allocCount();                                       ///< 累计分配次数
+    static uint32_t getViolations() { return violations; }             ///< 稳态热路径分配次数
+    static uint8_t getSiteCount() { return site_count; }
+    static const MEM_SITE *getSite(uint8_t index) { return index < site_count ? &sites[index] : nullptr; }
+    static uint8_t getHistoryCount() { return history_count; }
+    static const MEM_SAMPLE *getHistory(uint8_t index);                 ///< 0为最早的样本
+
+    static void leave(MEM_SITE *s, uint32_t allocs0, uint32_t free0);
+
+private:
+    static MEM_SITE sites[MEMTRACK_MAX_SITES + 1];
+    static uint8_t site_count;
+    static MEM_SAMPLE history[MEMTRACK_HISTORY];
+    static uint8_t history_count;
+    static uint8_t history_head;
+    static uint32_t last_sample;
+    static uint32_t violations;
+    static bool steady_state;
+};
+
+/**
+ * @brief 调用点作用域：构造时记录分配计数和空闲堆，析构时累计差值
+ */
+class MemScope {
+public:
+    MemScope(MEM_SITE *s) : s(s), allocs0(MemTrack::allocCount()), free0(MemTrack::freeHeap()) {}
+    ~MemScope() { MemTrack::leave(s, allocs0, free0); }
+
+private:
+    MEM_SITE *s;
+    uint32_t allocs0;
+    uint32_t free0;
+};
+
+#define MEMTRACK_CAT2(a, b) a##b
+#define MEMTRACK_CAT(a, b) MEMTRACK_CAT2(a, b)
+/// 标记一个调用点，统计到所在作用域结束
+#define MEMTRACK_SCOPE(tag) \
+    static MEM_SITE *MEMTRACK_CAT(memtrack_site_, __LINE__) = MemTrack::site(tag, false); \
+    MemScope MEMTRACK_CAT(memtrack_scope_, __LINE__)(MEMTRACK_CAT(memtrack_site_, __LINE__))
+/// 标记一个热路径调用点，稳态下发生分配计为违规
+#define MEMTRACK_HOT_SCOPE(tag) \
+    static MEM_SITE *MEMTRACK_CAT(memtrack_site_, __LINE__) = MemTrack::site(tag, true); \
+    MemScope MEMTRACK_CAT(memtrack_scope_, __LINE__)(MEMTRACK_CAT(memtrack_site_, __LINE__))
+
+#endif // MEMTRACK_HPP
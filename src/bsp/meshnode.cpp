@@ -3,12 +3,64 @@
 // Initialize static member
 MeshNode* MeshNode::instance = nullptr;
 
+/**
+ * @brief 启动计时用的时间戳，0保留表示"尚未发生"
+ */
+static uint32_t stampMs()
+{
+    uint32_t now = Clock::millis();
+    return now != 0 ? now : 1;
+}
+
+#if !defined(__linux__)
+static EepromFlashStore defaultStore;  // 默认保存位置：EEPROM仿真区
+#else
+static SimFlashStore defaultStore;     // 主机上默认只保存在内存中
+#endif
+
 /**
  * @brief MeshNode类默认构造函数实现
  * 初始化成员变量，设置初始连接检查时间为0，并将实例指针赋值给静态成员
  */
-MeshNode::MeshNode() {
+MeshNode::MeshNode()
+    : MeshNode(&defaultTransport)
+{
+}
+
+/**
+ * @brief 使用注入传输层的构造函数实现
+ * @param transport 传输层实现
+ */
+MeshNode::MeshNode(MeshTransport *transport)
+    : mesh(transport)
+    , cmdQueue(cmdQueueBuf, sizeof(MESH_CMD), MESH_CMD_QUEUE_CAPACITY)
+    , blockQueue(blockQueueBuf, sizeof(MESH_BLOCK), MESH_BLOCK_QUEUE_CAPACITY)
+    , groupQueue(groupQueueBuf, sizeof(MESH_GROUP_CMD), MESH_GROUP_QUEUE_CAPACITY)
+{
     lastConnectionCheck = 0;
+    trace_collector = 0;
+    node_count = 0;
+    status_print_pending = false;
+    announce_due = true;
+    last_announce = 0;
+    not_owned = 0;
+    cmd_malformed = 0;
+    cmd_unknown = 0;
+    directed = 0;
+    store = &defaultStore;
+    memset(&cache, 0, sizeof(cache));
+    cache_used = false;
+    cache_fallback = false;
+    start_ms = 0;
+    first_join_ms = 0;
+    first_msg_ms = 0;
+    init_failures = 0;
+    last_init_ms = 0;
+    memset(admins, 0, sizeof(admins));
+    admin_rejected = 0;
+    if (MESH_ADMIN_NODE != 0) {
+        addAdmin(MESH_ADMIN_NODE);
+    }
     instance = this;  // Store the instance pointer
     
 }
@@ -26,18 +78,33 @@ MeshNode::~MeshNode() {
 /**
  * @brief 初始化Mesh网络实现
  * 配置Mesh网络参数，注册回调函数，并输出初始化完成信息
+ * 有上次入网的信道时先只在该信道上寻找mesh，超时后回退到全信道扫描
+ * 传输层初始化失败时不开始组网，主循环再次调用时按MESH_INIT_RETRY间隔重试
  */
-void MeshNode::begin() {
+bool MeshNode::begin() {
+    uint32_t now = stampMs();
+    if (init_failures > 0 && (now - last_init_ms) < MESH_INIT_RETRY) {
+        return false;
+    }
+    cache_used = store != nullptr && store->load(&cache, sizeof(cache)) && cache.channel != 0;
+    mesh->setChannel(cache_used ? cache.channel : 0);
     // 设置 Mesh
-    mesh.init(MESH_PREFIX, MESH_PASSWORD, MESH_PORT);
-    mesh.onReceive(&MeshNode::receivedCallback);
-    mesh.onNewConnection(&MeshNode::newConnectionCallback);
-    mesh.onChangedConnections(&MeshNode::changedConnectionCallback);
-    mesh.onDroppedConnection(&MeshNode::droppedConnectionCallback);
+    mesh->onReceive(&MeshNode::receivedCallback);
+    mesh->onNewConnection(&MeshNode::newConnectionCallback);
+    mesh->onChangedConnections(&MeshNode::changedConnectionCallback);
+    mesh->onDroppedConnection(&MeshNode::droppedConnectionCallback);
+    if (!mesh->init()) {
+        init_failures++;
+        last_init_ms = now;
+        return false;
+    }
+    start_ms = now;
+    shard.setSelf(mesh->getNodeId());
     
     // 配置重连参数（可选）
-    // mesh.initOTAReceive("ota");  // 初始化OTA，便于无线更新
+    // mesh->initOTAReceive("ota");  // 初始化OTA，便于无线更新
     // Serial.println("Mesh 初始化完成，等待连接...");
+    return true;
 }
 
  
@@ -47,32 +114,47 @@ void MeshNode::begin() {
  * 处理网络数据包，定期发送心跳，检查网络连接状态
  */
 void MeshNode::update() {
-    mesh.update();
-    
-    // 定期发送心跳并显示网络状态
-    // static unsigned long lastHeartbeat = 0;
-    // if (millis() - lastHeartbeat > 3000) {
-    //     lastHeartbeat = millis();
-    //     sendHeartbeat();
-    // }
+    mesh->update();
+    uint32_t now = Clock::millis();
+    announceShard(now);
+    liveness.check(now);
+    if (node_count > 0 && liveness.heartbeatDue(now)) {
+        sendHeartbeat();//一个间隔内没有任何广播，才发显式心跳
+    }
+
+    if (cache_used && first_join_ms == 0 && (Clock::millis() - start_ms) > MESH_CACHE_TIMEOUT) {
+        cache_used = false;//缓存信道上找不到mesh，回退到全信道扫描
+        cache_fallback = true;
+        mesh->stop();
+        mesh->setChannel(0);
+        mesh->init();
+    }
     
     // 定期检查连接状态
-    // if (millis() - lastConnectionCheck > CHECK_INTERVAL) {
-    //     lastConnectionCheck = millis();
+    // if (Clock::millis() - lastConnectionCheck > CHECK_INTERVAL) {
+    //     lastConnectionCheck = Clock::millis();
     //     printNetworkStatus();
     // }
 }
 
 /**
  * @brief 发送心跳消息实现
- * 广播包含节点ID和时间戳的心跳消息，并打印当前连接节点数
+ * 广播"HB"+本机心跳间隔（100毫秒为单位），邻居按此间隔判断本机是否失联
  */
 void MeshNode::sendHeartbeat() {
-    String msg = "HEARTBEAT_" + String(getNodeId()) + "_" + String(millis()/1000);
-    sendBroadcast(msg);
-    
-    int nodeCount = getNodeList().size();
-    Serial.printf("[%lu] 发送心跳，连接节点: %d\n", millis()/1000, nodeCount);
+    MEMTRACK_SCOPE("MeshNode::sendHeartbeat");
+    String msg = LIVENESS_TAG;
+    msg.concat((char)(liveness.getInterval() / 100));
+    broadcast(msg);
+}
+
+/**
+ * @brief 广播实现
+ */
+bool MeshNode::broadcast(String &msg)
+{
+    liveness.noteSent(Clock::millis());
+    return mesh->sendBroadcast(msg);
 }
 
 /**
@@ -83,7 +165,7 @@ void MeshNode::printNetworkStatus() {
     std::list<uint32_t> nodeList = getNodeList();
     
     Serial.println("\n=== 网络状态报告 ===");
-    Serial.printf("节点总数: %d\n", nodeList.size() + 1); // +1 包括自己
+    Serial.printf("节点总数: %u\n", (unsigned)nodeList.size() + 1); // +1 包括自己
     
     if (nodeList.size() > 0) {
         Serial.print("已连接节点ID: ");
@@ -104,28 +186,309 @@ void MeshNode::printNetworkStatus() {
     Serial.println(")");
 }
 /**
- * @brief 获取从机状态实现
- * @return 返回从机状态
+ * @brief 保存入网信息实现
+ */
+void MeshNode::saveCache()
+{
+    MESH_CACHE now;
+    memset(&now, 0, sizeof(now));
+    now.channel = mesh->getChannel();
+    if (now.channel == 0 || !mesh->getParentBssid(now.bssid)) {
+        return;
+    }
+    cache = now;
+    if (store != nullptr) {
+        store->save(&cache, sizeof(cache));
+    }
+}
+
+/**
+ * @brief 广播本机可达从机位图实现
+ * @details 位图变化时立即公告，否则每SHARD_ANNOUNCE_MS公告一次作为保活
+ */
+void MeshNode::announceShard(uint32_t now)
+{
+    shard.expire(now);
+    if (!announce_due && (now - last_announce) < SHARD_ANNOUNCE_MS) {
+        return;
+    }
+    if (node_count == 0) {
+        return;//没有邻居，入网后再公告
+    }
+    shard.setLocalCost(link.compute(getRSSI(), mesh->getHopCount(), cmdQueue.count(), MESH_CMD_QUEUE_CAPACITY));
+    String msg = SHARD_TAG;
+    msg.concat((const char *)shard.getLocalReach(), SHARD_REACH_BYTES);
+    msg.concat((char)shard.getLocalCost());
+    broadcast(msg);
+    announce_due = false;
+    last_announce = now;
+}
+
+void MeshNode::noteReach(uint8_t addr)
+{
+    if (shard.setLocalReach(addr)) {
+        announce_due = true;
+    }
+}
+
+/**
+ * @brief 向从机发送命令实现
+ * @details 帧格式与网关接收的命令帧相同：7B 7B 09 addr 03 01 addr 00 cmd 00 XOR 7D 7D
+ */
+bool MeshNode::sendCommand(uint8_t addr, uint8_t cmd, bool flow)
+{
+    uint8_t payload[MotorFrame::PAYLOAD_LEN] = {0};
+    uint8_t frame[MotorFrame::FRAME_SIZE];
+    payload[MOTOR_FIELD_ADDR] = addr;
+    payload[MOTOR_FIELD_FUNC] = 0x03;
+    payload[MOTOR_FIELD_COUNT] = 0x01;
+    payload[MOTOR_FIELD_REG] = addr;
+    payload[MOTOR_FIELD_CMD] = cmd;
+    MotorFrame::encode(frame, payload);
+    String msg;
+    msg.concat((const char *)frame, MotorFrame::FRAME_SIZE);
+    if (flow) {
+        msg.concat((char)MESH_FLOW_TAG);
+    }
+    uint32_t gateway = selector.select(addr, shard);
+    if (gateway != 0 && gateway != mesh->getNodeId()) {
+        String routed = msg;
+        routed.concat((char)MESH_ROUTE_TAG);
+        for (uint8_t i = 0; i < 4; i++) {
+            routed.concat((char)(gateway >> (8 * i)));
+        }
+        if (mesh->sendSingle(gateway, routed)) {
+            return true;
+        }
+    }
+    uint32_t owner = shard.owner(addr);
+    if (owner != 0 && owner != mesh->getNodeId()) {
+        return mesh->sendSingle(owner, msg);
+    }
+    return broadcast(msg);
+}
+
+/**
+ * @brief 打印推迟的网络状态报告实现
+ */
+void MeshNode::printPending()
+{
+    if (status_print_pending) {
+        status_print_pending = false;
+        Serial.printf("[%lu] 网络拓扑发生变化\n", Clock::millis()/1000);
+        printNetworkStatus();
+    }
+}
+
+/**
+ * @brief 设置串口链路预算实现
+ * @param baud 串口波特率
+ */
+void MeshNode::setSerialBaud(uint32_t baud)
+{
+    admission.begin(baud);
+    cmdQueue.reset();
+    blockQueue.reset();
+    groupQueue.reset();
+}
+
+/**
+ * @brief 添加管理节点实现（已存在时直接返回true）
+ */
+bool MeshNode::addAdmin(uint32_t nodeId)
+{
+    if (nodeId == 0 || isAdmin(nodeId)) {
+        return nodeId != 0;
+    }
+    for (uint8_t i = 0; i < MESH_ADMIN_MAX; i++) {
+        if (admins[i] == 0) {
+            admins[i] = nodeId;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MeshNode::isAdmin(uint32_t nodeId)
+{
+    for (uint8_t i = 0; i < MESH_ADMIN_MAX; i++) {
+        if (admins[i] != 0 && admins[i] == nodeId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 取出一条已准入的从机命令实现
+ * @param cmd 输出命令
+ * @return 队列非空返回true
+ */
+bool MeshNode::popCommand(MESH_CMD *cmd)
+{
+    return cmdQueue.pop(cmd);
+}
+
+/**
+ * @brief 查看队首命令实现
+ */
+const MESH_CMD *MeshNode::peekCommand() const
+{
+    return (const MESH_CMD *)cmdQueue.peek(0);
+}
+
+/**
+ * @brief 取出一条已准入的块读写请求实现
+ */
+bool MeshNode::popBlock(MESH_BLOCK *req)
+{
+    return blockQueue.pop(req);
+}
+
+/**
+ * @brief 查看队首块读写请求实现
+ */
+const MESH_BLOCK *MeshNode::peekBlock() const
+{
+    return (const MESH_BLOCK *)blockQueue.peek(0);
+}
+
+bool MeshNode::popGroupCommand(MESH_GROUP_CMD *cmd)
+{
+    return groupQueue.pop(cmd);
+}
+
+/**
+ * @brief 查看队首组命令实现
+ */
+const MESH_GROUP_CMD *MeshNode::peekGroupCommand() const
+{
+    return (const MESH_GROUP_CMD *)groupQueue.peek(0);
+}
+
+/**
+ * @brief 组配置广播实现
+ */
+bool MeshNode::sendGroupConfig(uint8_t id, uint8_t bus_addr, const uint8_t *members, uint8_t count)
+{
+    if (count > GROUP_MAX_MEMBERS) return false;
+    uint8_t buf[3 + GROUP_MAX_MEMBERS];
+    buf[0] = id;
+    buf[1] = bus_addr;
+    buf[2] = count;
+    memcpy(buf + 3, members, count);
+    String msg = GROUP_CFG_TAG;
+    msg.concat((const char *)buf, 3 + count);
+    return broadcast(msg);
+}
+
+/**
+ * @brief 组命令广播实现
+ */
+bool MeshNode::sendGroupCommand(uint8_t id, uint8_t cmd)
+{
+    uint8_t buf[2] = {id, cmd};
+    String msg = GROUP_CMD_TAG;
+    msg.concat((const char *)buf, 2);
+    return broadcast(msg);
+}
+
+/**
+ * @brief 解析块读写消息实现
+ * @details 写请求必须携带count个寄存器值，读请求只有消息头
+ */
+bool MeshNode::parseBlock(const String &msg, MODBUS_BLOCK *block)
+{
+    if (msg.length() < MESH_BLOCK_HDR) return false;
+    const uint8_t *p = (const uint8_t *)msg.c_str() + 3;
+    block->addr = p[0];
+    block->func = p[1];
+    block->start = p[2];
+    block->count = p[3];
+    if (block->count == 0 || block->count > MODBUS_BLOCK_MAX_REGS) return false;
+    if (block->func == MODBUS_FN_READ_REGS) return true;
+    if (block->func != MODBUS_FN_WRITE_REGS || msg.length() < MESH_BLOCK_HDR + 2U * block->count) return false;
+    for (uint8_t i = 0; i < block->count; i++) {
+        block->regs[i] = (uint16_t)p[4 + 2 * i] << 8 | p[5 + 2 * i];
+    }
+    return true;
+}
+
+/**
+ * @brief 向来源节点回复块读写应答实现
+ */
+bool MeshNode::sendBlockReply(uint32_t nodeId, const MODBUS_BLOCK &reply)
+{
+    uint8_t buf[4 + 2 * MODBUS_BLOCK_MAX_REGS];
+    uint8_t n = 0;
+    buf[n++] = reply.addr;
+    buf[n++] = reply.func;
+    buf[n++] = reply.start;
+    buf[n++] = reply.count;
+    if (reply.func == MODBUS_FN_READ_REGS) {
+        for (uint8_t i = 0; i < reply.count && i < MODBUS_BLOCK_MAX_REGS; i++) {
+            buf[n++] = reply.regs[i] >> 8;
+            buf[n++] = reply.regs[i] & 0xFF;
+        }
+    }
+    String msg = MESH_BLOCK_TAG;
+    msg.concat((const char *)buf, n);
+    return mesh->sendSingle(nodeId, msg);
+}
+
+/**
+ * @brief 准入后入队实现
+ * @details 块读写与单命令共用准入预算，每条请求计一个令牌；高优先级命令不消耗令牌
  */
-uint8_t MeshNode::getSlaveSTA()
+void MeshNode::admitOrBusy(uint32_t from, SimpleQueue &queue, const void *element, bool priority)
 {
-    return slave_sta;
+    uint32_t now = Clock::millis();
+    uint32_t retry_after = priority ? 0 : admission.admit(from, now);
+    if (retry_after == 0) {
+        if (queue.push(element)) {
+            return;
+        }
+        if (!priority) {
+            admission.refund(from);//队列已满，归还令牌
+        }
+        retry_after = 1000 / admission.getGlobalRate() + 1;
+    }
+    if (admission.shouldNotify(from, now, retry_after)) {
+        sendBusy(from, retry_after);
+    }
 }
+
 /**
- * @brief 设置从机状态实现
- * @param sta 要设置的从机状态
+ * @brief 应答历史查询实现
+ * @details 查询格式："TLMQ" addr 起始时长(4) 结束时长(4)，小端，单位毫秒，距现在
  */
-void MeshNode::set_SlaveSTA(uint8_t sta)
+void MeshNode::answerTelemetry(uint32_t from, const String &msg)
 {
-    slave_sta = sta;
+    TelemetryStore *store = TelemetryStore::getInstance();
+    if (store == nullptr || msg.length() < 13) return;
+    const uint8_t *p = (const uint8_t *)msg.c_str() + 4;
+    uint32_t since = 0;
+    uint32_t until = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        since |= (uint32_t)p[1 + i] << (8 * i);
+        until |= (uint32_t)p[5 + i] << (8 * i);
+    }
+    uint8_t buf[TELEMETRY_MAX_REPLY];
+    size_t n = store->query(p[0], since, until, Clock::millis(), buf, sizeof(buf));
+    if (n == 0) return;
+    String reply = TELEMETRY_REPLY_TAG;
+    reply.concat((const char *)buf, n);
+    mesh->sendSingle(from, reply);
 }
+
 /**
- * @brief 获取从机命令实现
- * @return 返回从机命令
+ * @brief 向来源节点发送忙消息实现
+ * @details 消息格式："BUSY_<重试等待毫秒>"
  */
-uint16_t MeshNode::getSlavedata()
+void MeshNode::sendBusy(uint32_t nodeId, uint32_t retry_after)
 {
-    return this->slave_addr << 8 | this->slave_cmd;
+    String busy = "BUSY_" + String(retry_after);
+    mesh->sendSingle(nodeId, busy);
 }
 
 
@@ -135,17 +498,144 @@ uint16_t MeshNode::getSlavedata()
  * @brief 收到消息时的回调函数实现
  * @param from 发送消息的节点ID
  * @param msg 收到的消息内容
- * 处理收到的消息，如果是心跳消息则发送确认回复
- *7B 7B 09 10 03 01 00 00 00 00 0F 7D 7D
+ * 命令帧经准入控制后入队，串口链路饱和时向来源节点回复"BUSY_<ms>"
+ * "TRACE_START"/"TRACE_STOP"用于开始/停止流量记录，记录数据发往发送该消息的节点；它和"GRP"组配置只接受管理节点发来的
+ * 命令帧后可带时间戳附加段（MESH_STAMP_TAG），用于跨跳时延跟踪
+ * "BLK"开头的消息为块寄存器读写请求，应答以同样格式单播回来源节点
+ * "TLMQ"开头的消息为从机状态历史查询，由网关本地存储直接应答"TLMR"
+ * "UPL_SUB"/"UPL_UNSUB"订阅/取消订阅从机状态变化上行
+ * "SHD"为其他网关的可达从机公告；命令帧和块读写只在本机负责该从机时处理
+ *7B 7B 09 10 03 01 00 00 00 00 0F 7D 7D [54 ts0 ts1 ts2 ts3 flags] [47 gw0 gw1 gw2 gw3] [46]
  *                 addr   cmd
  */
 void MeshNode::receivedCallback(uint32_t from, String &msg) {
     // for (int i = 0; i < 13; i++) {
     //     Serial.printf("%02X ", (uint8_t)msg[i]); // 打印两位十六进制，补0
     // }
-    instance->slave_addr = static_cast<uint8_t>(msg.charAt(3));//addr
-    instance->slave_cmd = static_cast<uint8_t>(msg.charAt(8));//cmd
-    instance->slave_sta = 1;//收到消息
+    if (instance == nullptr) return;
+    if (instance->first_msg_ms == 0) instance->first_msg_ms = stampMs();
+    if (msg.startsWith(LIVENESS_TAG) && msg.length() >= 3) {
+        instance->liveness.heard(from, Clock::millis(), (uint16_t)(uint8_t)msg.charAt(2) * 100);
+        return;
+    }
+    instance->liveness.heard(from, Clock::millis());//任何消息都证明对方存活
+    TraceRecorder::recordMesh(from, msg);
+    TraceRecorder *trace = TraceRecorder::getInstance();
+    if (trace != nullptr && msg.startsWith("TRACE_")) {
+        if (!instance->isAdmin(from)) {
+            instance->admin_rejected++;
+        } else if (msg.startsWith("TRACE_START")) {
+            instance->trace_collector = from;
+            trace->start();
+        } else if (msg.startsWith("TRACE_STOP")) {
+            trace->stop();
+        }
+        return;
+    }
+    StatusUplink *uplink = StatusUplink::getInstance();
+    if (uplink != nullptr && msg.startsWith(UPLINK_SUB_TAG)) {
+        uplink->subscribe(from);
+        return;
+    }
+    if (uplink != nullptr && msg.startsWith(UPLINK_UNSUB_TAG)) {
+        uplink->unsubscribe(from);
+        return;
+    }
+    if (msg.startsWith(SHARD_TAG)) {
+        if (msg.length() >= 3 + SHARD_REACH_BYTES) {
+            uint8_t cost = msg.length() > 3 + SHARD_REACH_BYTES ? (uint8_t)msg.charAt(3 + SHARD_REACH_BYTES) : SHARD_COST_UNKNOWN;
+            instance->shard.announce(from, (const uint8_t *)msg.c_str() + 3, Clock::millis(), cost);
+        }
+        return;
+    }
+    if (msg.startsWith(TELEMETRY_QUERY_TAG)) {
+        instance->answerTelemetry(from, msg);
+        return;
+    }
+    SlaveGroups *groups = SlaveGroups::getInstance();
+    if (groups != nullptr && msg.startsWith(GROUP_CFG_TAG)) {
+        if (!instance->isAdmin(from)) {
+            instance->admin_rejected++;
+        } else {
+            groups->configure(msg);
+        }
+        return;
+    }
+    if (msg.startsWith(GROUP_CMD_TAG)) {
+        if (msg.length() < 5) return;
+        MESH_GROUP_CMD gc;
+        gc.from = from;
+        gc.group = (uint8_t)msg.charAt(3);
+        gc.cmd = (uint8_t)msg.charAt(4);
+        const SLAVE_CMD_DEF *def = SlaveCommands::find(gc.cmd);
+        if (def == nullptr) {
+            instance->cmd_unknown++;
+            return;
+        }
+        instance->admitOrBusy(from, instance->groupQueue, &gc, def->priority == CMD_PRIO_HIGH);
+        return;
+    }
+    if (msg.startsWith(MESH_BLOCK_TAG)) {
+        MESH_BLOCK req;
+        req.from = from;
+        if (parseBlock(msg, &req.block) && instance->shard.isLocal(req.block.addr)) {
+            instance->admitOrBusy(from, instance->blockQueue, &req);
+        }
+        return;
+    }
+    if (msg.length() < MESH_FRAME_LEN || (uint8_t)msg.charAt(0) != 0x7B || (uint8_t)msg.charAt(1) != 0x7B) {
+        return;//不是命令帧（心跳、欢迎消息等）
+    }
+
+    const uint8_t *frame = (const uint8_t *)msg.c_str();
+    if (!SlaveCommands::wellFormed(frame)) {
+        instance->cmd_malformed++;//不完整的帧不占用串口时间
+        return;
+    }
+    const SLAVE_CMD_DEF *def = SlaveCommands::find(frame[8]);
+    if (def == nullptr) {
+        instance->cmd_unknown++;//从机不认识的命令码
+        return;
+    }
+    MESH_CMD cmd;
+    cmd.from = from;
+    cmd.addr = frame[3];//addr
+    cmd.cmd = def->code;//cmd
+    cmd.rx_ts = instance->mesh->getNodeTime();
+    cmd.origin_ts = 0;
+    cmd.flags = 0;
+    cmd.flow = false;
+    uint32_t route = 0;
+    size_t pos = MESH_FRAME_LEN;
+    while (pos < msg.length()) {//附加段：时间戳、指定网关，顺序任意
+        uint8_t tag = (uint8_t)msg.charAt(pos);
+        if (tag == MESH_STAMP_TAG && msg.length() >= pos + MESH_STAMP_LEN) {
+            for (uint8_t i = 0; i < 4; i++) {
+                cmd.origin_ts |= (uint32_t)frame[pos + 1 + i] << (8 * i);
+            }
+            cmd.flags = frame[pos + 5] | LATENCY_FLAG_STAMPED;
+            pos += MESH_STAMP_LEN;
+        } else if (tag == MESH_ROUTE_TAG && msg.length() >= pos + MESH_ROUTE_LEN) {
+            for (uint8_t i = 0; i < 4; i++) {
+                route |= (uint32_t)frame[pos + 1 + i] << (8 * i);
+            }
+            pos += MESH_ROUTE_LEN;
+        } else if (tag == MESH_FLOW_TAG) {
+            cmd.flow = true;//与普通命令一样经过分片和准入
+            pos += MESH_FLOW_LEN;
+        } else {
+            break;
+        }
+    }
+    if (route == instance->mesh->getNodeId() && instance->shard.canReachLocal(cmd.addr)) {
+        if (!instance->shard.isLocal(cmd.addr)) {
+            instance->directed++;//控制节点按链路开销选择了本机
+        }
+    } else if (!instance->shard.isLocal(cmd.addr)) {
+        instance->not_owned++;//由其他网关负责，不占用本机串口预算
+        return;
+    }
+    instance->admitOrBusy(from, instance->cmdQueue, &cmd, def->priority == CMD_PRIO_HIGH);
 }
 
 /**
@@ -154,23 +644,30 @@ void MeshNode::receivedCallback(uint32_t from, String &msg) {
  * 输出新节点连接信息并发送欢迎消息
  */
 void MeshNode::newConnectionCallback(uint32_t nodeId) {
+    MEMTRACK_SCOPE("MeshNode::newConnectionCallback");
     if(instance != nullptr) {
-        Serial.printf("[%lu] +++ 新节点连接: %u\n", millis()/1000, nodeId);
+        Serial.printf("[%lu] +++ 新节点连接: %u\n", Clock::millis()/1000, nodeId);
         
         // 发送欢迎消息
-        String welcome = "WELCOME_" + String(instance->mesh.getNodeId());
-        instance->mesh.sendSingle(nodeId, welcome);
+        String welcome = "WELCOME_" + String(instance->mesh->getNodeId());
+        instance->mesh->sendSingle(nodeId, welcome);
     }
 }
 
 /**
  * @brief 网络拓扑变化时的回调函数实现
- * 输出网络拓扑变化信息并打印当前网络状态
+ * 更新节点数缓存，网络状态报告推迟到printPending()打印
  */
 void MeshNode::changedConnectionCallback() {
+    MEMTRACK_SCOPE("MeshNode::changedConnectionCallback");
     if(instance != nullptr) {
-        Serial.printf("[%lu] 网络拓扑发生变化\n", millis()/1000);
-        instance->printNetworkStatus();
+        instance->node_count = instance->getNodeList().size();//只在拓扑变化时复制一次节点列表
+        if (instance->node_count > 0) {
+            if (instance->first_join_ms == 0) instance->first_join_ms = stampMs();
+            instance->saveCache();//上级节点可能已变化
+        }
+        instance->status_print_pending = true;//推迟到主循环空闲时打印
+        instance->liveness.noteChurn(Clock::millis());//拓扑不稳定，加快心跳
     }
 }
 
@@ -181,7 +678,13 @@ void MeshNode::changedConnectionCallback() {
  */
 void MeshNode::droppedConnectionCallback(uint32_t nodeId) {
     if(instance != nullptr) {
-        Serial.printf("[%lu] --- 节点断开连接: %u\n", millis()/1000, nodeId);
+        Serial.printf("[%lu] --- 节点断开连接: %u\n", Clock::millis()/1000, nodeId);
+        StatusUplink *uplink = StatusUplink::getInstance();
+        if (uplink != nullptr) {
+            uplink->unsubscribe(nodeId);//断开的订阅者不再占用空口
+        }
+        instance->shard.remove(nodeId);//只重新分配该网关负责的从机
+        instance->liveness.dropped(nodeId);
         
         // 断开后，Mesh会自动尝试重新连接或重新路由
         Serial.println("网络将自动尝试重新路由...");
@@ -206,7 +709,7 @@ String MeshNode::getSignalQuality(int rssi) {
  * @return 返回发送是否成功
  */
 bool MeshNode::sendBroadcast(String msg) {
-    return mesh.sendBroadcast(msg);
+    return broadcast(msg);
 }
 
 /**
@@ -216,7 +719,7 @@ bool MeshNode::sendBroadcast(String msg) {
  * @return 返回发送是否成功
  */
 bool MeshNode::sendSingle(uint32_t nodeId, String msg) {
-    return mesh.sendSingle(nodeId, msg);
+    return mesh->sendSingle(nodeId, msg);
 }
 
 /**
@@ -224,7 +727,7 @@ bool MeshNode::sendSingle(uint32_t nodeId, String msg) {
  * @return 返回当前节点的唯一标识符
  */
 uint32_t MeshNode::getNodeId() {
-    return mesh.getNodeId();
+    return mesh->getNodeId();
 }
 
 /**
@@ -232,7 +735,15 @@ uint32_t MeshNode::getNodeId() {
  * @return 返回包含所有已知节点ID的列表
  */
 std::list<uint32_t> MeshNode::getNodeList() {
-    return mesh.getNodeList();
+    return mesh->getNodeList();
+}
+
+/**
+ * @brief 获取全网同步时间实现
+ * @return mesh时间（微秒）
+ */
+uint32_t MeshNode::getNodeTime() {
+    return mesh->getNodeTime();
 }
 
 /**
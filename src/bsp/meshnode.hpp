@@ -18,14 +18,85 @@
 
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
-#include <painlessMesh.h>
+#include "meshtransport.hpp"
+#include "udpmesh.hpp"
+#include "queue.hpp"
+#include "admission.hpp"
+#include "trace.hpp"
+#include "memtrack.hpp"
+#include "latency.hpp"
+#include "modbus.hpp"
+#include "telemetry.hpp"
+#include "uplink.hpp"
+#include "flashstore.hpp"
+#include "shard.hpp"
+#include "command.hpp"
+#include "groups.hpp"
+#include "liveness.hpp"
+#include "linkcost.hpp"
 
+#if defined(MESH_TRANSPORT_UDP)
+typedef UdpMeshTransport DefaultMeshTransport; ///< Linux：UDP组播传输层
+#else
+typedef PainlessMeshTransport DefaultMeshTransport; ///< ESP8266：painlessMesh传输层
+#endif
 
+#define MESH_CMD_QUEUE_CAPACITY ADMISSION_GLOBAL_BURST ///< 网关命令队列容量
+#define MESH_FRAME_LEN 13 ///< 控制节点下发的命令帧长度
+#define MESH_STAMP_TAG 0x54 ///< 命令帧后的时间戳附加段：'T' 发出时间(4字节，小端，mesh时间微秒) 标志(1)
+#define MESH_STAMP_LEN 6 ///< 时间戳附加段长度
+#define MESH_ROUTE_TAG 0x47 ///< 指定网关附加段：'G' 网关节点ID(4字节，小端)，控制节点按链路开销选择网关时附加
+#define MESH_ROUTE_LEN 5 ///< 指定网关附加段长度
+#define MESH_FLOW_TAG 0x46 ///< 流程附加段：'F'，命令按网关上的多步流程执行（目前只有反转：停止→确认停止→反转→确认运行）
+#define MESH_FLOW_LEN 1 ///< 流程附加段长度
+#define MESH_BLOCK_TAG "BLK" ///< 块读写消息："BLK" addr func start count [寄存器值，大端]
+#define MESH_BLOCK_HDR 7 ///< 块读写消息头长度（标签+4字节）
+#define MESH_BLOCK_QUEUE_CAPACITY 2 ///< 块读写队列容量
+#define MESH_GROUP_QUEUE_CAPACITY 2 ///< 组命令队列容量
+#define MESH_CACHE_TIMEOUT 15000 ///< 使用缓存信道多久仍未入网则回退到全信道扫描（毫秒）
+#define MESH_INIT_RETRY 1000 ///< 传输层初始化失败后的重试间隔（毫秒）
+#define MESH_ADMIN_MAX 4 ///< 管理节点表容量
+#ifndef MESH_ADMIN_NODE
+#define MESH_ADMIN_NODE 0 ///< 编译时指定的管理节点ID，0表示不指定（只能用addAdmin()添加）
+#endif
 
-#define MESH_PREFIX "MyMeshNet"
-#define MESH_PASSWORD "myPassword"
-#define MESH_PORT 5555
+/**
+ * @brief 网关命令队列元素：来源节点+从机地址+命令
+ */
+typedef struct {
+    uint32_t from; ///< 来源节点ID
+    uint8_t addr;  ///< 从机地址
+    uint8_t cmd;   ///< 从机命令
+    uint8_t flags; ///< 附加段标志（LATENCY_FLAG_*）
+    uint32_t origin_ts; ///< 控制节点发出时间（mesh时间），flags带LATENCY_FLAG_STAMPED时有效
+    uint32_t rx_ts;     ///< 网关收到时间（mesh时间）
+    bool flow;          ///< 带流程附加段（MESH_FLOW_TAG）
+} MESH_CMD;
 
+/**
+ * @brief 网关组命令队列元素
+ */
+typedef struct {
+    uint32_t from;  ///< 来源节点ID
+    uint8_t group;  ///< 组号
+    uint8_t cmd;    ///< 从机命令
+} MESH_GROUP_CMD;
+
+/**
+ * @brief 网关块读写队列元素：来源节点+块请求
+ */
+typedef struct {
+    uint32_t from;       ///< 来源节点ID
+    MODBUS_BLOCK block;  ///< 块读写请求
+} MESH_BLOCK;
+
+/**
+ * @brief 掉电保存的入网信息，下次启动优先使用
+ */
+typedef struct {
+    uint8_t channel;   ///< 上次入网的信道
+    uint8_t bssid[6];  ///< 上次连接的上级节点BSSID
+} MESH_CACHE;
 
 
 class MeshNode {
@@ -35,6 +106,12 @@ public:
      * 初始化成员变量，设置初始连接检查时间为0，并将实例指针赋值给静态成员
      */
     MeshNode();
+
+    /**
+     * @brief 使用注入传输层的构造函数
+     * @param transport 传输层实现（如本机负载测试用的UDP传输层）
+     */
+    MeshNode(MeshTransport *transport);
     
     /**
      * @brief MeshNode类析构函数
@@ -45,8 +122,9 @@ public:
     /**
      * @brief 初始化Mesh网络
      * 配置Mesh网络参数，注册回调函数，并输出初始化完成信息
+     * @return 传输层初始化失败（或距上次失败不到MESH_INIT_RETRY）返回false，仍未开始组网
      */
-    void begin();
+    bool begin();
     
     /**
      * @brief 更新Mesh网络状态
@@ -56,7 +134,7 @@ public:
     
     /**
      * @brief 发送心跳消息
-     * 广播包含节点ID和时间戳的心跳消息，并打印当前连接节点数
+     * 广播"HB"+本机心跳间隔，只在一个间隔内没有发过任何广播时由update()调用
      */
     void sendHeartbeat();
     
@@ -65,6 +143,13 @@ public:
      * 显示当前连接的节点列表、节点总数以及WiFi信号强度
      */
     void printNetworkStatus();
+
+    /**
+     * @brief 打印推迟的网络状态报告
+     * @details 拓扑变化回调只做标记，由主循环在空闲时调用本函数打印，避免阻塞串口接收
+     */
+    void printPending();
+    bool hasPendingPrint() { return status_print_pending; } ///< 是否有待打印的网络状态报告
     
     /**
      * @brief 发送广播消息
@@ -81,6 +166,30 @@ public:
      */
     bool sendBroadcast(uint8_t addr, uint8_t cmd);
     
+    /**
+     * @brief 向从机发送命令，按分片发给负责该从机的网关
+     * @details 归属未知（发现状态）时广播
+     * @param addr 从机地址
+     * @param cmd 从机命令
+     * @param flow 附加流程段，网关按多步流程执行（反转先停止确认）
+     * @return 返回发送是否成功
+     */
+    bool sendCommand(uint8_t addr, uint8_t cmd, bool flow = false);
+
+    /**
+     * @brief 登记本机可到达的从机（由串口应答学习），位图变化时尽快公告
+     */
+    void noteReach(uint8_t addr);
+
+    ShardMap &getShard() { return shard; } ///< 多网关分片
+    PeerLiveness &getLiveness() { return liveness; } ///< 节点存活表
+    GatewaySelector &getSelector() { return selector; } ///< 按链路开销选择网关
+    void noteDelivery(bool ok) { link.noteDelivery(ok); } ///< 记录一次命令是否收到从机应答（计入链路开销）
+    uint32_t getDirected() { return directed; } ///< 控制节点指定本机而接收的非归属命令数
+    uint32_t getNotOwned() { return not_owned; } ///< 因归属其他网关而忽略的命令数
+    uint32_t getCmdMalformed() { return cmd_malformed; } ///< 帧头/长度/帧尾错误而拒绝的命令数
+    uint32_t getCmdUnknown() { return cmd_unknown; } ///< 命令码不在命令表中而拒绝的命令数
+
     /**
      * @brief 向指定节点发送单播消息
      * @param nodeId 目标节点ID
@@ -100,6 +209,17 @@ public:
      * @return 返回包含所有已知节点ID的列表
      */
     std::list<uint32_t> getNodeList();
+
+    /**
+     * @brief 获取已连接节点数
+     * @details 在拓扑变化回调中更新，主循环中调用不会复制节点列表
+     */
+    uint16_t getNodeCount() { return node_count; }
+
+    /**
+     * @brief 获取全网同步时间（微秒）
+     */
+    uint32_t getNodeTime();
     
     /**
      * @brief 获取WiFi信号强度
@@ -107,19 +227,176 @@ public:
      */
     int8_t getRSSI();
 
-    uint8_t getSlaveSTA();///< 获取从机状态
-    void set_SlaveSTA(uint8_t sta);///< 设置从机状态
-    uint16_t getSlavedata();///< 获取从机命令
+    /**
+     * @brief 设置串口链路预算
+     * @param baud 串口波特率，用于推算全局准入速率
+     */
+    void setSerialBaud(uint32_t baud);
+
+    /**
+     * @brief 取出一条已准入的从机命令
+     * @param cmd 输出命令
+     * @return 队列非空返回true
+     */
+    bool popCommand(MESH_CMD *cmd);
+
+    /**
+     * @brief 查看队首命令（不取出）
+     * @return 队列为空返回nullptr
+     */
+    const MESH_CMD *peekCommand() const;
+
+    /**
+     * @brief 取出一条已准入的块读写请求
+     * @param req 输出请求
+     * @return 队列非空返回true
+     */
+    bool popBlock(MESH_BLOCK *req);
+
+    /**
+     * @brief 查看队首块读写请求（不取出）
+     * @return 队列为空返回nullptr
+     */
+    const MESH_BLOCK *peekBlock() const;
+
+    /**
+     * @brief 取出一条已准入的组命令
+     * @return 队列为空返回false
+     */
+    bool popGroupCommand(MESH_GROUP_CMD *cmd);
+
+    /**
+     * @brief 查看队首组命令（不取出）
+     * @return 队列为空返回nullptr
+     */
+    const MESH_GROUP_CMD *peekGroupCommand() const;
+
+    /**
+     * @brief 向所有网关配置从机组（控制节点使用）
+     * @param id 组号
+     * @param bus_addr 组帧地址，0表示逐个连发
+     * @param members 成员地址
+     * @param count 成员数，0删除该组
+     */
+    bool sendGroupConfig(uint8_t id, uint8_t bus_addr, const uint8_t *members, uint8_t count);
+
+    /**
+     * @brief 向所有网关发送组命令（控制节点使用），每个网关只下发给自己负责的成员
+     */
+    bool sendGroupCommand(uint8_t id, uint8_t cmd);
+
+    /**
+     * @brief 向来源节点回复块读写应答
+     * @details 读应答携带寄存器值，写应答只有消息头
+     */
+    bool sendBlockReply(uint32_t nodeId, const MODBUS_BLOCK &reply);
+
+    Admission &getAdmission() { return admission; } ///< 获取准入控制统计
+    uint32_t getTraceCollector() { return trace_collector; } ///< 流量记录采集节点ID，0表示未采集
+
+    /**
+     * @brief 添加管理节点
+     * @details 管理消息（TRACE_START/TRACE_STOP流量记录、GRP组配置）只接受管理节点发来的，
+     *          其他节点发来的丢弃并计数；没有管理节点时所有管理消息都被丢弃。
+     *          管理节点由APP::addAdmin()（见windosw_mesh.ino中的ADMIN_NODES）或编译参数-DMESH_ADMIN_NODE=<节点ID>配置
+     * @return 表满返回false
+     */
+    bool addAdmin(uint32_t nodeId);
+    bool isAdmin(uint32_t nodeId);                              ///< 是否管理节点
+    uint32_t getAdminRejected() { return admin_rejected; }      ///< 非管理节点发来的管理消息数
+
+    /**
+     * @brief 设置入网信息保存位置，需在begin()之前调用
+     */
+    void setStore(FlashStore *store) { this->store = store; }
+
+    bool isStarted() { return start_ms != 0; }              ///< 是否已开始组网
+    bool usedCachedChannel() { return cache_used; }         ///< 本次是否使用了缓存信道
+    bool cacheFellBack() { return cache_fallback; }         ///< 缓存信道超时后是否回退到全信道扫描
+    const MESH_CACHE &getCache() { return cache; }          ///< 当前入网信息
+    uint32_t getStartMs() { return start_ms; }              ///< 开始组网时间（复位后毫秒）
+    uint32_t getFirstJoinMs() { return first_join_ms; }     ///< 首次入网时间，0表示尚未入网
+    uint32_t getFirstMessageMs() { return first_msg_ms; }   ///< 首条mesh消息时间，0表示尚未收到
+    uint32_t getInitFailures() { return init_failures; }    ///< 传输层初始化失败次数
 
 private:
-    painlessMesh mesh; ///< painlessMesh实例，用于处理实际的网络通信
+    DefaultMeshTransport defaultTransport; ///< 默认传输层
+    MeshTransport *mesh; ///< 实际使用的传输层
     unsigned long lastConnectionCheck; ///< 上次检查连接的时间戳
     const int CHECK_INTERVAL = 5000; ///< 连接检查间隔（毫秒），每5秒检查一次
 
 
-    uint8_t slave_addr; ///< 从机地址
-    uint8_t slave_cmd; ///< 从机状态
-    uint8_t slave_sta; ///< 从机状态1为收到消息。0为未收到消息
+    MESH_CMD cmdQueueBuf[MESH_CMD_QUEUE_CAPACITY]; ///< 命令队列缓冲区
+    SimpleQueue cmdQueue; ///< 已准入、等待下发串口的命令
+    MESH_BLOCK blockQueueBuf[MESH_BLOCK_QUEUE_CAPACITY]; ///< 块读写队列缓冲区
+    SimpleQueue blockQueue; ///< 已准入、等待下发串口的块读写请求
+    MESH_GROUP_CMD groupQueueBuf[MESH_GROUP_QUEUE_CAPACITY]; ///< 组命令队列缓冲区
+    SimpleQueue groupQueue; ///< 已准入、等待下发串口的组命令
+    Admission admission; ///< 按来源节点的令牌桶准入控制
+    uint32_t trace_collector; ///< 发送"TRACE_START"的采集节点ID
+    uint16_t node_count; ///< 已连接节点数缓存
+    bool status_print_pending; ///< 有待打印的网络状态报告
+    ShardMap shard; ///< 从机地址分片
+    PeerLiveness liveness; ///< 节点存活检测和自适应心跳
+    LinkCost link; ///< 本机作为网关的链路开销
+    GatewaySelector selector; ///< 作为控制节点时的网关选择
+    uint32_t directed;
+
+    /**
+     * @brief 广播并记录发送时间（广播本身即向所有邻居证明本机存活）
+     */
+    bool broadcast(String &msg);
+    bool announce_due; ///< 本机可达从机有变化，需要尽快公告
+    uint32_t last_announce; ///< 上次公告时间
+    uint32_t not_owned;
+    uint32_t cmd_malformed;
+    uint32_t cmd_unknown;
+
+    /**
+     * @brief 广播本机可达从机位图并清理超时网关
+     */
+    void announceShard(uint32_t now);
+    FlashStore *store; ///< 入网信息保存位置
+    MESH_CACHE cache; ///< 入网信息
+    bool cache_used; ///< 本次使用缓存信道
+    bool cache_fallback; ///< 已回退到全信道扫描
+    uint32_t start_ms;
+    uint32_t first_join_ms;
+    uint32_t first_msg_ms;
+    uint32_t init_failures;
+    uint32_t admins[MESH_ADMIN_MAX]; ///< 管理节点ID，0表示空闲
+    uint32_t admin_rejected;
+    uint32_t last_init_ms; ///< 上次初始化失败的时间
+
+    /**
+     * @brief 入网后保存信道和上级节点BSSID（未变化时不擦写flash）
+     */
+    void saveCache();
+
+    /**
+     * @brief 向来源节点发送忙消息
+     * @param nodeId 来源节点ID
+     * @param retry_after 建议重试等待时间（毫秒）
+     */
+    void sendBusy(uint32_t nodeId, uint32_t retry_after);
+
+    /**
+     * @brief 解析块读写消息
+     * @return 格式错误返回false
+     */
+    static bool parseBlock(const String &msg, MODBUS_BLOCK *block);
+
+    /**
+     * @brief 准入后入队，失败时按需回复忙消息
+     * @param priority 高优先级（停止等安全命令）不受速率限制，只受队列容量限制
+     */
+    void admitOrBusy(uint32_t from, SimpleQueue &queue, const void *element, bool priority = false);
+
+    /**
+     * @brief 应答历史查询
+     * @details 查询直接在回调中由本地存储应答，不占用串口准入预算
+     */
+    void answerTelemetry(uint32_t from, const String &msg);
 
     // Static instance pointer for callbacks
     static MeshNode* instance; ///< 静态实例指针，用于在静态回调函数中访问类成员
@@ -141,7 +418,7 @@ private:
     
     /**
      * @brief 网络拓扑变化时的回调函数
-     * 输出网络拓扑变化信息并打印当前网络状态
+     * 更新节点数缓存，网络状态报告推迟到printPending()打印
      */
     static void changedConnectionCallback();
     
@@ -0,0 +1,117 @@
+#include "meshtransport.hpp"
+
+/**
+ * @brief MeshTransport构造函数实现，回调默认为空
+ */
+MeshTransport::MeshTransport()
+    : receivedCb(nullptr), newConnectionCb(nullptr), changedCb(nullptr), droppedCb(nullptr)
+{
+}
+
+#if !defined(MESH_TRANSPORT_UDP)
+
+/**
+ * @brief 初始化painlessMesh并转发回调实现
+ */
+bool PainlessMeshTransport::init()
+{
+    if (channel == 0) {
+        mesh.init(MESH_PREFIX, MESH_PASSWORD, MESH_PORT);
+    } else {
+        mesh.init(MESH_PREFIX, MESH_PASSWORD, MESH_PORT, WIFI_AP_STA, channel);//只在已知信道上扫描
+    }
+    mesh.onReceive([this](uint32_t from, String &msg) {
+        if (receivedCb) receivedCb(from, msg);
+    });
+    mesh.onNewConnection([this](uint32_t nodeId) {
+        if (newConnectionCb) newConnectionCb(nodeId);
+    });
+    mesh.onChangedConnections([this]() {
+        if (changedCb) changedCb();
+    });
+    mesh.onDroppedConnection([this](uint32_t nodeId) {
+        if (droppedCb) droppedCb(nodeId);
+    });
+    return true;
+}
+
+void PainlessMeshTransport::update()
+{
+    mesh.update();
+}
+
+bool PainlessMeshTransport::sendBroadcast(String &msg)
+{
+    return mesh.sendBroadcast(msg);
+}
+
+bool PainlessMeshTransport::sendSingle(uint32_t dest, String &msg)
+{
+    return mesh.sendSingle(dest, msg);
+}
+
+uint32_t PainlessMeshTransport::getNodeId()
+{
+    return mesh.getNodeId();
+}
+
+std::list<uint32_t> PainlessMeshTransport::getNodeList()
+{
+    return mesh.getNodeList();
+}
+
+/**
+ * @brief painlessMesh维护的全网同步时间
+ */
+uint32_t PainlessMeshTransport::getNodeTime()
+{
+    return mesh.getNodeTime();
+}
+
+uint8_t PainlessMeshTransport::getChannel()
+{
+    return (uint8_t)WiFi.channel();
+}
+
+/**
+ * @brief 上级节点BSSID实现：没有已连接节点时视为未连接
+ */
+bool PainlessMeshTransport::getParentBssid(uint8_t *bssid)
+{
+    uint8_t *b = WiFi.BSSID();
+    if (b == nullptr || mesh.getNodeList().empty()) return false;
+    memcpy(bssid, b, 6);
+    return true;
+}
+
+void PainlessMeshTransport::stop()
+{
+    mesh.stop();
+}
+
+/**
+ * @brief 在以本节点为根的拓扑树中查找mesh根节点的深度
+ * @return 找不到返回0
+ */
+static uint8_t rootDepth(const painlessmesh::protocol::NodeTree &tree, uint8_t depth)
+{
+    if (tree.root) return depth;
+    for (const painlessmesh::protocol::NodeTree &sub : tree.subs) {
+        uint8_t d = rootDepth(sub, depth + 1);
+        if (d != 0) return d;
+    }
+    return 0;
+}
+
+/**
+ * @brief 跳数实现：asNodeTree()以本节点为树根，mesh根节点所在深度即跳数
+ */
+uint8_t PainlessMeshTransport::getHopCount()
+{
+    painlessmesh::protocol::NodeTree tree = mesh.asNodeTree();
+    if (tree.root) return 0;//本节点即根节点
+    uint8_t depth = rootDepth(tree, 0);
+    return depth != 0 ? depth : 1;
+}
+
+#endif // !MESH_TRANSPORT_UDP
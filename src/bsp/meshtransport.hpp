@@ -0,0 +1,153 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : meshtransport.hpp
+ * @brief          : Header for meshtransport.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef MESHTRANSPORT_HPP
+#define MESHTRANSPORT_HPP
+
+#include <Arduino.h>
+#include <list>
+
+#define MESH_PREFIX "MyMeshNet"
+#define MESH_PASSWORD "myPassword"
+#define MESH_PORT 5555
+
+// Linux上默认使用UDP组播传输层，定义MESH_TRANSPORT_PAINLESS可强制使用painlessMesh
+#if defined(__linux__) && !defined(MESH_TRANSPORT_PAINLESS)
+#define MESH_TRANSPORT_UDP
+#endif
+
+typedef void (*MeshReceivedCallback)(uint32_t from, String &msg);   ///< 收到消息回调
+typedef void (*MeshNodeCallback)(uint32_t nodeId);                  ///< 节点连接/断开回调
+typedef void (*MeshChangedCallback)();                              ///< 拓扑变化回调
+
+/**
+ * @brief Mesh传输层接口
+ * @details MeshNode只通过该接口收发消息，ESP8266上由painlessMesh实现，
+ *          Linux上由UDP组播实现，回调语义与painlessMesh保持一致
+ */
+class MeshTransport {
+public:
+    MeshTransport();
+    virtual ~MeshTransport() {}
+
+    /**
+     * @brief 初始化传输层并开始组网
+     * @return 成功返回true；套接字等资源创建失败返回false，可稍后重试
+     */
+    virtual bool init() = 0;
+
+    /**
+     * @brief 处理收发，需在主循环中反复调用，回调均在此函数内触发
+     */
+    virtual void update() = 0;
+
+    /**
+     * @brief 广播消息
+     * @return 返回发送是否成功
+     */
+    virtual bool sendBroadcast(String &msg) = 0;
+
+    /**
+     * @brief 单播消息
+     * @param dest 目标节点ID
+     * @return 目标不可达或发送失败返回false
+     */
+    virtual bool sendSingle(uint32_t dest, String &msg) = 0;
+
+    /**
+     * @brief 获取本节点ID
+     */
+    virtual uint32_t getNodeId() = 0;
+
+    /**
+     * @brief 获取已知节点列表（不含本节点）
+     */
+    virtual std::list<uint32_t> getNodeList() = 0;
+
+    /**
+     * @brief 获取全网同步时间（微秒，32位回绕）
+     */
+    virtual uint32_t getNodeTime() = 0;
+
+    /**
+     * @brief 设置下次init()使用的信道
+     * @param channel 信道，0表示使用默认配置（全信道扫描寻找mesh）
+     */
+    virtual void setChannel(uint8_t channel) { (void)channel; }
+
+    /**
+     * @brief 获取当前工作信道，未知返回0
+     */
+    virtual uint8_t getChannel() { return 0; }
+
+    /**
+     * @brief 获取上级节点（station连接的AP）的BSSID
+     * @return 未连接或不支持返回false
+     */
+    virtual bool getParentBssid(uint8_t *bssid) { (void)bssid; return false; }
+
+    /**
+     * @brief 停止组网，之后可重新init()
+     */
+    virtual void stop() {}
+
+    /**
+     * @brief 本节点到mesh根节点的跳数（链路开销的一部分）
+     * @return 没有根节点或不支持时返回1
+     */
+    virtual uint8_t getHopCount() { return 1; }
+
+    void onReceive(MeshReceivedCallback cb) { receivedCb = cb; }
+    void onNewConnection(MeshNodeCallback cb) { newConnectionCb = cb; }
+    void onChangedConnections(MeshChangedCallback cb) { changedCb = cb; }
+    void onDroppedConnection(MeshNodeCallback cb) { droppedCb = cb; }
+
+protected:
+    MeshReceivedCallback receivedCb;
+    MeshNodeCallback newConnectionCb;
+    MeshChangedCallback changedCb;
+    MeshNodeCallback droppedCb;
+};
+
+#if !defined(MESH_TRANSPORT_UDP)
+
+#include <painlessMesh.h>
+
+/**
+ * @brief 基于painlessMesh的传输层（ESP8266）
+ */
+class PainlessMeshTransport : public MeshTransport {
+public:
+    bool init() override;
+    void update() override;
+    bool sendBroadcast(String &msg) override;
+    bool sendSingle(uint32_t dest, String &msg) override;
+    uint32_t getNodeId() override;
+    std::list<uint32_t> getNodeList() override;
+    uint32_t getNodeTime() override;
+    void setChannel(uint8_t channel) override { this->channel = channel; }
+    uint8_t getChannel() override;
+    bool getParentBssid(uint8_t *bssid) override;
+    void stop() override;
+    uint8_t getHopCount() override;
+
+private:
+    painlessMesh mesh; ///< painlessMesh实例，用于处理实际的网络通信
+    uint8_t channel = 0; ///< 指定信道，0表示使用painlessMesh默认配置
+};
+
+#endif // !MESH_TRANSPORT_UDP
+
+#endif // MESHTRANSPORT_HPP
@@ -1,99 +1,476 @@
 #include "modbus.hpp"
 
+static ArduinoSerialPort defaultPort(MODBUS_SERIAL);  // 默认端口：MODBUS_SERIAL
+#if !defined(__linux__) && MODBUS_SECOND_BUS
+static SoftSerialPort secondPort(MODBUS2_RX_PIN, MODBUS2_TX_PIN);  // 第二条总线
+#endif
+
+/**
+ * @brief 第二条总线默认端口实现
+ */
+SerialPort *MODBUS::secondaryPort()
+{
+#if !defined(__linux__) && MODBUS_SECOND_BUS
+    return &secondPort;
+#else
+    return nullptr;
+#endif
+}
+
 /**
  * @brief MODBUS构造函数实现：新增SimpleQueue对象初始化，原有逻辑不变
  */
 MODBUS::MODBUS()
+    : MODBUS(&defaultPort)
+{
+}
+
+/**
+ * @brief MODBUS构造函数实现：使用注入的串口端口
+ * @param port 串口端口
+ */
+MODBUS::MODBUS(SerialPort *port)
     : modbusQueue(modbusQueueBuf, sizeof(byte), MODBUS_QUEUE_CAPACITY)  // 初始化SimpleQueue：绑定缓冲区+byte大小+容量
+    , port(port)
 {
     frameLen = 0;
     lastRecvTime = 0;
     serial_addr = 0;
     serial_sta = G_SERIAL_STOP;
+    tx_done_us = 0;
+    block_ready = false;
+    block_regs = 0;
+    parse_pos = 0;
+    parse_size = 0;
+    rescan_len = 0;
+    rescan_pos = 0;
+    memset(&stats, 0, sizeof(stats));
+    rx_policy = MODBUS_RX_DROP_OLDEST_FRAME;
+    flow = MODBUS_FLOW_NONE;
+    rts_pin = MODBUS_RTS_NONE;
+    flow_paused = false;
+    de_pin = MODBUS_DE_PIN;
 }
 
 
+/**
+ * @brief 更换串口端口实现，需在begin()之前调用
+ */
+void MODBUS::setPort(SerialPort *port)
+{
+    this->port = port;
+}
+
 /**
  * @brief 初始化Modbus实现 完全保留，仅调用类内clearQueue
  */
 void MODBUS::begin()
 {
-    MODBUS_SERIAL.begin(SERIAL_BAUD, SERIAL_8N1);  // 原有代码，不动
+    port->begin(SERIAL_BAUD);  // 8N1
+    dir.begin(port, de_pin, SERIAL_BAUD);
     modbusQueue.reset();  // 初始化队列，逻辑不变
+    if ((flow == MODBUS_FLOW_RTS && rts_pin == MODBUS_RTS_NONE) || (flow == MODBUS_FLOW_XONXOFF && dir.enabled())) {
+        flow = MODBUS_FLOW_NONE;//未指定RTS引脚，或在RS-485半双工总线上使用XON/XOFF：不流控
+    }
+    flow_paused = (flow != MODBUS_FLOW_NONE);
+    if (flow == MODBUS_FLOW_RTS) {
+        pinMode(rts_pin, OUTPUT);
+    }
+    updateFlow();  // 队列为空，允许从机发送
 }
 
 /**
- * @brief 串口接收事件处理实现：仅适配SimpleQueue::push（传地址），其余逻辑完全不变
+ * @brief 设置流控方式实现
+ * @details MODBUS_FLOW_RTS必须显式指定引脚，未指定时begin()关闭流控。
+ *          MODBUS_FLOW_XONXOFF不支持RS-485：XON/XOFF走普通发送路径，半双工总线上会与从机应答冲突，
+ *          方向控制还会把驱动期间收到的应答当作回波丢弃；并且帧负载是二进制的，0x11/0x13
+ *          可能出现在帧内。因此配置了DE引脚时begin()关闭流控，自动换向收发器也不应选择此方式；
+ *          只在全双工链路上、且从机只在帧间识别XON/XOFF时使用
+ * @param mode 流控方式
+ * @param rtsPin MODBUS_FLOW_RTS使用的引脚
+ */
+void MODBUS::setFlowControl(MODBUS_FLOW mode, uint8_t rtsPin)
+{
+    flow = mode;
+    rts_pin = rtsPin;
+}
+
+/**
+ * @brief 水位流控实现
+ * @details 达到高水位时拉高RTS或发送XOFF，降到低水位时拉低RTS或发送XON；
+ *          高低水位之间保持原状态，避免在临界点反复切换
+ */
+void MODBUS::updateFlow()
+{
+    if (flow == MODBUS_FLOW_NONE) {
+        return;
+    }
+    size_t pending = modbusQueue.count();
+    bool pause;
+    if (!flow_paused && pending >= MODBUS_RX_HIGH_WATER) {
+        pause = true;
+        stats.flow_pauses++;
+    } else if (flow_paused && pending <= MODBUS_RX_LOW_WATER) {
+        pause = false;
+    } else {
+        return;
+    }
+    flow_paused = pause;
+    if (flow == MODBUS_FLOW_RTS) {
+        digitalWrite(rts_pin, pause ? HIGH : LOW);
+    } else {
+        uint8_t c = pause ? MODBUS_XOFF : MODBUS_XON;
+        transmit(&c, 1);
+    }
+}
+
+/**
+ * @brief 丢弃队列中最早的一整帧实现
+ * @details 从队首向后找下一个帧头（非0x7B之后的7B 7B），丢弃其之前的所有字节；
+ *          队首字节可能是正在解析的帧的后半部分，因此同时复位解析状态，整帧丢弃而不是拼出坏帧
+ * @return 腾出了空间返回true
+ */
+bool MODBUS::dropOldestFrame()
+{
+    size_t n = modbusQueue.count();
+    size_t cut = n;
+    for (size_t i = 1; i + 1 < n; i++) {
+        if (*(uint8_t *)modbusQueue.peek(i) == 0x7B && *(uint8_t *)modbusQueue.peek(i + 1) == 0x7B
+            && *(uint8_t *)modbusQueue.peek(i - 1) != 0x7B) {
+            cut = i;
+            break;
+        }
+    }
+    this->parse_pos = 0;
+    this->rescan_len = 0;//待重新解析的字节比队列中的更早，一并丢弃
+    this->rescan_pos = 0;
+    stats.frames_dropped++;
+    stats.rx_dropped += modbusQueue.drop(cut);
+    return cut > 0;
+}
+
+/**
+ * @brief 串口接收事件处理实现
+ * @details 直接读入队列的连续空闲区，每次读取尽可能多的字节；
+ *          队列满时按rx_policy丢弃最早的整帧或新字节，每次读取后按水位更新流控
  */
 void MODBUS::serialEvent_callback()
 {
-    while (MODBUS_SERIAL.available() > 0) {
-        byte recvByte = MODBUS_SERIAL.read();
-        modbusQueue.push(&recvByte);
+    dir.poll();
+    if (dir.isDriving()) {
+        while (port->available() > 0) {
+            port->read();  // 本端发送期间收到的是回波
+            dir.noteEcho();
+        }
+        return;
+    }
+    bool overflow = false;
+    while (port->available() > 0) {
+        void *dest;
+        size_t room = modbusQueue.writableSpan(&dest);
+        if (room == 0) {
+            if (!overflow) {
+                overflow = true;
+                stats.rx_overflows++;
+            }
+            if (rx_policy == MODBUS_RX_DROP_OLDEST_FRAME && dropOldestFrame()) {
+                continue;
+            }
+            uint8_t lost = port->read();  // 队列已满，丢弃
+            TraceRecorder::recordRx(&lost, 1);
+            stats.rx_bytes++;
+            stats.rx_dropped++;
+            continue;
+        }
+        size_t n = port->read((uint8_t *)dest, room);
+        if (n == 0) break;
+        stats.rx_bytes += n;
+        dir.noteRx();
+        TraceRecorder::recordRx((uint8_t *)dest, n);
+        modbusQueue.commit(n);
+        updateFlow();
     }
 }
 
 /**
- * @brief 解析Modbus RTU帧实现：仅替换队列操作，Modbus核心逻辑完全不变
+ * @brief 解析Modbus RTU帧实现：按长度字节确定帧边界和校验位置
+ * @details 长度字节无效（过短或超过MAX_MODBUS_FRAME）时丢弃当前帧重新找帧头；
+ *          负载不足状态字段的帧（如短应答）不更新addr/sta/cmd，但可通过getFramePayload读取
  */
 uint32_t MODBUS::parseModbusFrame()
 {
-#define UART_CMD_HEAD 0x7b
-#define UART_CMD_TAIL 0x7d
 //7B 7B 09 10 03 01 00 00 00 00 0F 7D 7D
     uint8_t _data= 0;
-    uint8_t crc = 0;
-    static uint8_t uart_pos = 0;
-    while (!modbusQueue.isEmpty()) {
-        modbusQueue.pop(&_data);
-		if(((uart_pos == 0) && (_data==UART_CMD_HEAD))||((uart_pos == 1) && (_data == UART_CMD_HEAD))){//判断是不是帧头
-			modbusFrameBuf[uart_pos++] = _data;//启动接收
+    while (this->rescan_pos < this->rescan_len || !modbusQueue.isEmpty()) {
+        if(this->rescan_pos < this->rescan_len){
+            _data = this->rescanBuf[this->rescan_pos++];
+        } else {
+            modbusQueue.pop(&_data);
+        }
+		if(this->parse_pos < 2){//判断是不是帧头
+			this->parse_pos = (_data == 0x7B) ? this->parse_pos + 1 : 0;
+			modbusFrameBuf[0] = 0x7B;
+			modbusFrameBuf[1] = 0x7B;
 			continue;
 		}
-        if(uart_pos >= 2){//判断已收到准确的头帧
-			modbusFrameBuf[uart_pos++] = _data;
-			if(uart_pos >= 13){
-				crc = calculateXOR(modbusFrameBuf);
-				if(modbusFrameBuf[10] == crc){
-					uart_pos = 0;
-                    this->serial_addr = modbusFrameBuf[3];//获取从机地址
-                    this->serial_sta = modbusFrameBuf[7];//获取从机状态
-                    this->serial_cmd = modbusFrameBuf[8];//获取从机命令
-                    return (uint32_t)this->serial_addr << 16 | (uint32_t)this->serial_sta << 8 | (uint32_t)this->serial_cmd;
-                    /* 校验通过，处理数据 */
-				}else{uart_pos = 0;}
+		if(this->parse_pos == SlaveFrame::LEN_POS){//长度字节
+			if(_data == 0x7B){
+				continue;//连续多个帧头，仍视为帧头
+			}
+			if(!SlaveFrame::validLength(_data)){
+				stats.bad_frames++;
+				this->parse_pos = 0;
+				continue;
 			}
+			this->parse_size = SlaveFrame::frameSize(_data);
+		}
+		modbusFrameBuf[this->parse_pos++] = _data;
+		if(this->parse_pos >= this->parse_size){
+			this->parse_pos = 0;
+			if(SlaveFrame::decode(modbusFrameBuf)){
+				stats.rx_frames++;
+				this->frameLen = this->parse_size;
+				if(this->parseBlockReply()){
+					break;//块应答，留给调用者取走后再继续解析
+				}
+				if(SlaveFrame::payloadLen(modbusFrameBuf) <= MOTOR_FIELD_CMD){
+					continue;
+				}
+                this->serial_addr = MotorFrame::field(modbusFrameBuf, MOTOR_FIELD_ADDR);//获取从机地址
+                this->serial_sta = MotorFrame::field(modbusFrameBuf, MOTOR_FIELD_STA);//获取从机状态
+                this->serial_cmd = MotorFrame::field(modbusFrameBuf, MOTOR_FIELD_CMD);//获取从机命令
+                updateFlow();
+                return (uint32_t)this->serial_addr << 16 | (uint32_t)this->serial_sta << 8 | (uint32_t)this->serial_cmd;
+                /* 校验通过，处理数据 */
+			}
+			stats.bad_frames++;
+			this->rescan(this->parse_size);
 		}
     }
+    updateFlow();//队列已被取走一部分，降到低水位时恢复从机发送
     return 0;
 }
+
+/**
+ * @brief 校验失败后从假帧头之后的字节重新找帧头
+ * @details 假帧头可能是数据中恰好出现的7B 7B，它声明的长度吞掉的字节里可能含有真正的帧头，
+ *          把这些字节放到待重新解析字节的最前面，不丢掉紧随其后的有效帧
+ * @param size 失败帧的长度
+ */
+void MODBUS::rescan(uint8_t size)
+{
+    uint8_t rest = this->rescan_len - this->rescan_pos;
+    uint8_t n = size - SlaveFrame::LEN_POS;
+    memmove(this->rescanBuf + n, this->rescanBuf + this->rescan_pos, rest);
+    memcpy(this->rescanBuf, modbusFrameBuf + SlaveFrame::LEN_POS, n);
+    this->rescan_len = n + rest;
+    this->rescan_pos = 0;
+}
+
 /**
- * @brief 设置从机状态实现：新增校验逻辑，原有逻辑不变
+ * @brief 识别块读写应答
+ * @details 读应答负载为4+2N字节，写应答负载为4字节，其余帧按单命令状态帧处理
+ * @return 是块应答返回true
+ */
+bool MODBUS::parseBlockReply()
+{
+    const uint8_t *p = modbusFrameBuf + SlaveFrame::PAYLOAD_POS;
+    uint8_t len = SlaveFrame::payloadLen(modbusFrameBuf);
+    if (len < MODBUS_BLOCK_HDR) return false;
+    uint8_t func = p[MOTOR_FIELD_FUNC];
+    uint8_t count = p[MOTOR_FIELD_COUNT];
+    if (count == 0 || count > MODBUS_BLOCK_MAX_REGS) return false;
+    bool read_reply = (func == MODBUS_FN_READ_REGS) && (len == MODBUS_BLOCK_HDR + 2 * count);
+    bool write_reply = (func == MODBUS_FN_WRITE_REGS) && (len == MODBUS_BLOCK_HDR);
+    if (!read_reply && !write_reply) return false;
+
+    block_reply.addr = p[MOTOR_FIELD_ADDR];
+    block_reply.func = func;
+    block_reply.count = count;
+    block_reply.start = p[MOTOR_FIELD_REG];
+    if (read_reply) {
+        for (uint8_t i = 0; i < count; i++) {
+            block_reply.regs[i] = (uint16_t)p[MODBUS_BLOCK_HDR + 2 * i] << 8 | p[MODBUS_BLOCK_HDR + 2 * i + 1];
+        }
+    }
+    block_regs += count;
+    block_ready = true;
+    return true;
+}
+
+/**
+ * @brief 取走最近一次块读写应答实现
+ */
+bool MODBUS::getBlockReply(MODBUS_BLOCK *reply)
+{
+    if (!block_ready) return false;
+    *reply = block_reply;
+    block_ready = false;
+    return true;
+}
+
+/**
+ * @brief 块读请求实现
+ */
+bool MODBUS::read_block(uint8_t addr, uint8_t start, uint8_t count)
+{
+    MODBUS_BLOCK block;
+    block.addr = addr;
+    block.func = MODBUS_FN_READ_REGS;
+    block.start = start;
+    block.count = count;
+    return send_block(block);
+}
+
+/**
+ * @brief 块写请求实现
+ */
+bool MODBUS::write_block(uint8_t addr, uint8_t start, const uint16_t *values, uint8_t count)
+{
+    MODBUS_BLOCK block;
+    if (count > MODBUS_BLOCK_MAX_REGS) return false;
+    block.addr = addr;
+    block.func = MODBUS_FN_WRITE_REGS;
+    block.start = start;
+    block.count = count;
+    memcpy(block.regs, values, count * sizeof(uint16_t));
+    return send_block(block);
+}
+
+/**
+ * @brief 发送块读写请求实现
+ * @return 寄存器个数为0或超过MODBUS_BLOCK_MAX_REGS、功能码无效时返回false
+ */
+bool MODBUS::send_block(const MODBUS_BLOCK &block)
+{
+    uint8_t payload[SlaveFrame::MAX_PAYLOAD];
+    uint8_t len = MODBUS_BLOCK_HDR;
+    if (block.count == 0 || block.count > MODBUS_BLOCK_MAX_REGS) return false;
+    if (block.func != MODBUS_FN_READ_REGS && block.func != MODBUS_FN_WRITE_REGS) return false;
+    payload[MOTOR_FIELD_ADDR] = block.addr;
+    payload[MOTOR_FIELD_FUNC] = block.func;
+    payload[MOTOR_FIELD_COUNT] = block.count;
+    payload[MOTOR_FIELD_REG] = block.start;
+    if (block.func == MODBUS_FN_WRITE_REGS) {
+        for (uint8_t i = 0; i < block.count; i++) {
+            payload[len++] = block.regs[i] >> 8;
+            payload[len++] = block.regs[i] & 0xFF;
+        }
+    }
+    return set_slave_frame(payload, len);
+}
+
+/**
+ * @brief 读取最近一帧的完整负载实现
+ * @param buf 输出缓冲区
+ * @param len 缓冲区长度
+ * @return 负载长度，尚未收到有效帧返回0
+ */
+uint8_t MODBUS::getFramePayload(uint8_t *buf, uint8_t len)
+{
+    if (this->frameLen == 0) return 0;
+    uint8_t n = SlaveFrame::payloadLen(modbusFrameBuf);
+    if (n > len) n = len;
+    memcpy(buf, modbusFrameBuf + SlaveFrame::PAYLOAD_POS, n);
+    return n;
+}
+/**
+ * @brief 设置从机状态实现：由MotorFrame编码
  */
 void MODBUS::set_slave(uint8_t addr, uint8_t cmd)
 {
-    uint8_t tx_data[16] = {0};
-    tx_data[0] = 0x7b;
-    tx_data[1] = 0x7b;
-    tx_data[2] = 0x09;
-    tx_data[3] = addr;
-    tx_data[4] = 0x03;
-    tx_data[5] = 0x01;
-    tx_data[6] = addr;
-    tx_data[7] = 0x00;
-    tx_data[8] = cmd;
-    tx_data[9] = 0x00;
-    tx_data[10] = calculateXOR(tx_data);
-    tx_data[11] = 0x7d;
-    tx_data[12] = 0x7d;
-    MODBUS_SERIAL.write(tx_data, 13);
+    uint8_t payload[MotorFrame::PAYLOAD_LEN] = {0};
+    uint8_t tx_data[MotorFrame::FRAME_SIZE];
+    payload[MOTOR_FIELD_ADDR] = addr;
+    payload[MOTOR_FIELD_FUNC] = 0x03;
+    payload[MOTOR_FIELD_COUNT] = 0x01;
+    payload[MOTOR_FIELD_REG] = addr;
+    payload[MOTOR_FIELD_CMD] = cmd;
+    MotorFrame::encode(tx_data, payload);
+    transmit(tx_data, MotorFrame::FRAME_SIZE);
+    TraceRecorder::recordTx(tx_data, MotorFrame::FRAME_SIZE);
+    markTx(MotorFrame::FRAME_SIZE);
+}
+
+/**
+ * @brief 连发实现
+ * @details 所有帧先编码到同一缓冲区，再用一次write发出，帧与帧之间没有主循环间隙
+ * @param addrs 从机地址
+ * @param count 从机数，超过MODBUS_BURST_MAX的部分不发送
+ * @param cmd 命令
+ * @param first_done_us 输出第一帧预计发送完成时间（micros），可为nullptr
+ * @return 发出的帧数
+ */
+uint8_t MODBUS::set_slaves(const uint8_t *addrs, uint8_t count, uint8_t cmd, uint32_t *first_done_us)
+{
+    uint8_t tx_data[MotorFrame::FRAME_SIZE * MODBUS_BURST_MAX];
+    if (count > MODBUS_BURST_MAX) count = MODBUS_BURST_MAX;
+    if (count == 0) return 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t payload[MotorFrame::PAYLOAD_LEN] = {0};
+        payload[MOTOR_FIELD_ADDR] = addrs[i];
+        payload[MOTOR_FIELD_FUNC] = 0x03;
+        payload[MOTOR_FIELD_COUNT] = 0x01;
+        payload[MOTOR_FIELD_REG] = addrs[i];
+        payload[MOTOR_FIELD_CMD] = cmd;
+        MotorFrame::encode(tx_data + i * MotorFrame::FRAME_SIZE, payload);
+    }
+    transmit(tx_data, MotorFrame::FRAME_SIZE * count);
+    for (uint8_t i = 0; i < count; i++) {
+        TraceRecorder::recordTx(tx_data + i * MotorFrame::FRAME_SIZE, MotorFrame::FRAME_SIZE);
+        markTx(MotorFrame::FRAME_SIZE);
+        if (i == 0 && first_done_us != nullptr) {
+            *first_done_us = tx_done_us;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 发送任意负载长度的帧实现
+ * @param payload 负载（从从机地址开始）
+ * @param len 负载长度，最多SlaveFrame::MAX_PAYLOAD
+ * @return 负载过长返回false
+ */
+bool MODBUS::set_slave_frame(const uint8_t *payload, uint8_t len)
+{
+    uint8_t tx_data[MAX_MODBUS_FRAME];
+    uint8_t size = SlaveFrame::encode(tx_data, payload, len);
+    if (size == 0) return false;
+    transmit(tx_data, size);
+    TraceRecorder::recordTx(tx_data, size);
+    markTx(size);
+    return true;
+}
+
+/**
+ * @brief 发送实现：RS-485方向控制在写入前拉高DE，写入后按字符时间安排释放
+ */
+void MODBUS::transmit(const uint8_t *buf, size_t len)
+{
+    dir.acquire();
+    port->write(buf, len);
+    dir.transmitted(len);
+}
+
+/**
+ * @brief 记录发送完成时间
+ * @details write()只是放入发送FIFO，完成时间按线路忙到何时再加本帧线路时间估算
+ */
+void MODBUS::markTx(uint8_t len)
+{
+    stats.tx_frames++;
+    stats.tx_bytes += len;
+    uint32_t now = (uint32_t)Clock::micros64();
+    uint32_t start = ((int32_t)(tx_done_us - now) > 0) ? tx_done_us : now;
+    tx_done_us = start + (uint32_t)len * 10UL * 1000000UL / SERIAL_BAUD;
 }
 
 uint8_t MODBUS::calculateXOR(const uint8_t *data)
 {
     // 从第3字节开始计算8个字节的异或值 (跳过前两个0x7B)
     uint8_t xorValue = 0;
-    for (uint8_t pos = 2; pos <= data[2]; pos++) {
+    for (uint8_t pos = 2; pos <= data[2] && pos < MAX_MODBUS_FRAME; pos++) {
         xorValue ^= data[pos];
     }
     return xorValue;
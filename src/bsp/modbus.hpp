@@ -18,13 +18,104 @@
 
 #include <ESP8266WiFi.h>
 #include "queue.hpp"  // 引入你的SimpleQueue队列头文件
+#include "serialport.hpp"
+#include "trace.hpp"
+#include "framecodec.hpp"
+#include "rs485.hpp"
 
 // 原有Modbus宏定义 完全保留
 #define SERIAL_BAUD 9600
 #define MODBUS_SERIAL Serial
-#define MAX_MODBUS_FRAME 256
-// 新增：SimpleQueue队列配置（byte类型，容量512，适配Modbus接收）
-#define MODBUS_QUEUE_CAPACITY 512  // 队列最大容量，按需调整
+
+// 第二条从机总线：ESP8266上定义MODBUS_SECOND_BUS为1时启用SoftwareSerial（D5接收，D6发送），
+// 默认不启用（GPIO14/12可能另有用途）；Linux上由调用者注入端口
+#ifndef MODBUS_SECOND_BUS
+#define MODBUS_SECOND_BUS 0
+#endif
+#define MODBUS_BUS_MAX 2
+#define MODBUS2_RX_PIN 14
+#define MODBUS2_TX_PIN 12
+
+// 从机协议帧：7B 7B 09 addr 03 01 addr sta cmd 00 XOR 7D 7D
+typedef FrameCodec<0x7B, 0x7D, 0x09, XorChecksum> MotorFrame;
+// 负载字段偏移（相对MotorFrame::PAYLOAD_POS）
+#define MOTOR_FIELD_ADDR 0
+#define MOTOR_FIELD_FUNC 1
+#define MOTOR_FIELD_COUNT 2
+#define MOTOR_FIELD_REG 3
+#define MOTOR_FIELD_STA 4
+#define MOTOR_FIELD_CMD 5
+#define MODBUS_BURST_MAX 16  // set_slaves一次连发的帧数上限
+
+// 变长帧：解析和通用编码都以长度字节确定帧边界，最长MAX_MODBUS_FRAME字节（负载最多26字节）
+#define MAX_MODBUS_FRAME 32
+typedef VarFrameCodec<0x7B, 0x7D, MAX_MODBUS_FRAME, XorChecksum> SlaveFrame;
+static_assert(MotorFrame::FRAME_SIZE <= MAX_MODBUS_FRAME, "fixed motor frame must fit the parser buffer");
+
+// SimpleQueue队列配置：按最长变长帧分配，16帧共512字节，约可缓冲9600波特率下533ms的数据
+#define MODBUS_QUEUE_FRAMES 16
+#define MODBUS_QUEUE_CAPACITY (MAX_MODBUS_FRAME * MODBUS_QUEUE_FRAMES)
+
+// 接收队列水位：达到高水位时要求从机暂停发送，降到低水位时恢复
+#define MODBUS_RX_HIGH_WATER (MODBUS_QUEUE_CAPACITY * 3 / 4)
+#define MODBUS_RX_LOW_WATER (MODBUS_QUEUE_CAPACITY / 4)
+#define MODBUS_XON 0x11
+#define MODBUS_XOFF 0x13
+#define MODBUS_RTS_NONE 0xFF  // 未指定RTS引脚（GPIO0是启动引脚，不能作为默认值）
+
+// RS-485方向控制：DE/RE引脚，RS485_DE_NONE表示收发器自动换向或全双工
+#define MODBUS_DE_PIN RS485_DE_NONE
+
+/**
+ * @brief 接收队列满时的处理策略
+ */
+typedef enum {
+    MODBUS_RX_DROP_NEWEST,       ///< 丢弃新收到的字节（原行为），被截断的帧由校验丢弃
+    MODBUS_RX_DROP_OLDEST_FRAME, ///< 丢弃队列中最早的一整帧，为新数据腾出空间
+} MODBUS_RX_POLICY;
+
+/**
+ * @brief 接收流控方式（由水位驱动，与溢出策略独立）
+ */
+typedef enum {
+    MODBUS_FLOW_NONE,    ///< 不流控
+    MODBUS_FLOW_RTS,     ///< RTS引脚：低电平允许发送，高电平暂停，必须指定引脚
+    MODBUS_FLOW_XONXOFF, ///< 软件流控：向从机发送XOFF/XON，只用于全双工链路（见setFlowControl）
+} MODBUS_FLOW;
+
+// 块寄存器读写（参照Modbus功能码0x03/0x10），寄存器为16位大端
+// 读请求：addr 03 N start        应答：addr 03 N start v0H v0L ... （负载4+2N，与7字节单命令帧区分）
+// 写请求：addr 10 N start v0H v0L ...  应答：addr 10 N start
+#define MODBUS_FN_READ_REGS 0x03
+#define MODBUS_FN_WRITE_REGS 0x10
+#define MODBUS_BLOCK_HDR 4
+#define MODBUS_BLOCK_MAX_REGS ((SlaveFrame::MAX_PAYLOAD - MODBUS_BLOCK_HDR) / 2)
+
+/**
+ * @brief 块寄存器读写请求/应答
+ */
+typedef struct {
+    uint8_t addr;   ///< 从机地址
+    uint8_t func;   ///< MODBUS_FN_READ_REGS或MODBUS_FN_WRITE_REGS
+    uint8_t start;  ///< 起始寄存器
+    uint8_t count;  ///< 寄存器个数
+    uint16_t regs[MODBUS_BLOCK_MAX_REGS]; ///< 寄存器值（读应答/写请求）
+} MODBUS_BLOCK;
+
+/**
+ * @brief 单条总线的收发统计
+ */
+typedef struct {
+    uint32_t rx_bytes;    ///< 收到的字节数
+    uint32_t rx_dropped;  ///< 接收队列满丢弃的字节数
+    uint32_t rx_frames;   ///< 校验通过的帧数
+    uint32_t bad_frames;  ///< 长度或校验错误的帧数
+    uint32_t tx_frames;   ///< 发出的帧数
+    uint32_t tx_bytes;    ///< 发出的字节数
+    uint32_t rx_overflows;   ///< 接收队列溢出次数
+    uint32_t frames_dropped; ///< 按整帧丢弃的帧数（MODBUS_RX_DROP_OLDEST_FRAME）
+    uint32_t flow_pauses;    ///< 要求从机暂停发送的次数
+} MODBUS_STATS;
 
 typedef enum{
     G_SERIAL_STOP,
@@ -35,6 +126,8 @@ typedef enum{
 
 class MODBUS
 {
+    friend class Benchmark;  // 主机端性能测试直接测量calculateXOR
+
 private:
     // 1. SimpleQueue专属：静态字节缓冲区（核心，SimpleQueue基于此实现，无动态内存）
     byte modbusQueueBuf[MODBUS_QUEUE_CAPACITY];
@@ -46,20 +139,69 @@ private:
     uint16_t frameLen;
     unsigned long lastRecvTime;
     uint8_t calculateXOR(const uint8_t *data);
+    void markTx(uint8_t len);
+    void rescan(uint8_t size);
+    uint8_t parse_pos;    // 当前帧已收到的字节数（每个实例独立，多条总线互不干扰）
+    uint8_t parse_size;   // 当前帧总长（由长度字节确定）
+    byte rescanBuf[MAX_MODBUS_FRAME]; // 校验失败的假帧头之后已取出的字节，先于队列重新解析
+    uint8_t rescan_len;
+    uint8_t rescan_pos;
+    MODBUS_STATS stats;
+
+    SerialPort *port;  // 串口端口，默认包装MODBUS_SERIAL
+
+    uint32_t tx_done_us;  // 最近一帧预计发送完成时间（micros）
 
     uint8_t serial_addr;
     uint8_t serial_sta;
     uint8_t serial_cmd;
 
+    MODBUS_BLOCK block_reply;  // 最近一次块读写应答
+    bool block_ready;          // block_reply尚未被取走
+    uint32_t block_regs;       // 块操作累计传输的寄存器数
+    bool parseBlockReply();
+
+    MODBUS_RX_POLICY rx_policy;  // 接收队列满时的处理策略
+    MODBUS_FLOW flow;            // 流控方式
+    uint8_t rts_pin;             // MODBUS_FLOW_RTS使用的引脚
+    bool flow_paused;            // 已要求从机暂停发送
+    bool dropOldestFrame();
+    void updateFlow();
+
+    Rs485Direction dir;          // 半双工方向控制
+    uint8_t de_pin;              // DE/RE引脚
+    void transmit(const uint8_t *buf, size_t len);
+
 
 
 public:
     // 原有构造函数、方法声明 完全保留
     MODBUS();
+    MODBUS(SerialPort *port);  // 注入串口端口（如Linux termios端口）
+    void setPort(SerialPort *port);
     void begin();
     uint32_t parseModbusFrame();
     void serialEvent_callback();  // 串口接收事件处理方法（适配SimpleQueue::push）
     void set_slave(uint8_t addr, uint8_t cmd);
+    bool set_slave_frame(const uint8_t *payload, uint8_t len);  // 发送任意负载长度的帧
+    uint8_t set_slaves(const uint8_t *addrs, uint8_t count, uint8_t cmd, uint32_t *first_done_us);  // 多个从机同一命令，一次写入连续发出
+    uint8_t getFramePayload(uint8_t *buf, uint8_t len);  // 读取最近一帧的完整负载（多字段状态）
+    bool read_block(uint8_t addr, uint8_t start, uint8_t count);  // 一次请求读取连续count个寄存器
+    bool write_block(uint8_t addr, uint8_t start, const uint16_t *values, uint8_t count);  // 一次请求写入count个寄存器
+    bool send_block(const MODBUS_BLOCK &block);  // 按block.func发送读或写请求
+    bool getBlockReply(MODBUS_BLOCK *reply);  // 取走最近一次块读写应答
+    uint32_t getBlockRegs() { return block_regs; }  // 块操作累计传输的寄存器数
+    uint32_t getTxDoneUs() { return tx_done_us; }  // 最近一帧预计发送完成时间（micros）
+    const MODBUS_STATS &getStats() const { return stats; }  // 本总线收发统计
+    bool hasPort() const { return port != nullptr; }  // 是否已配置串口端口
+    size_t getRxPending() const { return modbusQueue.count(); }  // 接收队列中待解析的字节数
+    void setRxPolicy(MODBUS_RX_POLICY policy) { rx_policy = policy; }  // 设置接收队列满时的处理策略
+    void setFlowControl(MODBUS_FLOW mode, uint8_t rtsPin = MODBUS_RTS_NONE);  // 设置流控方式，需在begin()之前调用
+    MODBUS_FLOW getFlowControl() const { return flow; }  // 实际使用的流控方式（begin()可能关闭不支持的配置）
+    bool isFlowPaused() const { return flow_paused; }  // 是否已要求从机暂停发送
+    void setDirectionControl(uint8_t dePin) { de_pin = dePin; }  // 设置RS-485 DE/RE引脚，需在begin()之前调用
+    const Rs485Direction &getDirection() const { return dir; }  // 方向控制时序与统计
+    static SerialPort *secondaryPort();  // 第二条总线的默认端口，Linux上或未启用MODBUS_SECOND_BUS时为nullptr
     
 };
 
@@ -22,9 +22,11 @@ bool SimpleQueue::isFull() const {
 }
 
 bool SimpleQueue::push(const void *element) {
-    if (isFull()) return false;
-    
     noInterrupts();  // Disable interrupts
+    if (isFull()) {
+        interrupts();
+        return false;
+    }
     tail = (tail + 1) % capacity;
     if (head == -1) head = 0;
     void *dest = (char *)queue + (tail * element_size);
@@ -35,8 +37,12 @@ bool SimpleQueue::push(const void *element) {
     return true;
 }
 
+// The full check, head advance and tail advance happen in one critical
+// section, so a concurrent pop() can never see head moved but size stale.
 bool SimpleQueue::pushCyclic(const void *element) {
-    if (isFull()) {
+    noInterrupts();  // Disable interrupts
+    bool overwrite = isFull();
+    if (overwrite) {
         // Overwrite the oldest element
         head = (head + 1) % capacity;
     } else if (head == -1) {
@@ -44,13 +50,11 @@ bool SimpleQueue::pushCyclic(const void *element) {
         head = 0;
     }
 
-    // Standard push operation
-    noInterrupts();  // Disable interrupts
     tail = (tail + 1) % capacity;
     void *dest = (char *)queue + (tail * element_size);
     memcpy(dest, element, element_size);
-    
-    if (!isFull()) size++;  // Only increase size if not overwriting
+
+    if (!overwrite) size++;  // Only increase size if not overwriting
     interrupts();  // Enable interrupts
 
     return true;
@@ -73,6 +77,22 @@ bool SimpleQueue::pop(void *element) {
     return true;
 }
 
+// Discard up to n of the oldest elements, returns how many were dropped.
+size_t SimpleQueue::drop(size_t n) {
+    noInterrupts();  // Disable interrupts
+    if (n > size) n = size;
+    size -= n;
+    if (size == 0) {
+        head = -1;
+        tail = -1;
+    } else {
+        head = (head + n) % capacity;
+    }
+    interrupts();  // Enable interrupts
+
+    return n;
+}
+
 void *SimpleQueue::peek(size_t index) const {
     if (index >= size) {
         return NULL;
@@ -81,4 +101,27 @@ void *SimpleQueue::peek(size_t index) const {
     return (char *)queue + (pos * element_size);
 }
 
+// Contiguous free space after tail, so a producer can fill the ring in place
+// (e.g. one read() syscall straight into the buffer). Follow with commit().
+size_t SimpleQueue::writableSpan(void **dest) {
+    if (isFull()) return 0;
+    size_t start = (size == 0) ? 0 : (tail + 1) % capacity;
+    if (size == 0) {
+        head = -1;
+        tail = -1;
+    }
+    *dest = (char *)queue + (start * element_size);
+    size_t free = capacity - size;
+    size_t contiguous = capacity - start;
+    return free < contiguous ? free : contiguous;
+}
+
+void SimpleQueue::commit(size_t count) {
+    if (count == 0) return;
 
+    noInterrupts();  // Disable interrupts
+    if (head == -1) head = 0;
+    tail = (tail + count) % capacity;
+    size += count;
+    interrupts();  // Enable interrupts
+}
@@ -29,7 +29,10 @@ public:
     bool push(const void *element);
     bool pushCyclic(const void *element);
     bool pop(void *element);
+    size_t drop(size_t n);
     void *peek(size_t index) const;
+    size_t writableSpan(void **dest);
+    void commit(size_t count);
 
 private:
     volatile int head;
@@ -0,0 +1,195 @@
+#include "rs485.hpp"
+#include "time.hpp"
+
+#if !defined(__linux__)
+Rs485Direction *Rs485Direction::timer_owner = nullptr;
+
+/**
+ * @brief timer1单次中断：到了预定释放时间，发送FIFO已空则释放DE，否则重新定时
+ */
+void IRAM_ATTR Rs485Direction::releaseIsr()
+{
+    Rs485Direction *d = timer_owner;
+    if (d == nullptr || !d->driving) {
+        return;
+    }
+    uint32_t more = d->drainUs(d->release_at);  // 中断按预定时间触发，不在中断中读时钟
+    if (more != 0) {
+        timer1_write(more * RS485_TIMER_TICKS_PER_US);
+        return;
+    }
+    digitalWrite(d->de_pin, LOW);
+    d->driving = false;
+}
+#endif
+
+/**
+ * @brief Rs485Direction构造函数实现
+ */
+Rs485Direction::Rs485Direction()
+{
+    port = nullptr;
+    de_pin = RS485_DE_NONE;
+    char_us = 0;
+    turnaround_us = 0;
+    margin_us = 0;
+    driving = false;
+    drive_start = 0;
+    drive_end = 0;
+    release_at = 0;
+    line_idle = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief 初始化实现：换向静默取1.5字符时间，不低于RS485_TURNAROUND_MIN_US；释放余量向上取整到微秒
+ */
+void Rs485Direction::begin(SerialPort *port, uint8_t dePin, uint32_t baud)
+{
+    this->port = port;
+    de_pin = dePin;
+    char_us = (uint32_t)(RS485_CHAR_BITS * 1000000UL / baud);
+    turnaround_us = (uint32_t)(RS485_TURNAROUND_BITS * 1000000UL / baud);
+    if (turnaround_us < RS485_TURNAROUND_MIN_US) {
+        turnaround_us = RS485_TURNAROUND_MIN_US;
+    }
+    margin_us = (uint32_t)((RS485_RELEASE_MARGIN_BITS * 1000000UL + baud - 1) / baud);
+    if (!enabled()) {
+        return;
+    }
+    pinMode(de_pin, OUTPUT);
+    digitalWrite(de_pin, LOW);  // 默认接收
+    driving = false;
+#if !defined(__linux__)
+    if (timer_owner == nullptr) {
+        timer_owner = this;
+        timer1_isr_init();
+        timer1_attachInterrupt(releaseIsr);
+    }
+#endif
+}
+
+/**
+ * @brief 写入前实现
+ * @details 仍在驱动（上一帧还在发送FIFO中）时直接续发，不需要换向；
+ *          否则等到从机最后一个字节之后的换向静默结束再拉高DE
+ */
+void Rs485Direction::acquire()
+{
+    if (!enabled()) {
+        return;
+    }
+#if !defined(__linux__)
+    if (timer_owner == this) {
+        timer1_disable();  // 先停定时器，避免判断之后、写入之前被中断释放
+    }
+#endif
+    uint64_t now = Clock::micros64();
+    if (driving) {
+        if (drive_end < now) {
+            drive_end = now;  // 上一帧已发完但尚未释放，线路空闲期间不计入本帧
+        }
+        return;
+    }
+    if (now < line_idle) {
+        stats.waits++;
+        stats.wait_us += (uint32_t)(line_idle - now);
+        Clock::waitUntil(line_idle);
+        now = Clock::micros64();
+    }
+    digitalWrite(de_pin, HIGH);
+    driving = true;
+    drive_start = now;
+    drive_end = now;
+    stats.enables++;
+}
+
+/**
+ * @brief 写入后实现
+ */
+void Rs485Direction::transmitted(size_t len)
+{
+    if (!enabled()) {
+        return;
+    }
+    drive_end += (uint64_t)len * char_us;
+    release_at = drive_end + margin_us;
+    port->driveWindow(drive_start, release_at);
+    uint64_t now = Clock::micros64();
+    if (now >= release_at && port->txPending() == 0) {
+        release();  // 阻塞写入，返回时已发完
+        return;
+    }
+#if !defined(__linux__)
+    if (timer_owner == this) {
+        timer1_disable();
+        timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+        timer1_write((uint32_t)(now < release_at ? release_at - now : char_us) * RS485_TIMER_TICKS_PER_US);
+    }
+#endif
+}
+
+/**
+ * @brief 释放DE
+ */
+void Rs485Direction::release()
+{
+    digitalWrite(de_pin, LOW);
+    driving = false;
+}
+
+/**
+ * @brief 发送FIFO检查实现
+ * @details FIFO中还有n个字节时，它们和正在移位的一个字节按正常速率发完需要(n+1)个字符时间，
+ *          从now起推后预定释放时间
+ */
+uint32_t IRAM_ATTR Rs485Direction::drainUs(uint64_t now)
+{
+    uint16_t pending = port->txPending();
+    if (pending == 0) {
+        return 0;
+    }
+    stats.late_drains++;
+    uint32_t more = (uint32_t)(pending + 1) * char_us;
+    release_at = now + more;
+    return more;
+}
+
+/**
+ * @brief 轮询释放实现（未使用定时器的实例和主机）
+ * @details 主机上的仿真总线按driveWindow()通知的时间段检查时序，
+ *          相当于由定时器在预定时刻释放，这里只同步状态
+ */
+void Rs485Direction::poll()
+{
+    if (!enabled() || !driving) {
+        return;
+    }
+    uint64_t now = Clock::micros64();
+    if (now < release_at || drainUs(now) != 0) {
+        return;
+    }
+#if !defined(__linux__)
+    uint32_t late = (uint32_t)(now - release_at);
+    if (late > stats.late_max_us) {
+        stats.late_max_us = late;
+    }
+#endif
+    release();
+}
+
+/**
+ * @brief 收到字节实现
+ */
+void Rs485Direction::noteRx()
+{
+    line_idle = Clock::micros64() + turnaround_us;
+}
+
+/**
+ * @brief 是否正在驱动实现：以预定的释放时间为准，与实际释放DE的时刻一致
+ */
+bool Rs485Direction::isDriving()
+{
+    return enabled() && driving && Clock::micros64() < release_at;
+}
@@ -0,0 +1,128 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : rs485.hpp
+ * @brief          : Header for rs485.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef RS485_HPP
+#define RS485_HPP
+
+#include <Arduino.h>
+#include "serialport.hpp"
+
+#define RS485_DE_NONE 0xFF          ///< 不控制方向（全双工或自动换向收发器）
+#define RS485_CHAR_BITS 10          ///< 每字符位数（8N1）
+#define RS485_TURNAROUND_BITS 15    ///< 换向最小静默：1.5个字符时间（同Modbus RTU的t1.5）
+#define RS485_TURNAROUND_MIN_US 750 ///< 换向静默下限，19200波特以上固定为750微秒（同Modbus RTU）
+#define RS485_TIMER_TICKS_PER_US 5  ///< ESP8266 timer1在TIM_DIV16下每微秒的计数
+#define RS485_RELEASE_MARGIN_BITS 1 ///< 释放DE前在推算的最后一个停止位之后多保持的位数（移位寄存器状态不可读）
+
+/**
+ * @brief 方向控制统计
+ */
+typedef struct {
+    uint32_t enables;      ///< DE拉高（总线由接收转为发送）的次数
+    uint32_t waits;        ///< 发送前等待换向静默的次数
+    uint32_t wait_us;      ///< 累计等待时间（微秒）
+    uint32_t echo_dropped; ///< 驱动期间收到并丢弃的字节数（本端回波）
+    uint32_t late_max_us;  ///< 轮询释放时相对预定释放时间的最大延迟（定时器释放为0）
+    uint32_t late_drains;  ///< 到预定释放时间发送FIFO仍未空、推后释放的次数
+} RS485_STATS;
+
+/**
+ * @brief RS-485半双工方向控制
+ * @details 发送前拉高DE，按字符时间推算最后一个停止位离开线路的时刻，再加RS485_RELEASE_MARGIN_BITS个位的余量后释放DE：
+ *          ESP8266上由timer1单次中断释放（只有一个实例能使用定时器），其余实例和主机上在poll()中释放。
+ *          释放前检查端口的发送FIFO（SerialPort::txPending），UART实际发送晚于推算（中断延迟、FIFO填充慢）
+ *          而FIFO未空时，按剩余字节数加正在移位的一个字节重新定时，之后再检查；
+ *          ESP8266的UART不提供移位寄存器空闲状态，FIFO刚空时最后一个字节的收尾由余量覆盖；
+ *          写入为阻塞方式（如SoftwareSerial）时写入返回即已发完，直接释放。
+ *          收到从机字节后线路要静默RS485_TURNAROUND_BITS个位时间才允许再次驱动，
+ *          发送前不足的部分精确等待，不再使用固定延时；释放DE后立即接收应答
+ */
+class Rs485Direction {
+public:
+    Rs485Direction();
+
+    /**
+     * @brief 初始化
+     * @param port 串口端口（通知驱动时间段）
+     * @param dePin DE/RE引脚，RS485_DE_NONE表示不控制
+     * @param baud 波特率
+     */
+    void begin(SerialPort *port, uint8_t dePin, uint32_t baud);
+
+    bool enabled() const { return de_pin != RS485_DE_NONE; }
+
+    /**
+     * @brief 写入前调用：必要时等待换向静默，然后拉高DE
+     */
+    void acquire();
+
+    /**
+     * @brief 写入后调用：推算发送完成时间并安排释放DE
+     * @param len 本次写入的字节数
+     */
+    void transmitted(size_t len);
+
+    /**
+     * @brief 到期未释放时释放DE，每次轮询串口时调用
+     */
+    void poll();
+
+    /**
+     * @brief 收到从机字节：从现在起重新计算换向静默
+     */
+    void noteRx();
+
+    void noteEcho() { stats.echo_dropped++; }  ///< 丢弃了一个回波字节
+
+    /**
+     * @brief 本端是否正在驱动总线（此时收到的字节是本端回波）
+     */
+    bool isDriving();
+
+    uint32_t getCharUs() const { return char_us; }             ///< 每字符线路时间（微秒）
+    uint32_t getTurnaroundUs() const { return turnaround_us; } ///< 换向静默时间（微秒）
+    uint32_t getMarginUs() const { return margin_us; }         ///< 释放DE前的余量（微秒）
+    uint64_t getDriveEnd() const { return release_at; }        ///< 最近一次预定的DE释放时间
+    const RS485_STATS &getStats() const { return stats; }
+
+private:
+    SerialPort *port;
+    uint8_t de_pin;
+    uint32_t char_us;
+    uint32_t turnaround_us;
+    uint32_t margin_us;     ///< 释放余量（微秒）
+    volatile bool driving;  ///< DE为高（定时器中断中清除）
+    uint64_t drive_start;
+    uint64_t drive_end;     ///< 推算的最后一个停止位离开线路的时间
+    uint64_t release_at;    ///< 预定的DE释放时间
+    uint64_t line_idle;     ///< 最近一次收到字节后，允许再次驱动的时间
+    RS485_STATS stats;
+
+    void release();
+
+    /**
+     * @brief 到了预定释放时间，发送FIFO仍未空时需要再等待的时间
+     * @param now 当前时间（微秒）
+     * @return 0表示可以释放
+     */
+    uint32_t IRAM_ATTR drainUs(uint64_t now);
+
+#if !defined(__linux__)
+    static Rs485Direction *timer_owner;  ///< 使用timer1的实例
+    static void IRAM_ATTR releaseIsr();
+#endif
+};
+
+#endif // RS485_HPP
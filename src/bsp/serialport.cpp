@@ -0,0 +1,100 @@
+#include "serialport.hpp"
+
+/**
+ * @brief ArduinoSerialPort构造函数实现
+ * @param serial 使用的硬件串口
+ */
+ArduinoSerialPort::ArduinoSerialPort(HardwareSerial &serial) : serial(serial)
+{
+}
+
+/**
+ * @brief 初始化串口实现，固定8N1
+ */
+bool ArduinoSerialPort::begin(uint32_t baud)
+{
+    serial.begin(baud, SERIAL_8N1);
+    return true;
+}
+
+int ArduinoSerialPort::available()
+{
+    return serial.available();
+}
+
+int ArduinoSerialPort::read()
+{
+    return serial.read();
+}
+
+/**
+ * @brief 批量读取实现
+ * @details HardwareSerial::read(buf, len)直接从UART接收缓冲区拷贝，不等待超时
+ */
+size_t ArduinoSerialPort::read(uint8_t *buf, size_t len)
+{
+    int n = serial.read(buf, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t ArduinoSerialPort::write(const uint8_t *buf, size_t len)
+{
+    return serial.write(buf, len);
+}
+
+#if !defined(__linux__)
+/**
+ * @brief 发送FIFO字节数实现：直接读UART0状态寄存器，可在中断中调用
+ */
+uint16_t IRAM_ATTR ArduinoSerialPort::txPending()
+{
+    return (USS(0) >> USTXC) & 0xFF;
+}
+#endif
+
+#if !defined(__linux__)
+/**
+ * @brief SoftSerialPort构造函数实现
+ * @param rxPin 接收引脚
+ * @param txPin 发送引脚
+ */
+SoftSerialPort::SoftSerialPort(uint8_t rxPin, uint8_t txPin) : serial(rxPin, txPin)
+{
+}
+
+/**
+ * @brief 初始化软件串口实现，固定8N1
+ */
+bool SoftSerialPort::begin(uint32_t baud)
+{
+    serial.begin(baud);
+    return true;
+}
+
+int SoftSerialPort::available()
+{
+    return serial.available();
+}
+
+int SoftSerialPort::read()
+{
+    return serial.read();
+}
+
+/**
+ * @brief 批量读取实现，只取已在接收缓冲区中的字节
+ */
+size_t SoftSerialPort::read(uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len && serial.available() > 0) {
+        buf[n++] = serial.read();
+    }
+    return n;
+}
+
+size_t SoftSerialPort::write(const uint8_t *buf, size_t len)
+{
+    return serial.write(buf, len);
+}
+#endif
@@ -0,0 +1,123 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : serialport.hpp
+ * @brief          : Header for serialport.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef SERIALPORT_HPP
+#define SERIALPORT_HPP
+
+#include <Arduino.h>
+#if !defined(__linux__)
+#include <SoftwareSerial.h>
+#endif
+
+/**
+ * @brief 串口端口接口
+ * @details MODBUS只通过该接口收发字节，ESP8266上使用ArduinoSerialPort，
+ *          Linux上使用LinuxSerialPort（termios），便于同一套APP/MODBUS逻辑在两端运行
+ */
+class SerialPort {
+public:
+    virtual ~SerialPort() {}
+
+    /**
+     * @brief 打开并配置串口
+     * @param baud 波特率
+     * @return 成功返回true
+     */
+    virtual bool begin(uint32_t baud) = 0;
+
+    /**
+     * @brief 获取可读字节数
+     */
+    virtual int available() = 0;
+
+    /**
+     * @brief 读取一个字节
+     * @return 读到的字节，无数据返回-1
+     */
+    virtual int read() = 0;
+
+    /**
+     * @brief 批量读取（非阻塞）
+     * @param buf 目标缓冲区
+     * @param len 最多读取的字节数
+     * @return 实际读取的字节数
+     */
+    virtual size_t read(uint8_t *buf, size_t len) = 0;
+
+    /**
+     * @brief 写入数据
+     * @param buf 数据地址
+     * @param len 数据长度
+     * @return 实际写入的字节数
+     */
+    virtual size_t write(const uint8_t *buf, size_t len) = 0;
+
+    /**
+     * @brief 半双工总线：本端驱动器（DE）使能的时间段
+     * @details 由Rs485Direction在每次写入后通知，真实串口忽略；
+     *          仿真总线据此检查换向时序（驱动期间与从机应答是否重叠、是否在最后一个停止位前释放）
+     * @param start_us DE拉高时间（Clock::micros64）
+     * @param end_us 预定的DE释放时间
+     */
+    virtual void driveWindow(uint64_t /*start_us*/, uint64_t /*end_us*/) {}
+
+    /**
+     * @brief 发送FIFO中尚未发出的字节数（不含正在移位的字节）
+     * @details Rs485Direction在预定时刻释放DE前检查，FIFO未空时推后释放；
+     *          可能在定时器中断中调用，实现不能阻塞。写入返回时已发完的端口返回0
+     */
+    virtual uint16_t txPending() { return 0; }
+};
+
+/**
+ * @brief 基于Arduino HardwareSerial的串口端口（ESP8266 UART0）
+ */
+class ArduinoSerialPort : public SerialPort {
+public:
+    ArduinoSerialPort(HardwareSerial &serial);
+    bool begin(uint32_t baud) override;
+    int available() override;
+    int read() override;
+    size_t read(uint8_t *buf, size_t len) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+#if !defined(__linux__)
+    uint16_t txPending() override;
+#endif
+
+private:
+    HardwareSerial &serial; ///< 实际使用的硬件串口
+};
+
+#if !defined(__linux__)
+/**
+ * @brief 基于SoftwareSerial的串口端口（ESP8266第二条从机总线）
+ * @details 软件串口由引脚中断接收，接收缓冲区由SoftwareSerial内部维护，
+ *          不会触发serialEvent()，需要在主循环中轮询
+ */
+class SoftSerialPort : public SerialPort {
+public:
+    SoftSerialPort(uint8_t rxPin, uint8_t txPin);
+    bool begin(uint32_t baud) override;
+    int available() override;
+    int read() override;
+    size_t read(uint8_t *buf, size_t len) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+
+private:
+    SoftwareSerial serial; ///< 实际使用的软件串口
+};
+#endif
+
+#endif // SERIALPORT_HPP
@@ -0,0 +1,166 @@
+#include "shard.hpp"
+
+/**
+ * @brief ShardMap构造函数实现
+ */
+ShardMap::ShardMap()
+{
+    memset(gateways, 0, sizeof(gateways));
+    gateways[0].cost = SHARD_COST_UNKNOWN;
+    count = 1;
+    ring_size = 0;
+    self = 0;
+    reassigned = 0;
+}
+
+/**
+ * @brief FNV-1a哈希（两个32位数）加murmur3末尾混合
+ */
+uint32_t ShardMap::hash(uint32_t a, uint32_t b)
+{
+    uint32_t h = 2166136261UL;
+    for (uint8_t i = 0; i < 4; i++) {
+        h = (h ^ ((a >> (8 * i)) & 0xFF)) * 16777619UL;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        h = (h ^ ((b >> (8 * i)) & 0xFF)) * 16777619UL;
+    }
+    h ^= h >> 16;//末尾混合，使小整数输入在环上分布均匀
+    h *= 0x85EBCA6BUL;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35UL;
+    h ^= h >> 16;
+    return h;
+}
+
+void ShardMap::setSelf(uint32_t nodeId)
+{
+    self = nodeId;
+    gateways[0].node_id = nodeId;
+    rebuild();
+}
+
+bool ShardMap::setLocalReach(uint8_t addr)
+{
+    if (canReach(gateways[0], addr)) return false;
+    gateways[0].reach[addr >> 3] |= 1 << (addr & 7);
+    return true;
+}
+
+/**
+ * @brief 处理公告实现，表满时忽略新网关
+ */
+void ShardMap::announce(uint32_t from, const uint8_t *reach, uint32_t now, uint8_t cost)
+{
+    if (from == self || from == 0) return;
+    for (uint8_t i = 1; i < count; i++) {
+        if (gateways[i].node_id == from) {
+            memcpy(gateways[i].reach, reach, SHARD_REACH_BYTES);
+            gateways[i].last_seen = now;
+            gateways[i].cost = cost;
+            return;
+        }
+    }
+    if (count >= SHARD_MAX_GATEWAYS) return;
+    gateways[count].node_id = from;
+    gateways[count].last_seen = now;
+    gateways[count].cost = cost;
+    memcpy(gateways[count].reach, reach, SHARD_REACH_BYTES);
+    count++;
+    rebuild();
+}
+
+void ShardMap::remove(uint32_t nodeId)
+{
+    for (uint8_t i = 1; i < count; i++) {
+        if (gateways[i].node_id == nodeId) {
+            gateways[i] = gateways[count - 1];
+            count--;
+            reassigned++;
+            rebuild();
+            return;
+        }
+    }
+}
+
+void ShardMap::expire(uint32_t now)
+{
+    for (uint8_t i = count - 1; i >= 1; i--) {
+        if ((now - gateways[i].last_seen) > SHARD_TIMEOUT) {
+            remove(gateways[i].node_id);
+        }
+    }
+}
+
+/**
+ * @brief 重建哈希环（按哈希值插入排序，最多SHARD_MAX_GATEWAYS*SHARD_VNODES=128个点）
+ */
+void ShardMap::rebuild()
+{
+    ring_size = 0;
+    for (uint8_t g = 0; g < count; g++) {
+        if (gateways[g].node_id == 0) continue;
+        for (uint8_t v = 0; v < SHARD_VNODES; v++) {
+            Point p = { hash(gateways[g].node_id, v), g };
+            uint8_t j = ring_size++;
+            while (j > 0 && ring[j - 1].hash > p.hash) {
+                ring[j] = ring[j - 1];
+                j--;
+            }
+            ring[j] = p;
+        }
+    }
+}
+
+/**
+ * @brief 查询归属实现
+ * @details 从地址哈希处顺时针遍历整环，第一个公告可达的网关即归属
+ */
+uint32_t ShardMap::owner(uint8_t addr) const
+{
+    if (ring_size == 0) return 0;
+    uint32_t h = hash(addr, 0x5A5A5A5AUL);
+    uint8_t start = 0;
+    while (start < ring_size && ring[start].hash < h) {
+        start++;
+    }
+    for (uint8_t i = 0; i < ring_size; i++) {
+        const Gateway &g = gateways[ring[(start + i) % ring_size].gw];
+        if (canReach(g, addr)) return g.node_id;
+    }
+    return 0;
+}
+
+/**
+ * @brief 最低开销网关实现：从地址在环上的位置顺时针遍历，只有开销严格更低才替换
+ */
+uint32_t ShardMap::cheapest(uint8_t addr, uint8_t *cost) const
+{
+    if (ring_size == 0) return 0;
+    uint32_t h = hash(addr, 0x5A5A5A5AUL);
+    uint8_t start = 0;
+    while (start < ring_size && ring[start].hash < h) {
+        start++;
+    }
+    const Gateway *best = nullptr;
+    for (uint8_t i = 0; i < ring_size; i++) {
+        const Gateway &g = gateways[ring[(start + i) % ring_size].gw];
+        if (canReach(g, addr) && (best == nullptr || g.cost < best->cost)) {
+            best = &g;
+        }
+    }
+    if (best == nullptr) return 0;
+    if (cost != nullptr) *cost = best->cost;
+    return best->node_id;
+}
+
+bool ShardMap::reaches(uint32_t nodeId, uint8_t addr, uint8_t *cost) const
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (gateways[i].node_id == nodeId && canReach(gateways[i], addr)) {
+            if (cost != nullptr) *cost = gateways[i].cost;
+            return true;
+        }
+    }
+    return false;
+}
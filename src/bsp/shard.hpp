@@ -0,0 +1,134 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : shard.hpp
+ * @brief          : Header for shard.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <Arduino.h>
+
+#define SHARD_MAX_GATEWAYS 8        ///< 参与分片的网关数上限（含本机）
+#define SHARD_VNODES 16             ///< 每个网关在哈希环上的虚拟节点数
+#define SHARD_REACH_BYTES 32        ///< 可达从机位图长度（256个地址）
+#define SHARD_ANNOUNCE_MS 5000      ///< 可达从机公告周期（毫秒）
+#define SHARD_TIMEOUT 15000         ///< 超过该时间未收到公告的网关移出哈希环（毫秒）
+#define SHARD_TAG "SHD"             ///< 公告："SHD" 可达从机位图(32) [链路开销(1)]
+#define SHARD_COST_UNKNOWN 0xFF     ///< 未公告链路开销（旧版本网关）
+
+/**
+ * @brief 多网关从机地址分片
+ * @details 每个网关在哈希环上放SHARD_VNODES个虚拟节点，从机地址哈希后顺时针查找，
+ *          取第一个公告过能到达该从机的网关；多个网关都能到达时（同一总线接了多个网关）
+ *          环上顺序在前的为主，其余为副本，主网关离开后由下一个副本接管。
+ *          网关加入或离开只影响环上与它相邻的地址，其余地址的归属不变。
+ *          没有任何网关公告可达的地址处于发现状态：所有网关都下发，由从机应答学习可达性。
+ */
+class ShardMap {
+public:
+    ShardMap();
+
+    /**
+     * @brief 设置本机节点ID（组网后调用）
+     */
+    void setSelf(uint32_t nodeId);
+
+    /**
+     * @brief 标记本机可到达的从机
+     * @return 位图有变化返回true
+     */
+    bool setLocalReach(uint8_t addr);
+
+    /**
+     * @brief 处理其他网关的公告
+     * @param from 网关节点ID
+     * @param reach 可达从机位图，SHARD_REACH_BYTES字节
+     * @param now 当前时间（毫秒）
+     */
+    void announce(uint32_t from, const uint8_t *reach, uint32_t now, uint8_t cost = SHARD_COST_UNKNOWN);
+
+    /**
+     * @brief 设置本机链路开销（随公告发出）
+     */
+    void setLocalCost(uint8_t cost) { gateways[0].cost = cost; }
+
+    /**
+     * @brief 移除网关（断开或超时），只重新分配它负责的地址
+     */
+    void remove(uint32_t nodeId);
+
+    /**
+     * @brief 移除超时未公告的网关
+     */
+    void expire(uint32_t now);
+
+    /**
+     * @brief 查询从机地址的归属网关
+     * @return 网关节点ID，没有网关公告可达时返回0
+     */
+    uint32_t owner(uint8_t addr) const;
+
+    /**
+     * @brief 本机是否应处理该地址的命令（归属本机或处于发现状态）
+     */
+    bool isLocal(uint8_t addr) const { uint32_t o = owner(addr); return o == 0 || o == self; }
+
+    /**
+     * @brief 本机是否已确定为该地址的归属网关（不含发现状态，保证同一地址只有一个网关成立）
+     */
+    bool isOwner(uint8_t addr) const { return self != 0 && owner(addr) == self; }
+
+    /**
+     * @brief 查询能到达该地址、链路开销最低的网关，开销相同时按环上顺序
+     * @param cost 输出该网关的链路开销，可为nullptr
+     * @return 网关节点ID，没有网关公告可达时返回0
+     */
+    uint32_t cheapest(uint8_t addr, uint8_t *cost) const;
+
+    /**
+     * @brief 指定网关能否到达该地址
+     * @param cost 输出该网关的链路开销，可为nullptr
+     */
+    bool reaches(uint32_t nodeId, uint8_t addr, uint8_t *cost) const;
+
+    bool canReachLocal(uint8_t addr) const { return canReach(gateways[0], addr); } ///< 本机能否到达该地址
+    uint8_t getLocalCost() const { return gateways[0].cost; } ///< 本机链路开销
+    const uint8_t *getLocalReach() const { return gateways[0].reach; } ///< 本机可达从机位图
+    uint8_t getGatewayCount() const { return count; }                  ///< 环上网关数
+    uint32_t getReassigned() const { return reassigned; }              ///< 因网关离开而重算归属的次数
+
+private:
+    struct Gateway {
+        uint32_t node_id;
+        uint32_t last_seen;
+        uint8_t reach[SHARD_REACH_BYTES];
+        uint8_t cost;   ///< 链路开销，越小越好
+    };
+    struct Point {
+        uint32_t hash;
+        uint8_t gw;     ///< gateways[]下标
+    };
+
+    Gateway gateways[SHARD_MAX_GATEWAYS];  ///< gateways[0]为本机
+    uint8_t count;
+    Point ring[SHARD_MAX_GATEWAYS * SHARD_VNODES];
+    uint8_t ring_size;
+    uint32_t self;
+    uint32_t reassigned;
+
+    void rebuild();
+    static uint32_t hash(uint32_t a, uint32_t b);
+    static bool canReach(const Gateway &g, uint8_t addr) { return g.reach[addr >> 3] & (1 << (addr & 7)); }
+};
+
+#endif // SHARD_HPP
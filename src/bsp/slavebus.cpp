@@ -0,0 +1,286 @@
+#include "slavebus.hpp"
+
+#if defined(__linux__)
+
+/**
+ * @brief VirtualSlaveBus构造函数实现
+ */
+VirtualSlaveBus::VirtualSlaveBus(const SLAVEBUS_CONFIG &config)
+    : config(config)
+{
+    if (this->config.slaves > SLAVEBUS_MAX_SLAVES) this->config.slaves = SLAVEBUS_MAX_SLAVES;
+    byte_us = 10UL * 1000000UL / config.baud;
+    bus_free = 0;
+    gw_end = 0;
+    slave_end = 0;
+    de_end = 0;
+    gw_collided = false;
+    memset(state, G_SERIAL_STOP, sizeof(state));
+    rng = config.seed ? config.seed : 1;
+    commands = 0;
+    bad_frames = 0;
+    replies = 0;
+    dropouts = 0;
+    corrupted = 0;
+    busy_us = 0;
+    contention = 0;
+    truncated = 0;
+}
+
+/**
+ * @brief 波特率由配置决定，这里只检查与网关一致
+ */
+bool VirtualSlaveBus::begin(uint32_t baud)
+{
+    return baud == config.baud;
+}
+
+/**
+ * @brief 伪随机数（xorshift32）
+ */
+uint32_t VirtualSlaveBus::random()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/**
+ * @brief 网关发送实现
+ * @details 网关串口按顺序发送自己的字节，不等待从机；从机按字节流找帧，帧在最后一个字节发送完成时生效。
+ *          与从机应答重叠时，重叠之后的字节从机收到的是乱码
+ */
+size_t VirtualSlaveBus::write(const uint8_t *buf, size_t len)
+{
+    uint64_t now = Clock::micros64();
+    advance(now);
+    uint64_t start = gw_end > now ? gw_end : now;
+    uint64_t end = start + (uint64_t)len * byte_us;
+    uint64_t clash = end;//网关字节从此时起与从机应答重叠
+    if (slave_end > start) {
+        clash = start;//从机应答还在线路上
+        corruptReplies(start);
+    }
+    clash = markCollided(end, clash);
+    uint64_t t = start;
+    for (size_t i = 0; i < len; i++) {
+        t += byte_us;
+        uint8_t b = buf[i];
+        if (t > clash) {
+            b ^= 0xFF;
+        }
+        if (rx_frame.size() < 2) {
+            if (b == 0x7B) rx_frame.push_back((char)b); else rx_frame.clear();
+            continue;
+        }
+        if (rx_frame.size() == 2 && b == 0x7B) {
+            continue;//连续帧头
+        }
+        rx_frame.push_back((char)b);
+        if (rx_frame.size() == MotorFrame::FRAME_SIZE) {
+            onFrame((const uint8_t *)rx_frame.data(), t);
+            rx_frame.clear();
+            clash = markCollided(end, clash);//刚收到命令的从机可能在本次写入结束前应答
+        }
+    }
+    gw_collided = clash < end;
+    if (gw_collided) {
+        contention++;
+    }
+    occupy(start, end);
+    gw_end = end;
+    return len;
+}
+
+/**
+ * @brief 标记将在网关发送结束前开始应答的从机
+ * @param end 网关本次写入的结束时间
+ * @param clash 当前已知的重叠开始时间
+ * @return 更新后的重叠开始时间
+ */
+uint64_t VirtualSlaveBus::markCollided(uint64_t end, uint64_t clash)
+{
+    for (auto &p : pending) {
+        if (p.due >= end) break;
+        p.collided = true;
+        if (p.due < clash) clash = p.due;
+    }
+    return clash;
+}
+
+/**
+ * @brief 网关DE时间段检查实现（写入已计为冲突时不重复计数）
+ */
+void VirtualSlaveBus::driveWindow(uint64_t start_us, uint64_t end_us)
+{
+    if (!gw_collided && replies > 0 && start_us < slave_end + config.turnaround_us) {
+        contention++;//从机刚释放总线，静默不足
+    }
+    if (end_us < gw_end) {
+        truncated++;//最后一个停止位还没离开线路
+    }
+    de_end = end_us;
+}
+
+/**
+ * @brief 累计总线占用时间，重叠部分只计一次
+ */
+void VirtualSlaveBus::occupy(uint64_t start, uint64_t end)
+{
+    if (start < bus_free) start = bus_free;
+    if (end > start) {
+        busy_us += end - start;
+        bus_free = end;
+    }
+}
+
+/**
+ * @brief 破坏from之后到达网关的应答字节，这些应答不再作为完成的问答
+ */
+void VirtualSlaveBus::corruptReplies(uint64_t from)
+{
+    for (auto &b : to_gateway) {
+        if (b.first > from) b.second ^= 0xFF;
+    }
+    for (auto it = done.begin(); it != done.end();) {
+        if (it->reply_done > from) it = done.erase(it); else ++it;
+    }
+}
+
+/**
+ * @brief 从机收到完整命令帧
+ */
+void VirtualSlaveBus::onFrame(const uint8_t *frame, uint64_t at)
+{
+    if (!MotorFrame::decode(frame)) {
+        bad_frames++;
+        return;
+    }
+    uint8_t addr = MotorFrame::field(frame, MOTOR_FIELD_ADDR);
+    if (addr < 1 || addr > config.slaves) {
+        return;//总线上没有该从机
+    }
+    commands++;
+    uint8_t cmd = MotorFrame::field(frame, MOTOR_FIELD_CMD);
+    switch (cmd) {//与真实从机一样在应答中报告SERIAL_STA，读取命令不改变状态
+    case SLAVE_CMD_FORWARD:
+        state[addr] = G_SERIAL_CW;
+        break;
+    case SLAVE_CMD_REVERSE:
+        state[addr] = G_SERIAL_RW;
+        break;
+    case SLAVE_CMD_IDLE:
+    case SLAVE_CMD_STOP:
+        state[addr] = G_SERIAL_STOP;
+        break;
+    default:
+        break;
+    }
+    if (config.dropout_ppm && random() % 1000000 < config.dropout_ppm) {
+        dropouts++;
+        return;
+    }
+    uint32_t span = config.latency_max > config.latency_min ? config.latency_max - config.latency_min : 0;
+    Pending p;
+    p.due = at + config.latency_min + (span ? random() % (span + 1) : 0);
+    p.addr = addr;
+    p.cmd = cmd;
+    p.cmd_done = at;
+    p.collided = false;
+    auto pos = pending.end();
+    while (pos != pending.begin() && (pos - 1)->due > p.due) {
+        --pos;
+    }
+    pending.insert(pos, p);//按应答时间排序，advance只看队首
+}
+
+/**
+ * @brief 推进总线到now：已到期的从机按应答时间依次开始应答，不等待总线空闲
+ */
+void VirtualSlaveBus::advance(uint64_t now)
+{
+    while (!pending.empty() && pending.front().due <= now) {
+        Pending p = pending.front();
+        pending.pop_front();
+        uint8_t payload[MotorFrame::PAYLOAD_LEN] = {p.addr, 0x03, 0x01, p.addr, state[p.addr], p.cmd, 0x00};
+        uint8_t frame[MotorFrame::FRAME_SIZE];
+        MotorFrame::encode(frame, payload);
+        bool clash = p.collided;
+        if (p.due < slave_end) {
+            corruptReplies(p.due);//另一个从机还在应答
+            clash = true;
+        }
+        if (!p.collided && (p.due < de_end || p.due < slave_end)) {
+            contention++;//网关DE仍未释放或与另一个应答重叠
+            clash = true;
+        }
+        uint64_t t = p.due;
+        for (uint8_t i = 0; i < MotorFrame::FRAME_SIZE; i++) {
+            uint8_t b = frame[i];
+            if (config.noise_ppm && random() % 1000000 < config.noise_ppm) {
+                b ^= 1 << (random() % 8);
+                corrupted++;
+            }
+            if (clash) {
+                b ^= 0xFF;
+            }
+            t += byte_us;
+            auto pos = to_gateway.end();
+            while (pos != to_gateway.begin() && (pos - 1)->first > t) {
+                --pos;
+            }
+            to_gateway.insert(pos, std::make_pair(t, b));
+        }
+        occupy(p.due, t);
+        if (t > slave_end) slave_end = t;
+        replies++;
+        if (!clash) {
+            SLAVEBUS_TXN txn = {p.addr, p.cmd, p.cmd_done, t};
+            done.push_back(txn);
+        }
+    }
+}
+
+int VirtualSlaveBus::available()
+{
+    uint64_t now = Clock::micros64();
+    advance(now);
+    int n = 0;
+    for (const auto &b : to_gateway) {
+        if (b.first > now) break;
+        n++;
+    }
+    return n;
+}
+
+int VirtualSlaveBus::read()
+{
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+size_t VirtualSlaveBus::read(uint8_t *buf, size_t len)
+{
+    uint64_t now = Clock::micros64();
+    advance(now);
+    size_t n = 0;
+    while (n < len && !to_gateway.empty() && to_gateway.front().first <= now) {
+        buf[n++] = to_gateway.front().second;
+        to_gateway.pop_front();
+    }
+    return n;
+}
+
+/**
+ * @brief 取走已完成问答实现：只返回应答已全部到达网关的记录
+ */
+bool VirtualSlaveBus::popTransaction(SLAVEBUS_TXN *txn)
+{
+    if (done.empty() || done.front().reply_done > Clock::micros64()) return false;
+    *txn = done.front();
+    done.pop_front();
+    return true;
+}
+
+#endif // __linux__
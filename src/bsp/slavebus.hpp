@@ -0,0 +1,134 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : slavebus.hpp
+ * @brief          : Header for slavebus.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef SLAVEBUS_HPP
+#define SLAVEBUS_HPP
+
+#if defined(__linux__)
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "serialport.hpp"
+#include "modbus.hpp"
+#include "command.hpp"
+#include "time.hpp"
+
+#define SLAVEBUS_MAX_SLAVES 32  ///< 总线上的虚拟从机数上限
+
+/**
+ * @brief 虚拟总线配置
+ */
+typedef struct {
+    uint32_t baud;          ///< 波特率，每字节10位
+    uint8_t slaves;         ///< 从机数，地址为1..slaves
+    uint32_t latency_min;   ///< 从机收到完整命令到开始应答的最短时间（微秒）
+    uint32_t latency_max;   ///< 最长时间（微秒），在两者之间均匀分布
+    uint32_t noise_ppm;     ///< 应答中每个字节被翻转一位的概率（百万分之）
+    uint32_t dropout_ppm;   ///< 从机不应答的概率（百万分之）
+    uint32_t seed;          ///< 随机种子，同样的配置和输入得到同样的结果
+    uint32_t turnaround_us; ///< 从机应答结束后网关再次驱动前至少静默的时间（微秒），0只检查重叠
+} SLAVEBUS_CONFIG;
+
+/**
+ * @brief 一次完成的问答（用于统计时延）
+ */
+typedef struct {
+    uint8_t addr;
+    uint8_t cmd;
+    uint64_t cmd_done;    ///< 命令帧在总线上发送完成的时间（微秒）
+    uint64_t reply_done;  ///< 应答帧最后一个字节到达网关的时间（微秒）
+} SLAVEBUS_TXN;
+
+/**
+ * @brief 主机端虚拟从机总线
+ * @details 作为SerialPort接在MODBUS上，模拟半双工多点总线：
+ *          网关写入的字节按波特率占用总线，从机收到完整的7B 7B…7D 7D命令帧后，
+ *          经过配置的应答延时发出状态应答，应答字节按线路时间逐个到达网关。
+ *          各驱动方互不等待：网关写入与正在发送或将在其发送期间开始的从机应答重叠、
+ *          两个从机应答重叠都计为冲突，重叠的两帧都被破坏（网关帧从机收不到，应答帧校验失败）。
+ *          所有时间取自Clock，注入VirtualClock时结果完全可复现。
+ *          网关使用RS-485方向控制时，另按driveWindow()通知的DE时间段检查换向：
+ *          DE在从机应答后的静默内拉高、从机开始应答时DE仍未释放也计为冲突，
+ *          DE在最后一个停止位离开线路前释放计为截断。
+ */
+class VirtualSlaveBus : public SerialPort {
+public:
+    VirtualSlaveBus(const SLAVEBUS_CONFIG &config);
+
+    bool begin(uint32_t baud) override;
+    int available() override;
+    int read() override;
+    size_t read(uint8_t *buf, size_t len) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+    void driveWindow(uint64_t start_us, uint64_t end_us) override;
+
+    /**
+     * @brief 取走已完成的问答记录
+     */
+    bool popTransaction(SLAVEBUS_TXN *txn);
+
+    uint8_t getState(uint8_t addr) const { return addr >= 1 && addr <= config.slaves ? state[addr] : (uint8_t)G_SERIAL_STOP; } ///< 从机电机状态（SERIAL_STA）
+    uint32_t getCommands() const { return commands; }     ///< 从机收到的有效命令帧数
+    uint32_t getBadFrames() const { return bad_frames; }  ///< 帧格式或校验错误的命令帧数
+    uint32_t getReplies() const { return replies; }       ///< 从机发出的应答数
+    uint32_t getDropouts() const { return dropouts; }     ///< 从机不应答的次数
+    uint32_t getCorrupted() const { return corrupted; }   ///< 被注入噪声的应答字节数
+    uint64_t getBusyUs() const { return busy_us; }        ///< 总线累计占用时间（微秒）
+    uint32_t getContention() const { return contention; } ///< 网关与从机同时驱动总线（或静默不足）的次数
+    uint32_t getTruncated() const { return truncated; }   ///< DE提前释放、网关帧尾被截断的次数
+
+private:
+    struct Pending {
+        uint64_t due;     ///< 从机开始应答的最早时间
+        uint8_t addr;
+        uint8_t cmd;
+        uint64_t cmd_done;
+        bool collided;    ///< 已确定与网关写入重叠
+    };
+
+    SLAVEBUS_CONFIG config;
+    uint32_t byte_us;             ///< 每字节线路时间
+    uint64_t bus_free;            ///< 已计入占用时间的最晚时刻
+    uint64_t gw_end;              ///< 网关最近一个字节发送完成时间
+    uint64_t slave_end;           ///< 从机最近一个应答字节发送完成时间
+    uint64_t de_end;              ///< 网关DE预定释放时间
+    bool gw_collided;             ///< 网关最近一次写入已计为冲突
+    std::string rx_frame;         ///< 从机侧正在接收的命令帧
+    std::deque<Pending> pending;  ///< 等待应答的命令，按应答时间排序
+    std::deque<std::pair<uint64_t, uint8_t>> to_gateway; ///< 应答字节及其到达网关的时间，按时间排序
+    std::deque<SLAVEBUS_TXN> done;
+    uint8_t state[SLAVEBUS_MAX_SLAVES + 1]; ///< 各从机的电机状态（SERIAL_STA）
+    uint32_t rng;
+    uint32_t commands;
+    uint32_t bad_frames;
+    uint32_t replies;
+    uint32_t dropouts;
+    uint32_t corrupted;
+    uint64_t busy_us;
+    uint32_t contention;
+    uint32_t truncated;
+
+    uint32_t random();
+    void onFrame(const uint8_t *frame, uint64_t at);
+    void advance(uint64_t now);
+    void occupy(uint64_t start, uint64_t end);
+    void corruptReplies(uint64_t from);
+    uint64_t markCollided(uint64_t end, uint64_t clash);
+};
+
+#endif // __linux__
+
+#endif // SLAVEBUS_HPP
@@ -0,0 +1,173 @@
+#include "telemetry.hpp"
+
+TelemetryStore *TelemetryStore::instance = nullptr;
+
+/**
+ * @brief TelemetryStore构造函数实现
+ */
+TelemetryStore::TelemetryStore()
+{
+    memset(series, 0, sizeof(series));
+    samples = 0;
+    instance = this;
+}
+
+TelemetryStore::~TelemetryStore()
+{
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+/**
+ * @brief 查找从机序列
+ * @param create 未找到时分配新序列（表满时替换最久未更新的）
+ */
+TelemetryStore::Series *TelemetryStore::lookup(uint8_t addr, bool create)
+{
+    Series *victim = nullptr;
+    for (uint8_t i = 0; i < TELEMETRY_SLAVES; i++) {
+        if (series[i].used && series[i].addr == addr) {
+            return &series[i];
+        }
+    }
+    if (!create) return nullptr;
+    for (uint8_t i = 0; i < TELEMETRY_SLAVES; i++) {
+        if (!series[i].used) {
+            victim = &series[i];
+            break;
+        }
+        if (victim == nullptr || (int32_t)(series[i].last_update - victim->last_update) < 0) {
+            victim = &series[i];
+        }
+    }
+    memset(victim, 0, sizeof(Series));
+    victim->used = true;
+    victim->addr = addr;
+    return victim;
+}
+
+/**
+ * @brief 记录样本实现
+ * @details 样本写入全分辨率环，同时并入当前桶；跨过桶边界时当前桶进入降采样环
+ */
+void TelemetryStore::record(uint8_t addr, uint8_t value, uint32_t now)
+{
+    Series *s = lookup(addr, true);
+    s->last_update = now;
+    samples++;
+
+    s->fine_time[s->fine_head] = now;
+    s->fine_value[s->fine_head] = value;
+    s->fine_head = (s->fine_head + 1) % TELEMETRY_FINE;
+    if (s->fine_count < TELEMETRY_FINE) s->fine_count++;
+
+    TLM_BUCKET &cur = s->current;
+    if (cur.count != 0 && (now - cur.start) >= TELEMETRY_BUCKET_MS) {
+        s->coarse[s->coarse_head] = cur;
+        s->coarse_head = (s->coarse_head + 1) % TELEMETRY_COARSE;
+        if (s->coarse_count < TELEMETRY_COARSE) s->coarse_count++;
+        cur.count = 0;
+    }
+    if (cur.count == 0) {
+        cur.start = now - (now % TELEMETRY_BUCKET_MS);
+        cur.min = value;
+        cur.max = value;
+    }
+    if (value < cur.min) cur.min = value;
+    if (value > cur.max) cur.max = value;
+    cur.last = value;
+    if (cur.count != 0xFF) cur.count++;
+}
+
+/**
+ * @brief 换算为距现在的时长（TELEMETRY_AGE_UNIT单位，饱和于0xFFFF）
+ */
+uint16_t TelemetryStore::ageUnits(uint32_t now, uint32_t t)
+{
+    uint32_t age = (now - t) / TELEMETRY_AGE_UNIT;
+    return age > 0xFFFF ? 0xFFFF : (uint16_t)age;
+}
+
+/**
+ * @brief 按时间范围查询实现
+ * @details 早于最旧原始样本的时间段由桶补齐（桶按起始时间判断），两者均按时间从旧到新输出；
+ *          缓冲区不足时优先保留较新的原始样本
+ */
+size_t TelemetryStore::query(uint8_t addr, uint32_t since, uint32_t until, uint32_t now, uint8_t *out, size_t len)
+{
+    Series *s = lookup(addr, false);
+    if (s == nullptr || len < 3) return 0;
+
+    // 原始样本：从新到旧找出范围内的样本
+    uint8_t fine_idx[TELEMETRY_FINE];
+    uint8_t nfine = 0;
+    uint32_t fine_oldest = s->fine_time[(s->fine_head + TELEMETRY_FINE - s->fine_count) % TELEMETRY_FINE];
+    for (uint8_t i = 0; i < s->fine_count; i++) {
+        uint8_t idx = (s->fine_head + TELEMETRY_FINE - 1 - i) % TELEMETRY_FINE;
+        uint32_t age = now - s->fine_time[idx];
+        if (age > since) break;
+        if (age >= until) fine_idx[nfine++] = idx;
+    }
+    bool fine_complete = s->fine_count < TELEMETRY_FINE;//环未写满时原始样本覆盖全部历史
+
+    // 桶：当前桶和已关闭的桶，只取早于最旧原始样本的部分
+    TLM_BUCKET buckets[TELEMETRY_COARSE + 1];
+    uint8_t nbucket = 0;
+    if (!fine_complete) {
+        for (uint8_t i = 0; i <= s->coarse_count; i++) {
+            const TLM_BUCKET *b;
+            if (i == s->coarse_count) {
+                b = &s->current;
+            } else {
+                b = &s->coarse[(s->coarse_head + TELEMETRY_COARSE - s->coarse_count + i) % TELEMETRY_COARSE];
+            }
+            if (b->count == 0 || (int32_t)(b->start - fine_oldest) >= 0) continue;
+            uint32_t age = now - b->start;
+            if (age >= until && (age < TELEMETRY_BUCKET_MS || age - TELEMETRY_BUCKET_MS < since)) {
+                buckets[nbucket++] = *b;//桶与查询范围有重叠
+            }
+        }
+    }
+
+    // 按缓冲区大小截断：先保证原始样本，再从新到旧放桶
+    size_t room = len - 3;
+    if ((size_t)nfine * 3 > room) nfine = room / 3;
+    room -= (size_t)nfine * 3;
+    uint8_t skip = 0;
+    if ((size_t)nbucket * 5 > room) {
+        skip = nbucket - room / 5;
+    }
+
+    size_t n = 0;
+    out[n++] = addr;
+    out[n++] = nbucket - skip;
+    out[n++] = nfine;
+    for (uint8_t i = skip; i < nbucket; i++) {
+        uint16_t age = ageUnits(now, buckets[i].start);
+        out[n++] = age & 0xFF;
+        out[n++] = age >> 8;
+        out[n++] = buckets[i].min;
+        out[n++] = buckets[i].max;
+        out[n++] = buckets[i].last;
+    }
+    for (int8_t i = nfine - 1; i >= 0; i--) {
+        uint16_t age = ageUnits(now, s->fine_time[fine_idx[i]]);
+        out[n++] = age & 0xFF;
+        out[n++] = age >> 8;
+        out[n++] = s->fine_value[fine_idx[i]];
+    }
+    return n;
+}
+
+/**
+ * @brief 已保存历史的从机数实现
+ */
+uint8_t TelemetryStore::getSlaveCount() const
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < TELEMETRY_SLAVES; i++) {
+        if (series[i].used) n++;
+    }
+    return n;
+}
@@ -0,0 +1,103 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : telemetry.hpp
+ * @brief          : Header for telemetry.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <Arduino.h>
+
+#define TELEMETRY_SLAVES 8          ///< 同时保存历史的从机数
+#define TELEMETRY_FINE 32           ///< 每个从机保留的全分辨率样本数
+#define TELEMETRY_COARSE 24         ///< 每个从机保留的降采样桶数
+#define TELEMETRY_BUCKET_MS 10000   ///< 降采样桶宽度（毫秒）
+#define TELEMETRY_AGE_UNIT 100      ///< 查询应答中时间戳单位（毫秒，距现在的时长）
+#define TELEMETRY_QUERY_TAG "TLMQ"  ///< 查询："TLMQ" addr 起始时长(4) 结束时长(4)，小端，毫秒，距现在
+#define TELEMETRY_REPLY_TAG "TLMR"  ///< 应答："TLMR" addr 桶数 样本数 桶[...] 样本[...]
+#define TELEMETRY_MAX_REPLY 192     ///< 应答最大长度（字节）
+
+/**
+ * @brief 降采样桶
+ */
+typedef struct {
+    uint32_t start; ///< 桶起始时间（毫秒）
+    uint8_t min;    ///< 桶内最小值
+    uint8_t max;    ///< 桶内最大值
+    uint8_t last;   ///< 桶内最后一个值
+    uint8_t count;  ///< 桶内样本数（饱和于255），0表示空桶
+} TLM_BUCKET;
+
+/**
+ * @brief 网关侧从机状态时间序列存储
+ * @details 每个从机固定内存：最近TELEMETRY_FINE个样本保留全分辨率，
+ *          同时按TELEMETRY_BUCKET_MS聚合为min/max/last桶，保留TELEMETRY_COARSE个桶。
+ *          查询时较新的时间段返回原始样本，更早的时间段返回桶，应答为紧凑二进制：
+ *          桶为 时长(2) min max last，样本为 时长(2) 值，时长单位TELEMETRY_AGE_UNIT毫秒，小端。
+ *          从机表满时替换最久未更新的从机。
+ */
+class TelemetryStore {
+public:
+    TelemetryStore();
+    ~TelemetryStore();
+
+    /**
+     * @brief 记录一个样本
+     * @param addr 从机地址
+     * @param value 状态值
+     * @param now 当前时间（毫秒）
+     */
+    void record(uint8_t addr, uint8_t value, uint32_t now);
+
+    /**
+     * @brief 按时间范围查询
+     * @param addr 从机地址
+     * @param since 起始时长（毫秒，距现在，较大）
+     * @param until 结束时长（毫秒，距现在，较小）
+     * @param now 当前时间（毫秒）
+     * @param out 输出缓冲区（不含消息标签）
+     * @param len 缓冲区长度
+     * @return 写入字节数，未知从机返回0
+     */
+    size_t query(uint8_t addr, uint32_t since, uint32_t until, uint32_t now, uint8_t *out, size_t len);
+
+    uint8_t getSlaveCount() const; ///< 已保存历史的从机数
+    uint32_t getSamples() const { return samples; } ///< 累计记录样本数
+
+    static TelemetryStore *getInstance() { return instance; }
+
+private:
+    struct Series {
+        uint8_t addr;
+        bool used;
+        uint8_t fine_head;   ///< 下一个写入位置
+        uint8_t fine_count;
+        uint8_t coarse_head;
+        uint8_t coarse_count;
+        uint32_t last_update;
+        uint32_t fine_time[TELEMETRY_FINE];
+        uint8_t fine_value[TELEMETRY_FINE];
+        TLM_BUCKET current;  ///< 正在聚合的桶
+        TLM_BUCKET coarse[TELEMETRY_COARSE];
+    };
+
+    Series series[TELEMETRY_SLAVES];
+    uint32_t samples;
+
+    static TelemetryStore *instance;
+
+    Series *lookup(uint8_t addr, bool create);
+    static uint16_t ageUnits(uint32_t now, uint32_t t);
+};
+
+#endif // TELEMETRY_HPP
@@ -1,5 +1,45 @@
 #include "time.hpp"
 
+static ArduinoClock arduinoClock;  // 默认时钟源
+ClockSource *Clock::source = &arduinoClock;
+
+/**
+ * @brief ArduinoClock构造函数实现
+ */
+ArduinoClock::ArduinoClock() {
+  last = 0;
+  high = 0;
+}
+
+/**
+ * @brief 读取时间实现：检测micros()回绕并扩展为64位
+ */
+uint64_t ArduinoClock::now() {
+  uint32_t us = micros();
+  if (us < last) {
+    high++;
+  }
+  last = us;
+  return ((uint64_t)high << 32) | us;
+}
+
+/**
+ * @brief 短等待实现：delayMicroseconds不让出CPU，适合微秒到毫秒级的等待
+ */
+void ArduinoClock::waitUntil(uint64_t t) {
+  uint64_t n = now();
+  if (t > n) {
+    delayMicroseconds((unsigned int)(t - n));
+  }
+}
+
+/**
+ * @brief 替换时钟源实现
+ */
+void Clock::setSource(ClockSource *src) {
+  source = (src != nullptr) ? src : &arduinoClock;
+}
+
 /**
  * @brief Timer类默认构造函数实现
  * 初始化所有成员变量，将定时器设置为停止状态
@@ -30,7 +70,7 @@ void Timer::setDuration(unsigned long dur) {
   duration = dur;
   if (isRunning) {
     // 如果定时器正在运行，则重置开始时间
-    startTime = millis();
+    startTime = Clock::millis();
   }
 }
 
@@ -39,7 +79,7 @@ void Timer::setDuration(unsigned long dur) {
  * 记录当前时间作为开始时间，并将运行状态设置为true
  */
 void Timer::start() {
-  startTime = millis();
+  startTime = Clock::millis();
   isRunning = true;
 }
 
@@ -56,7 +96,7 @@ void Timer::stop() {
  * 重新记录当前时间作为开始时间，保持运行状态不变
  */
 void Timer::reset() {
-  startTime = millis();
+  startTime = Clock::millis();
 }
 
 /**
@@ -67,7 +107,7 @@ bool Timer::isTimeout() {
   if (!isRunning) {
     return false;
   }
-  return (millis() - startTime) >= duration;
+  return (Clock::millis() - startTime) >= duration;
 }
 
 /**
@@ -79,7 +119,7 @@ unsigned long Timer::getRemainingTime() {
   if (!isRunning) {
     return duration;
   }
-  unsigned long elapsed = millis() - startTime;
+  unsigned long elapsed = Clock::millis() - startTime;
   if (elapsed >= duration) {
     return 0;
   }
@@ -92,4 +132,115 @@ unsigned long Timer::getRemainingTime() {
  */
 bool Timer::isTimerRunning() {
   return isRunning;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief TimingWheel构造函数实现
+ */
+TimingWheel::TimingWheel() {
+  memset(slots, 0, sizeof(slots));
+  current = 0;
+  started = false;
+  count = 0;
+  fired = 0;
+}
+
+/**
+ * @brief 挂到到期刻度对应的槽（头插）
+ */
+void TimingWheel::link(WheelTimer *t) {
+  WheelTimer **head = &slots[t->expires & (TIMING_WHEEL_SLOTS - 1)];
+  t->prev = nullptr;
+  t->next = *head;
+  if (*head != nullptr) {
+    (*head)->prev = t;
+  }
+  *head = t;
+  t->armed = true;
+  count++;
+}
+
+/**
+ * @brief 从槽中摘除
+ */
+void TimingWheel::unlink(WheelTimer *t) {
+  if (t->prev != nullptr) {
+    t->prev->next = t->next;
+  } else {
+    slots[t->expires & (TIMING_WHEEL_SLOTS - 1)] = t->next;
+  }
+  if (t->next != nullptr) {
+    t->next->prev = t->prev;
+  }
+  t->next = nullptr;
+  t->prev = nullptr;
+  t->armed = false;
+  count--;
+}
+
+/**
+ * @brief 调度定时器实现
+ * @details 到期刻度至少为下一个刻度，保证不会在本次advance()中立即触发
+ */
+void TimingWheel::schedule(WheelTimer *t, uint32_t delay_us, WheelCallback cb, void *arg) {
+  start();
+  if (t->armed) {
+    unlink(t);
+  }
+  uint64_t ticks = (delay_us + TIMING_WHEEL_TICK_US - 1) / TIMING_WHEEL_TICK_US;
+  t->expires = current + (ticks == 0 ? 1 : ticks);
+  t->cb = cb;
+  t->arg = arg;
+  link(t);
+}
+
+void TimingWheel::cancel(WheelTimer *t) {
+  if (t->armed) {
+    unlink(t);
+  }
+}
+
+/**
+ * @brief 推进时间轮实现
+ * @details 先把到期的定时器摘到本地链表再逐个回调，回调中修改时间轮不会破坏遍历；
+ *          落后超过一圈时只需遍历一圈，所有槽都会被检查到
+ */
+uint16_t TimingWheel::advance() {
+  start();
+  uint64_t now = tick();
+  if (now <= current) {
+    return 0;
+  }
+  uint64_t from = current + 1;
+  if (now - current > TIMING_WHEEL_SLOTS) {
+    from = now - TIMING_WHEEL_SLOTS + 1;
+  }
+  current = now;
+
+  WheelTimer *expired = nullptr;
+  for (uint64_t tk = from; tk <= now; tk++) {
+    WheelTimer *t = slots[tk & (TIMING_WHEEL_SLOTS - 1)];
+    while (t != nullptr) {
+      WheelTimer *next = t->next;
+      if (t->expires <= now) {
+        unlink(t);
+        t->next = expired;
+        expired = t;
+      }
+      t = next;
+    }
+  }
+
+  uint16_t n = 0;
+  while (expired != nullptr) {
+    WheelTimer *t = expired;
+    expired = t->next;
+    t->next = nullptr;
+    n++;
+    fired++;
+    if (t->cb != nullptr) {
+      t->cb(t->arg);
+    }
+  }
+  return n;
+}
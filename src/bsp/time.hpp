@@ -18,9 +18,89 @@
 
 #include <Arduino.h>
 
+#define TIMING_WHEEL_SLOTS 256     ///< 时间轮槽数（2的幂）
+#define TIMING_WHEEL_TICK_US 1000  ///< 时间轮刻度（微秒）
+
+/**
+ * @class ClockSource
+ * @brief 单调64位微秒时钟源接口
+ *
+ * 目标板上使用ArduinoClock，主机上可注入VirtualClock，由测试/仿真控制时间推进。
+ */
+class ClockSource {
+public:
+  virtual ~ClockSource() {}
+
+  /**
+   * @brief 获取当前时间
+   * @return 单调递增的微秒数（64位，不回绕）
+   */
+  virtual uint64_t now() = 0;
+
+  /**
+   * @brief 等待到指定时间（只用于微秒级的短等待）
+   * @param t 目标时间（微秒），已过去则立即返回
+   */
+  virtual void waitUntil(uint64_t t) { while (now() < t) {} }
+};
+
+/**
+ * @class ArduinoClock
+ * @brief 基于micros()的时钟源
+ *
+ * 32位micros()约71分钟回绕一次，每次读取时检测回绕并累加高位，
+ * 只要两次读取间隔小于71分钟（主循环每轮都会读取）即可保持单调。
+ */
+class ArduinoClock : public ClockSource {
+private:
+  uint32_t last;  // 上次读取的micros()
+  uint32_t high;  // 回绕次数（高32位）
+
+public:
+  ArduinoClock();
+  uint64_t now() override;
+  void waitUntil(uint64_t t) override;
+};
+
+/**
+ * @class VirtualClock
+ * @brief 虚拟时钟源，时间只在调用advance()/set()时推进
+ */
+class VirtualClock : public ClockSource {
+private:
+  uint64_t t;
+
+public:
+  VirtualClock(uint64_t start = 0) : t(start) {}
+  uint64_t now() override { return t; }
+  void advance(uint64_t us) { t += us; }  // 推进时间（微秒）
+  void set(uint64_t us) { if (us > t) t = us; }  // 设置时间，不允许倒退
+  void waitUntil(uint64_t us) override { set(us); }  // 等待即推进到目标时间
+};
+
+/**
+ * @class Clock
+ * @brief 全局时钟入口，默认使用ArduinoClock，可替换为注入的时钟源
+ */
+class Clock {
+public:
+  static uint64_t micros64() { return source->now(); }  // 当前时间（微秒，64位）
+  static unsigned long millis() { return (unsigned long)(source->now() / 1000); }  // 当前时间（毫秒，回绕语义同Arduino millis()）
+  static void waitUntil(uint64_t t) { source->waitUntil(t); }  // 短等待到指定时间（微秒）
+
+  /**
+   * @brief 替换时钟源
+   * @param src 时钟源，nullptr恢复默认的ArduinoClock
+   */
+  static void setSource(ClockSource *src);
+
+private:
+  static ClockSource *source;
+};
+
 /**
  * @class Timer
- * @brief 非阻塞式定时器类，基于Arduino的millis()函数实现
+ * @brief 非阻塞式定时器类，基于Clock::millis()实现（默认即Arduino的millis()）
  * 
  * 该类提供了设置、启动、停止和检查定时器状态的功能，
  * 适用于需要定时执行任务但不希望阻塞主循环的场景。
@@ -89,4 +169,71 @@ public:
   bool isTimerRunning();
 };
 
-#endif // TIME_HPP
\ No newline at end of file
+typedef void (*WheelCallback)(void *arg);  ///< 时间轮定时器到期回调
+
+/**
+ * @struct WheelTimer
+ * @brief 时间轮定时器节点（由调用者分配，时间轮只做链接，无动态内存）
+ */
+struct WheelTimer {
+  WheelTimer *next;
+  WheelTimer *prev;
+  uint64_t expires;    // 到期刻度
+  WheelCallback cb;
+  void *arg;
+  bool armed;          // 是否在时间轮中
+
+  WheelTimer() : next(nullptr), prev(nullptr), expires(0), cb(nullptr), arg(nullptr), armed(false) {}
+};
+
+/**
+ * @class TimingWheel
+ * @brief 哈希时间轮
+ *
+ * 定时器按到期刻度对TIMING_WHEEL_SLOTS取模挂到槽的双向链表上，插入和取消都是O(1)；
+ * 超过一圈的定时器留在槽中，到期刻度未到时跳过。advance()每轮主循环调用一次，
+ * 只遍历自上次调用以来经过的槽（最多一圈）。回调中可以重新调度或取消任意定时器。
+ * 构造时不读取时钟：静态对象构造时Clock::source指向的ArduinoClock可能尚未构造，
+ * 测试也可能在构造之后才注入VirtualClock，起始刻度在首次schedule()/advance()时确定。
+ */
+class TimingWheel {
+private:
+  WheelTimer *slots[TIMING_WHEEL_SLOTS];
+  uint64_t current;    // 已处理到的刻度
+  bool started;        // current已按时钟源取值
+  size_t count;        // 挂在时间轮上的定时器数
+  uint32_t fired;      // 累计到期数
+
+  static uint64_t tick() { return Clock::micros64() / TIMING_WHEEL_TICK_US; }
+  void start() { if (!started) { current = tick(); started = true; } }  // 首次使用时才读取时钟
+  void link(WheelTimer *t);
+  void unlink(WheelTimer *t);
+
+public:
+  TimingWheel();
+
+  /**
+   * @brief 调度定时器，已在时间轮中的会先取消
+   * @param t 定时器节点
+   * @param delay_us 延时（微秒），按刻度向上取整
+   * @param cb 到期回调
+   * @param arg 回调参数
+   */
+  void schedule(WheelTimer *t, uint32_t delay_us, WheelCallback cb, void *arg);
+
+  /**
+   * @brief 取消定时器，未调度时为空操作
+   */
+  void cancel(WheelTimer *t);
+
+  /**
+   * @brief 推进时间轮并执行到期回调
+   * @return 本次到期的定时器数
+   */
+  uint16_t advance();
+
+  size_t pending() const { return count; }  // 挂在时间轮上的定时器数
+  uint32_t getFired() const { return fired; }  // 累计到期数
+};
+
+#endif // TIME_HPP
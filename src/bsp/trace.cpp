@@ -0,0 +1,173 @@
+#include "trace.hpp"
+
+TraceRecorder *TraceRecorder::instance = nullptr;
+
+/**
+ * @brief TraceRecorder构造函数实现，默认不记录
+ */
+TraceRecorder::TraceRecorder()
+    : ring(ringBuf, sizeof(uint8_t), TRACE_BUFFER_SIZE)
+{
+    running = false;
+    last_us = 0;
+    dropped = 0;
+    records = 0;
+#if defined(__linux__)
+    file = nullptr;
+#endif
+    instance = this;
+}
+
+/**
+ * @brief TraceRecorder析构函数实现
+ */
+TraceRecorder::~TraceRecorder()
+{
+#if defined(__linux__)
+    if (file != nullptr) {
+        flushFile();
+        fclose(file);
+    }
+#endif
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+/**
+ * @brief 开始记录实现，时间基准从当前时刻开始
+ */
+void TraceRecorder::start()
+{
+    last_us = (uint32_t)Clock::micros64();
+    running = true;
+}
+
+void TraceRecorder::stop()
+{
+    running = false;
+}
+
+/**
+ * @brief 无符号LEB128编码
+ */
+size_t TraceRecorder::putVarint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * @brief 写入环形缓冲区（调用者已确认空间足够）
+ */
+void TraceRecorder::write(const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        void *dest;
+        size_t room = ring.writableSpan(&dest);
+        size_t n = room < len ? room : len;
+        memcpy(dest, data, n);
+        ring.commit(n);
+        data += n;
+        len -= n;
+    }
+}
+
+/**
+ * @brief 追加一条记录实现
+ */
+void TraceRecorder::append(uint8_t type, const uint8_t *prefix, size_t prefix_len, const uint8_t *data, size_t len)
+{
+    uint8_t hdr[11];
+    uint32_t now = (uint32_t)Clock::micros64();
+    size_t hlen = 0;
+    hdr[hlen++] = type;
+    hlen += putVarint(hdr + hlen, now - last_us);
+    hlen += putVarint(hdr + hlen, prefix_len + len);
+
+    if (hlen + prefix_len + len > TRACE_BUFFER_SIZE - ring.count()) {
+        dropped++;
+        return;
+    }
+    last_us = now;
+    write(hdr, hlen);
+    if (prefix_len) write(prefix, prefix_len);
+    if (len) write(data, len);
+    records++;
+
+#if defined(__linux__)
+    if (file != nullptr && ring.count() > TRACE_BUFFER_SIZE / 2) {
+        flushFile();
+    }
+#endif
+}
+
+void TraceRecorder::recordRx(const uint8_t *data, size_t len)
+{
+    if (instance != nullptr && instance->running && len > 0) {
+        instance->append(TRACE_RX, nullptr, 0, data, len);
+    }
+}
+
+void TraceRecorder::recordTx(const uint8_t *data, size_t len)
+{
+    if (instance != nullptr && instance->running && len > 0) {
+        instance->append(TRACE_TX, nullptr, 0, data, len);
+    }
+}
+
+void TraceRecorder::recordMesh(uint32_t from, const String &msg)
+{
+    if (instance != nullptr && instance->running) {
+        uint8_t id[4] = { (uint8_t)(from >> 24), (uint8_t)(from >> 16), (uint8_t)(from >> 8), (uint8_t)from };
+        instance->append(TRACE_MESH, id, sizeof(id), (const uint8_t *)msg.c_str(), msg.length());
+    }
+}
+
+/**
+ * @brief 从环形缓冲区取出已记录的数据实现
+ */
+size_t TraceRecorder::read(uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len && ring.pop(&buf[n])) {
+        n++;
+    }
+    return n;
+}
+
+#if defined(__linux__)
+
+/**
+ * @brief 记录到文件实现
+ */
+bool TraceRecorder::startFile(const char *path)
+{
+    file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    fwrite(TRACE_MAGIC, 1, 4, file);
+    fputc(TRACE_VERSION, file);
+    ring.reset();
+    start();
+    return true;
+}
+
+/**
+ * @brief 把缓冲区内容写入文件实现
+ */
+void TraceRecorder::flushFile()
+{
+    uint8_t chunk[256];
+    size_t n;
+    while (file != nullptr && (n = read(chunk, sizeof(chunk))) > 0) {
+        fwrite(chunk, 1, n, file);
+    }
+    if (file != nullptr) fflush(file);
+}
+
+#endif // __linux__
@@ -0,0 +1,114 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : trace.hpp
+ * @brief          : Header for trace.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <Arduino.h>
+#include "queue.hpp"
+#include "time.hpp"
+
+#if defined(__linux__)
+#include <stdio.h>
+#endif
+
+#define TRACE_BUFFER_SIZE 2048    ///< RAM环形缓冲区大小（字节）
+#define TRACE_FLUSH_CHUNK 192     ///< 每次通过mesh发出的最大字节数
+#define TRACE_MAGIC "MTRC"        ///< 文件头魔数
+#define TRACE_VERSION 1           ///< 文件格式版本
+
+// 记录类型
+#define TRACE_RX 1      ///< 串口收到的字节
+#define TRACE_TX 2      ///< 串口发出的帧
+#define TRACE_MESH 3    ///< mesh收到的消息，负载前4字节为来源节点ID（大端）
+
+/**
+ * @brief 串口/mesh流量记录器
+ * @details 记录格式：类型(1) 距上一条记录的微秒数(varint) 负载长度(varint) 负载(n)。
+ *          记录先写入RAM环形缓冲区，缓冲区放不下整条记录时丢弃该记录并计数，
+ *          不会写入半条记录；目标板上由APP分块经mesh发给采集节点，
+ *          Linux上可直接写入文件（文件以"MTRC"+版本号开头）。
+ *          经mesh开始/停止记录（TRACE_START/TRACE_STOP）只接受管理节点：默认固件没有管理节点，
+ *          需在windosw_mesh.ino的ADMIN_NODES中填写采集节点ID，或编译时加-DMESH_ADMIN_NODE=<节点ID>
+ */
+class TraceRecorder {
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+
+    void start();                               ///< 开始记录
+    void stop();                                ///< 停止记录
+    bool isRunning() const { return running; }  ///< 是否正在记录
+
+    /**
+     * @brief 记录串口收到的字节（未记录时为空操作）
+     */
+    static void recordRx(const uint8_t *data, size_t len);
+
+    /**
+     * @brief 记录串口发出的帧（未记录时为空操作）
+     */
+    static void recordTx(const uint8_t *data, size_t len);
+
+    /**
+     * @brief 记录mesh收到的消息（未记录时为空操作）
+     */
+    static void recordMesh(uint32_t from, const String &msg);
+
+    /**
+     * @brief 从环形缓冲区取出已记录的数据
+     * @return 实际取出的字节数
+     */
+    size_t read(uint8_t *buf, size_t len);
+
+    size_t count() const { return ring.count(); } ///< 缓冲区中待取出的字节数
+    uint32_t getDropped() const { return dropped; } ///< 因缓冲区满丢弃的记录数
+    uint32_t getRecords() const { return records; } ///< 已记录条数
+
+    static TraceRecorder *getInstance() { return instance; }
+
+#if defined(__linux__)
+    /**
+     * @brief 记录到文件并开始记录
+     * @param path 文件路径
+     * @return 打开失败返回false
+     */
+    bool startFile(const char *path);
+
+    /**
+     * @brief 把缓冲区内容写入文件，缓冲区超过一半时记录函数会自动调用
+     */
+    void flushFile();
+#endif
+
+private:
+    uint8_t ringBuf[TRACE_BUFFER_SIZE];
+    SimpleQueue ring;
+    bool running;
+    uint32_t last_us;
+    uint32_t dropped;
+    uint32_t records;
+#if defined(__linux__)
+    FILE *file;
+#endif
+
+    static TraceRecorder *instance;
+
+    void append(uint8_t type, const uint8_t *prefix, size_t prefix_len, const uint8_t *data, size_t len);
+    void write(const uint8_t *data, size_t len);
+    static size_t putVarint(uint8_t *p, uint32_t v);
+};
+
+#endif // TRACE_HPP
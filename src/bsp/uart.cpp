@@ -12,7 +12,7 @@ UART::UART()
 /**
  * @brief 初始化串口实现
  */
-bool UART::begin(uint32_t baudRate) {
+bool UART::begin(uint32_t /*baudRate*/) {
     Serial.begin(_baudRate);
     delay(100);
     return true;
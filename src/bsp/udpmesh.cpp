@@ -0,0 +1,328 @@
+#include "udpmesh.hpp"
+
+#if defined(MESH_TRANSPORT_UDP)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+
+// 数据包格式：'M' 'U' 类型(1) 源ID(4) 目的ID(4) 源单播端口(2) 负载(n)
+#define UDP_MESH_HDR_LEN 13
+#define UDP_MESH_HELLO 1
+#define UDP_MESH_BCAST 2
+#define UDP_MESH_SINGLE 3
+#define UDP_MESH_BYE 4
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/**
+ * @brief UdpMeshTransport构造函数实现
+ * @param nodeId 指定节点ID，0表示在init()中自动生成
+ */
+UdpMeshTransport::UdpMeshTransport(uint32_t nodeId)
+    : node_id(nodeId), mcast_fd(-1), ucast_fd(-1), ucast_port(0), last_hello(0), rx_packets(0), tx_packets(0), channel(0)
+{
+    memset(neighbours, 0, sizeof(neighbours));
+}
+
+/**
+ * @brief UdpMeshTransport析构函数实现：通知邻居离开并关闭套接字
+ */
+UdpMeshTransport::~UdpMeshTransport()
+{
+    stop();
+}
+
+/**
+ * @brief 停止实现：通知邻居离开、关闭套接字并清空邻居表
+ */
+void UdpMeshTransport::stop()
+{
+    if (ucast_fd >= 0) {
+        sendPacket(UDP_MESH_BYE, 0, nullptr, 0);
+    }
+    closeSockets();
+    memset(neighbours, 0, sizeof(neighbours));
+}
+
+/**
+ * @brief 上级节点BSSID实现：以第一个邻居的节点ID生成本地管理MAC地址
+ */
+bool UdpMeshTransport::getParentBssid(uint8_t *bssid)
+{
+    for (uint16_t i = 0; i < UDP_MESH_MAX_NEIGHBOURS; i++) {
+        if (neighbours[i].node_id != 0) {
+            bssid[0] = 0x02;
+            bssid[1] = 0x00;
+            put32(bssid + 2, neighbours[i].node_id);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 初始化实现
+ * @details 单播套接字绑定127.0.0.1随机端口；组播套接字绑定MESH_PORT并在回环接口上加入组播组。
+ *          任何一步失败都关闭已创建的套接字并返回false，errno保留失败原因
+ */
+bool UdpMeshTransport::init()
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    struct in_addr loopback;
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+
+    ucast_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (ucast_fd < 0) return false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr = loopback;
+    addr.sin_port = 0;
+    uint8_t loop = 1;
+    if (bind(ucast_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || getsockname(ucast_fd, (struct sockaddr *)&addr, &addr_len) < 0
+        || setsockopt(ucast_fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) < 0
+        || setsockopt(ucast_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0
+        || fcntl(ucast_fd, F_SETFL, O_NONBLOCK) < 0) {
+        closeSockets();
+        return false;
+    }
+    ucast_port = addr.sin_port;
+
+    mcast_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (mcast_fd < 0) {
+        closeSockets();
+        return false;
+    }
+    int reuse = 1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(MESH_PORT);
+    struct ip_mreq mreq;
+    inet_pton(AF_INET, UDP_MESH_GROUP, &mreq.imr_multiaddr);
+    mreq.imr_interface = loopback;
+    if (setsockopt(mcast_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0
+        || setsockopt(mcast_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0
+        || bind(mcast_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || setsockopt(mcast_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0
+        || fcntl(mcast_fd, F_SETFL, O_NONBLOCK) < 0) {
+        closeSockets();
+        return false;
+    }
+
+    if (node_id == 0) {
+        node_id = ((uint32_t)getpid() << 16) ^ ntohs(ucast_port);
+        if (node_id == 0) node_id = 1;
+    }
+
+    last_hello = millis();
+    sendPacket(UDP_MESH_HELLO, 0, nullptr, 0);
+    return true;
+}
+
+/**
+ * @brief 关闭套接字（不通知邻居），保留errno
+ */
+void UdpMeshTransport::closeSockets()
+{
+    int err = errno;
+    if (ucast_fd >= 0) close(ucast_fd);
+    if (mcast_fd >= 0) close(mcast_fd);
+    ucast_fd = -1;
+    mcast_fd = -1;
+    errno = err;
+}
+
+/**
+ * @brief 处理收发实现：收包、周期性发现广播、邻居超时检查
+ */
+void UdpMeshTransport::update()
+{
+    receive(ucast_fd);
+    receive(mcast_fd);
+
+    uint32_t now = millis();
+    if (now - last_hello >= UDP_MESH_HELLO_INTERVAL) {
+        last_hello = now;
+        sendPacket(UDP_MESH_HELLO, 0, nullptr, 0);
+    }
+    expireNeighbours(now);
+}
+
+/**
+ * @brief 读取套接字上所有就绪的数据包
+ */
+void UdpMeshTransport::receive(int fd)
+{
+    uint8_t buf[UDP_MESH_HDR_LEN + UDP_MESH_MAX_PAYLOAD];
+    while (fd >= 0) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0) break;
+        handlePacket(buf, (size_t)n);
+    }
+}
+
+/**
+ * @brief 解析一个数据包实现
+ * @details 任何来自未知节点的数据包都会建立邻居并触发连接回调，
+ *          收到组播发现时用单播回一个发现包，使新节点无需等待下一个周期
+ */
+void UdpMeshTransport::handlePacket(const uint8_t *buf, size_t len)
+{
+    if (len < UDP_MESH_HDR_LEN || buf[0] != 'M' || buf[1] != 'U') return;
+    uint8_t type = buf[2];
+    uint32_t src = get32(buf + 3);
+    uint32_t dst = get32(buf + 7);
+    uint16_t port;
+    memcpy(&port, buf + 11, sizeof(port));
+    if (src == node_id || src == 0) return;//本机组播回环
+    rx_packets++;
+
+    Neighbour *nb = findNeighbour(src);
+    if (type == UDP_MESH_BYE) {
+        if (nb != nullptr) {
+            nb->node_id = 0;
+            if (droppedCb) droppedCb(src);
+            if (changedCb) changedCb();
+        }
+        return;
+    }
+
+    if (nb == nullptr) {
+        nb = findNeighbour(0);
+        if (nb == nullptr) return;//邻居表已满
+        nb->node_id = src;
+        nb->port = port;
+        nb->last_seen = millis();
+        if (type == UDP_MESH_HELLO) {
+            sendPacket(UDP_MESH_HELLO, src, nullptr, port);
+        }
+        if (newConnectionCb) newConnectionCb(src);
+        if (changedCb) changedCb();
+    }
+    nb->last_seen = millis();
+    nb->port = port;
+
+    if (type == UDP_MESH_BCAST || (type == UDP_MESH_SINGLE && dst == node_id)) {
+        String msg;
+        msg.concat((const char *)buf + UDP_MESH_HDR_LEN, len - UDP_MESH_HDR_LEN);
+        if (receivedCb) receivedCb(src, msg);
+    }
+}
+
+/**
+ * @brief 查找邻居表项，id为0时查找空闲表项
+ */
+UdpMeshTransport::Neighbour *UdpMeshTransport::findNeighbour(uint32_t id)
+{
+    for (uint16_t i = 0; i < UDP_MESH_MAX_NEIGHBOURS; i++) {
+        if (neighbours[i].node_id == id) {
+            return &neighbours[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 邻居超时检查实现
+ */
+void UdpMeshTransport::expireNeighbours(uint32_t now)
+{
+    for (uint16_t i = 0; i < UDP_MESH_MAX_NEIGHBOURS; i++) {
+        if (neighbours[i].node_id != 0 && (now - neighbours[i].last_seen) > UDP_MESH_NODE_TIMEOUT) {
+            uint32_t id = neighbours[i].node_id;
+            neighbours[i].node_id = 0;
+            if (droppedCb) droppedCb(id);
+            if (changedCb) changedCb();
+        }
+    }
+}
+
+/**
+ * @brief 发送数据包实现
+ * @param port 目的单播端口（网络字节序），0表示发往组播组
+ */
+bool UdpMeshTransport::sendPacket(uint8_t type, uint32_t dest, const String *msg, uint16_t port)
+{
+    uint8_t buf[UDP_MESH_HDR_LEN + UDP_MESH_MAX_PAYLOAD];
+    size_t len = msg ? msg->length() : 0;
+    if (ucast_fd < 0 || len > UDP_MESH_MAX_PAYLOAD) return false;
+
+    buf[0] = 'M';
+    buf[1] = 'U';
+    buf[2] = type;
+    put32(buf + 3, node_id);
+    put32(buf + 7, dest);
+    memcpy(buf + 11, &ucast_port, sizeof(ucast_port));
+    if (len) memcpy(buf + UDP_MESH_HDR_LEN, msg->c_str(), len);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (port == 0) {
+        inet_pton(AF_INET, UDP_MESH_GROUP, &addr.sin_addr);
+        addr.sin_port = htons(MESH_PORT);
+    } else {
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = port;
+    }
+    ssize_t n = sendto(ucast_fd, buf, UDP_MESH_HDR_LEN + len, 0, (struct sockaddr *)&addr, sizeof(addr));
+    if (n < 0) return false;
+    tx_packets++;
+    return true;
+}
+
+bool UdpMeshTransport::sendBroadcast(String &msg)
+{
+    return sendPacket(UDP_MESH_BCAST, 0, &msg, 0);
+}
+
+/**
+ * @brief 单播实现，目标不在邻居表中时返回false（与painlessMesh无路由时一致）
+ */
+bool UdpMeshTransport::sendSingle(uint32_t dest, String &msg)
+{
+    Neighbour *nb = findNeighbour(dest);
+    if (dest == 0 || nb == nullptr) return false;
+    return sendPacket(UDP_MESH_SINGLE, dest, &msg, nb->port);
+}
+
+uint32_t UdpMeshTransport::getNodeId()
+{
+    return node_id;
+}
+
+std::list<uint32_t> UdpMeshTransport::getNodeList()
+{
+    std::list<uint32_t> list;
+    for (uint16_t i = 0; i < UDP_MESH_MAX_NEIGHBOURS; i++) {
+        if (neighbours[i].node_id != 0) list.push_back(neighbours[i].node_id);
+    }
+    return list;
+}
+
+/**
+ * @brief 全网同步时间实现：同一台机器上的进程共用CLOCK_MONOTONIC，天然同步
+ */
+uint32_t UdpMeshTransport::getNodeTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+#endif // MESH_TRANSPORT_UDP
@@ -0,0 +1,86 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : udpmesh.hpp
+ * @brief          : Header for udpmesh.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef UDPMESH_HPP
+#define UDPMESH_HPP
+
+#include "meshtransport.hpp"
+
+#if defined(MESH_TRANSPORT_UDP)
+
+#define UDP_MESH_GROUP "239.255.55.55"   ///< 组播地址（仅在本机回环上使用）
+#define UDP_MESH_HELLO_INTERVAL 1000     ///< 邻居发现广播间隔（毫秒）
+#define UDP_MESH_NODE_TIMEOUT 3500       ///< 超过该时间未收到邻居消息视为断开（毫秒）
+#define UDP_MESH_MAX_NEIGHBOURS 128      ///< 邻居表容量
+#define UDP_MESH_MAX_PAYLOAD 1400        ///< 单条消息最大长度
+#define UDP_MESH_CHANNEL 1               ///< 模拟的默认信道
+
+/**
+ * @brief 基于UDP组播/单播的Mesh传输层（Linux，本机回环）
+ * @details 每个进程一个节点：组播用于广播和邻居发现，单播用于sendSingle。
+ *          节点ID默认由进程号和单播端口生成；所有节点互为一跳邻居。
+ *          连接/断开/拓扑变化回调的触发时机与painlessMesh一致，均在update()中触发。
+ */
+class UdpMeshTransport : public MeshTransport {
+public:
+    /**
+     * @param nodeId 指定节点ID，0表示自动生成
+     */
+    UdpMeshTransport(uint32_t nodeId = 0);
+    ~UdpMeshTransport();
+
+    bool init() override;
+    void update() override;
+    bool sendBroadcast(String &msg) override;
+    bool sendSingle(uint32_t dest, String &msg) override;
+    uint32_t getNodeId() override;
+    std::list<uint32_t> getNodeList() override;
+    uint32_t getNodeTime() override;
+    void setChannel(uint8_t channel) override { this->channel = channel; }
+    uint8_t getChannel() override { return channel ? channel : UDP_MESH_CHANNEL; }
+    bool getParentBssid(uint8_t *bssid) override;
+    void stop() override;
+
+    uint32_t getRxPackets() const { return rx_packets; } ///< 收到的数据包数
+    uint32_t getTxPackets() const { return tx_packets; } ///< 发出的数据包数
+
+private:
+    struct Neighbour {
+        uint32_t node_id;   ///< 邻居节点ID，0表示空闲
+        uint16_t port;      ///< 邻居单播端口（网络字节序）
+        uint32_t last_seen; ///< 最近一次收到消息的时间
+    };
+
+    uint32_t node_id;
+    int mcast_fd;   ///< 组播接收套接字
+    int ucast_fd;   ///< 单播收发套接字（所有发送都从这里发出）
+    uint16_t ucast_port;
+    uint32_t last_hello;
+    uint32_t rx_packets;
+    uint32_t tx_packets;
+    uint8_t channel;  ///< 模拟信道，只用于启动缓存流程
+    Neighbour neighbours[UDP_MESH_MAX_NEIGHBOURS];
+
+    void closeSockets();
+    bool sendPacket(uint8_t type, uint32_t dest, const String *msg, uint16_t port);
+    void receive(int fd);
+    void handlePacket(const uint8_t *buf, size_t len);
+    Neighbour *findNeighbour(uint32_t id);
+    void expireNeighbours(uint32_t now);
+};
+
+#endif // MESH_TRANSPORT_UDP
+
+#endif // UDPMESH_HPP
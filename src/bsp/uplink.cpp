@@ -0,0 +1,163 @@
+#include "uplink.hpp"
+
+StatusUplink *StatusUplink::instance = nullptr;
+
+/**
+ * @brief StatusUplink构造函数实现
+ */
+StatusUplink::StatusUplink()
+{
+    memset(slots, 0, sizeof(slots));
+    memset(subscribers, 0, sizeof(subscribers));
+    dirty = 0;
+    keyframe_due = false;
+    seq = 0;
+    first_dirty = 0;
+    last_keyframe = 0;
+    updates = 0;
+    suppressed = 0;
+    sent_bytes = 0;
+    instance = this;
+}
+
+StatusUplink::~StatusUplink()
+{
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+/**
+ * @brief 写入从机状态实现
+ * @details 新从机占用空闲槽位并触发全量快照；槽位已满的从机不上行
+ */
+void StatusUplink::update(uint8_t addr, uint8_t sta, uint32_t now)
+{
+    updates++;
+    int8_t free_slot = -1;
+    for (uint8_t i = 0; i < UPLINK_SLAVES; i++) {
+        if (slots[i].used && slots[i].addr == addr) {
+            slots[i].value = sta;
+            if (sta == slots[i].published) {
+                dirty &= ~(1U << i);//变回已发布的值，无需发送
+                suppressed++;
+                return;
+            }
+            if (dirty == 0) first_dirty = now;
+            dirty |= 1U << i;
+            return;
+        }
+        if (!slots[i].used && free_slot < 0) free_slot = i;
+    }
+    if (free_slot < 0) {
+        suppressed++;
+        return;
+    }
+    slots[free_slot].used = true;
+    slots[free_slot].addr = addr;
+    slots[free_slot].value = sta;
+    slots[free_slot].published = sta;
+    keyframe_due = true;//槽位布局变化，订阅者需要新快照
+}
+
+/**
+ * @brief 生成待发送消息实现
+ * @details 没有订阅者时不发送，但快照照常更新
+ */
+bool StatusUplink::poll(uint32_t now, String &msg)
+{
+    bool have_sub = false;
+    for (uint8_t i = 0; i < UPLINK_SUBSCRIBERS; i++) {
+        have_sub |= subscribers[i] != 0;
+    }
+    if (!have_sub) {
+        return false;
+    }
+    if (keyframe_due || (now - last_keyframe) >= UPLINK_KEYFRAME_MS) {
+        buildKeyframe(msg);
+        last_keyframe = now;
+    } else if (dirty != 0 && (now - first_dirty) >= UPLINK_BATCH_MS) {
+        buildDelta(msg);
+    } else {
+        return false;
+    }
+    sent_bytes += msg.length();
+    return true;
+}
+
+/**
+ * @brief 全量快照实现
+ */
+void StatusUplink::buildKeyframe(String &msg)
+{
+    uint8_t buf[2 + 2 * UPLINK_SLAVES];
+    uint8_t n = 0;
+    buf[n++] = seq++;
+    buf[n++] = 0;
+    for (uint8_t i = 0; i < UPLINK_SLAVES; i++) {
+        if (!slots[i].used) break;//槽位按顺序分配，遇到空闲即结束
+        buf[n++] = slots[i].addr;
+        buf[n++] = slots[i].value;
+        slots[i].published = slots[i].value;
+        buf[1]++;
+    }
+    msg = UPLINK_KEY_TAG;
+    msg.concat((const char *)buf, n);
+    dirty = 0;
+    keyframe_due = false;
+}
+
+/**
+ * @brief 增量实现：位图+变化槽位的新值
+ */
+void StatusUplink::buildDelta(String &msg)
+{
+    uint8_t buf[3 + UPLINK_SLAVES];
+    uint8_t n = 0;
+    buf[n++] = seq++;
+    buf[n++] = dirty & 0xFF;
+    buf[n++] = dirty >> 8;
+    for (uint8_t i = 0; i < UPLINK_SLAVES; i++) {
+        if (dirty & (1U << i)) {
+            buf[n++] = slots[i].value;
+            slots[i].published = slots[i].value;
+        }
+    }
+    msg = UPLINK_DELTA_TAG;
+    msg.concat((const char *)buf, n);
+    dirty = 0;
+}
+
+/**
+ * @brief 添加订阅节点实现，表满时忽略
+ */
+void StatusUplink::subscribe(uint32_t nodeId)
+{
+    int8_t free_slot = -1;
+    for (uint8_t i = 0; i < UPLINK_SUBSCRIBERS; i++) {
+        if (subscribers[i] == nodeId) {
+            free_slot = i;
+            break;
+        }
+        if (subscribers[i] == 0 && free_slot < 0) free_slot = i;
+    }
+    if (free_slot < 0) return;
+    subscribers[free_slot] = nodeId;
+    keyframe_due = true;
+}
+
+void StatusUplink::unsubscribe(uint32_t nodeId)
+{
+    for (uint8_t i = 0; i < UPLINK_SUBSCRIBERS; i++) {
+        if (subscribers[i] == nodeId) subscribers[i] = 0;
+    }
+}
+
+uint8_t StatusUplink::getSubscribers(uint32_t *out) const
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < UPLINK_SUBSCRIBERS; i++) {
+        if (subscribers[i] != 0) out[n++] = subscribers[i];
+    }
+    return n;
+}
@@ -0,0 +1,98 @@
+/* USER CODE BEGIN Header */
+/**
+ ******************************************************************************
+ * @file           : uplink.hpp
+ * @brief          : Header for uplink.cpp file.
+ *                   This file contains the common defines of the application.
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024.12.10 STMicroelectronics.
+ * All rights reserved.
+ *
+ ******************************************************************************
+ */
+/* USER CODE END Header */
+#ifndef UPLINK_HPP
+#define UPLINK_HPP
+
+#include <Arduino.h>
+
+#define UPLINK_SLAVES 16            ///< 快照中的从机槽位数（增量位图为2字节）
+#define UPLINK_SUBSCRIBERS 4        ///< 订阅节点数
+#define UPLINK_BATCH_MS 100         ///< 首个变化出现后最多等待多久合并发送（毫秒）
+#define UPLINK_KEYFRAME_MS 10000    ///< 全量快照周期（毫秒）
+#define UPLINK_NAIVE_BYTES 13       ///< 逐帧转发时每帧的mesh负载字节数，用于统计节省比例
+#define UPLINK_SUB_TAG "UPL_SUB"    ///< 订阅请求，网关随后发送一次全量快照
+#define UPLINK_UNSUB_TAG "UPL_UNSUB" ///< 取消订阅
+#define UPLINK_KEY_TAG "UPK"        ///< 全量快照："UPK" 序号 槽位数 [addr 状态]...（按槽位顺序）
+#define UPLINK_DELTA_TAG "UPD"      ///< 增量："UPD" 序号 位图(2，小端) [状态]...（位图中置位的槽位）
+
+/**
+ * @brief 从机状态变化上行
+ * @details 串口解码出的状态先写入快照，只有与上次发布值不同的槽位才标记为变化；
+ *          首个变化出现后等待UPLINK_BATCH_MS，把窗口内所有从机的变化合并为一条增量消息。
+ *          增量消息只含变化槽位的位图和新值，槽位与地址的对应关系由全量快照给出；
+ *          全量快照周期发送，新增从机或新订阅节点时立即发送，订阅者发现序号不连续时等待下一个快照即可重新同步。
+ */
+class StatusUplink {
+public:
+    StatusUplink();
+    ~StatusUplink();
+
+    /**
+     * @brief 写入从机状态（未变化时只计数，不产生消息）
+     */
+    void update(uint8_t addr, uint8_t sta, uint32_t now);
+
+    /**
+     * @brief 生成待发送消息
+     * @param now 当前时间（毫秒）
+     * @param msg 输出消息
+     * @return 有消息需要发给所有订阅者时返回true
+     */
+    bool poll(uint32_t now, String &msg);
+
+    void subscribe(uint32_t nodeId);    ///< 添加订阅节点并安排一次全量快照
+    void unsubscribe(uint32_t nodeId);  ///< 移除订阅节点
+
+    /**
+     * @brief 获取订阅节点
+     * @param out 输出数组，至少UPLINK_SUBSCRIBERS个
+     * @return 订阅节点数
+     */
+    uint8_t getSubscribers(uint32_t *out) const;
+
+    uint32_t getUpdates() const { return updates; }     ///< 收到的状态帧数
+    uint32_t getSuppressed() const { return suppressed; } ///< 未变化而被抑制的状态帧数
+    uint32_t getSentBytes() const { return sent_bytes; }  ///< 已发布的消息字节数（每订阅者）
+    uint32_t getNaiveBytes() const { return updates * UPLINK_NAIVE_BYTES; } ///< 逐帧转发需要的字节数
+
+    static StatusUplink *getInstance() { return instance; }
+
+private:
+    struct Slot {
+        uint8_t addr;
+        uint8_t value;      ///< 最新值
+        uint8_t published;  ///< 订阅者持有的值
+        bool used;
+    };
+
+    Slot slots[UPLINK_SLAVES];
+    uint32_t subscribers[UPLINK_SUBSCRIBERS];
+    uint16_t dirty;         ///< 待发布的槽位位图
+    bool keyframe_due;
+    uint8_t seq;
+    uint32_t first_dirty;   ///< 首个未发布变化出现的时间
+    uint32_t last_keyframe;
+    uint32_t updates;
+    uint32_t suppressed;
+    uint32_t sent_bytes;
+
+    static StatusUplink *instance;
+
+    void buildKeyframe(String &msg);
+    void buildDelta(String &msg);
+};
+
+#endif // UPLINK_HPP
@@ -1,6 +1,10 @@
 #include "src/app/app.hpp"
 
 APP app;
+
+// 管理节点ID：只有这些控制节点发来的管理消息（TRACE_START/TRACE_STOP流量记录、GRP组配置）被接受，
+// 0表示空位；全为0时这些功能不可用。也可以在编译参数中用-DMESH_ADMIN_NODE=<节点ID>指定一个
+static const uint32_t ADMIN_NODES[] = {0};
 /**
  * @brief 串口接收事件处理函数
  * @details 当串口接收到数据时，会调用此函数
@@ -13,6 +17,11 @@ void serialEvent()
 
 void setup() {
   // put your setup code here, to run once:
+  for (uint32_t id : ADMIN_NODES) {
+    if (id != 0) {
+      app.addAdmin(id);
+    }
+  }
   app.begin();
 }
 